@@ -25,6 +25,7 @@
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
 #include <stdio.h>
+#include <string.h>
 #include "main.h"
 /* USER CODE END Includes */
 
@@ -40,7 +41,61 @@
 #define FX_APP_THREAD_PRIO               10
 
 /* USER CODE BEGIN PD */
+/* FAT volume labels are 11 characters */
+#define FX_APP_VOLUME_LABEL_SIZE         11
 
+#if (LX_STM32_OSPI_STRIPE == 1)
+/* The media is striped over both OctoSPI memories */
+#define FX_APP_NOR_DRIVER_ID             LX_NOR_OSPI_STRIPE_DRIVER_ID
+#define FX_APP_NOR_FLASH_SIZE            (2 * LX_STM32_OSPI_FLASH_SIZE)
+#elif (LX_STM32_OSPI_SCHED == 1)
+/* LevelX shares the memory with raw clients through the flash I/O scheduler */
+#define FX_APP_NOR_DRIVER_ID             LX_NOR_OSPI_SCHED_DRIVER_ID
+#define FX_APP_NOR_FLASH_SIZE            LX_STM32_OSPI_FLASH_SIZE
+#else
+#define FX_APP_NOR_DRIVER_ID             LX_NOR_OSPI_DRIVER_ID
+#define FX_APP_NOR_FLASH_SIZE            LX_STM32_OSPI_FLASH_SIZE
+#endif
+
+/* LevelX sectors a Write_FxShared() slice may consume: its data, a partial sector at each end,
+ * and the FAT and directory sectors it updates.
+ */
+#define FX_APP_SLICE_SECTORS             ((FX_APP_WRITE_SLICE / (LX_NOR_SECTOR_SIZE * sizeof(ULONG))) + 4)
+
+#if (FX_APP_PREERASE == 1)
+/* Pre-erase service thread, below the FileX users */
+#define FX_APP_PREERASE_STACK_SIZE       1024
+#define FX_APP_PREERASE_THREAD_PRIO      (FX_APP_THREAD_PRIO + 1)
+#endif
+
+#if (FX_APP_XCACHE_TUNE == 1)
+/* Extended cache tuner thread, below the FileX users */
+#define FX_APP_XCACHE_STACK_SIZE         1024
+#define FX_APP_XCACHE_THREAD_PRIO        (FX_APP_THREAD_PRIO + 1)
+/* The extended cache holds whole LevelX sectors */
+#define FX_APP_XCACHE_SECTOR_BYTES       (LX_NOR_SECTOR_SIZE * sizeof(ULONG))
+/* Largest cache, plus the byte pool overhead */
+#define FX_APP_XCACHE_POOL_SIZE          ((LX_NOR_EXTENDED_CACHE_SIZE * FX_APP_XCACHE_SECTOR_BYTES) + 64)
+#endif
+
+#if (FX_APP_BENCHMARK == 1)
+/* Load thread counting the CPU time left to lower priority threads during the benchmarks */
+#define FX_APP_BENCH_LOAD_STACK_SIZE     512
+#define FX_APP_BENCH_LOAD_THREAD_PRIO    (FX_APP_THREAD_PRIO + 2)
+/* Duration of the load thread calibration, without any flash activity */
+#define FX_APP_BENCH_CALIBRATION_MS      200
+/* fx_file_write latency histogram: FX_APP_BENCH_LATENCY_BUCKETS buckets of FX_APP_BENCH_LATENCY_STEP_US */
+#define FX_APP_BENCH_LATENCY_BUCKETS     64
+#define FX_APP_BENCH_LATENCY_STEP_US     250
+/* Writer thread of the read/write benchmark, below the reader */
+#define FX_APP_BENCH_WRITER_STACK_SIZE   (1024*2)
+#define FX_APP_BENCH_WRITER_THREAD_PRIO  (FX_APP_THREAD_PRIO + 1)
+#if (LX_STM32_OSPI_SCHED == 1)
+/* Raw reader thread of the mixed workload benchmark, above the FileX logger */
+#define FX_APP_BENCH_READER_STACK_SIZE   1024
+#define FX_APP_BENCH_READER_THREAD_PRIO  (FX_APP_THREAD_PRIO - 1)
+#endif
+#endif
 /* USER CODE END PD */
 
 /* Private macro -------------------------------------------------------------*/
@@ -59,6 +114,51 @@ FX_MEDIA        nor_ospi_flash_disk;
 
 /* USER CODE BEGIN PV */
 FX_FILE         fx_file;
+#if (FX_APP_MEDIA_CHECK == 1)
+ULONG           fx_app_check_memory[FX_APP_MEDIA_CHECK_MEMORY_SIZE / sizeof(ULONG)];
+#endif
+#if (FX_APP_PREERASE == 1)
+TX_THREAD       preerase_thread;
+ULONG           preerase_reclaims;
+/* set by the application to stop the service, and by the service once suspended out of the media mutex */
+volatile UINT   preerase_stop;
+volatile UINT   preerase_stopped;
+#endif
+#if (FX_APP_XCACHE_TUNE == 1)
+TX_THREAD       xcache_thread;
+TX_BYTE_POOL    xcache_pool;
+ULONG           xcache_pool_memory[FX_APP_XCACHE_POOL_SIZE / sizeof(ULONG)];
+VOID           *xcache_memory;
+ULONG           xcache_sectors;
+ULONG           xcache_resizes;
+/* set by the application to stop the tuner, and by the tuner once suspended out of the media mutex */
+volatile UINT   xcache_stop;
+volatile UINT   xcache_stopped;
+#endif
+#if (FX_APP_BENCHMARK == 1)
+UCHAR           bench_buffer[FX_APP_BENCH_CHUNK_SIZE];
+/* largest read of the read latency benchmark */
+ULONG           bench_read_buffer[(64 * 1024) / sizeof(ULONG)];
+TX_THREAD       bench_load_thread;
+volatile ULONG  bench_load_count;
+ULONG           bench_latency[FX_APP_BENCH_LATENCY_BUCKETS];
+TX_THREAD       bench_writer_thread;
+FX_FILE         bench_writer_file;
+UCHAR           bench_writer_buffer[FX_APP_WRITE_SLICE];
+ULONG           bench_writer_bytes;
+UINT            bench_writer_status;
+/* set by the benchmark to stop the writer, and by the writer once suspended out of the media mutex */
+volatile UINT   bench_writer_stop;
+volatile UINT   bench_writer_stopped;
+#if (LX_STM32_OSPI_SCHED == 1)
+TX_THREAD       bench_reader_thread;
+ULONG           bench_reader_buffer[FX_NOR_OSPI_SECTOR_SIZE / sizeof(ULONG)];
+ULONG           bench_reader_reads;
+volatile ULONG  bench_reader_count;
+volatile UINT   bench_reader_done;
+INT             bench_reader_status;
+#endif
+#endif
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
@@ -66,8 +166,41 @@ FX_FILE         fx_file;
 void fx_app_thread_entry(ULONG thread_input);
 
 /* USER CODE BEGIN PFP */
+VOID fx_app_nor_driver(FX_MEDIA *media_ptr);
+UINT Mount_FxMedia(UINT format, UINT *formatted);
+UINT Validate_FxMedia(void);
 UINT Create_FxFile(CHAR* file_name, VOID* buffer_ptr, ULONG size);
 UINT Read_FxFile(CHAR* file_name, VOID* buffer_ptr, ULONG size);
+UINT Write_FxShared(FX_FILE *file, UCHAR *buffer, ULONG size);
+UINT Reclaim_FxShared(void);
+#if (FX_APP_PREERASE == 1)
+void preerase_thread_entry(ULONG thread_input);
+#endif
+
+#if (FX_APP_XCACHE_TUNE == 1)
+void xcache_thread_entry(ULONG thread_input);
+UINT Resize_FxExtendedCache(ULONG sectors);
+void Print_FxCacheStats(void);
+#endif
+
+#if (FX_APP_BENCHMARK == 1)
+void bench_load_thread_entry(ULONG thread_input);
+ULONG Bench_LoadCalibrate(void);
+UINT Bench_FxWrite(CHAR* file_name, ULONG file_size, ULONG chunk_size, ULONG passes);
+UINT Bench_FxSmallFiles(ULONG count, ULONG size);
+UINT Bench_ReadLatency(ULONG iterations);
+UINT Bench_FxRandomRead(CHAR* file_name, ULONG file_size, ULONG reads);
+void bench_writer_thread_entry(ULONG thread_input);
+UINT Bench_FxReadUnderWrite(CHAR* file_name, ULONG file_size, ULONG reads);
+void Bench_LatencyRecord(ULONG cycles);
+ULONG Bench_LatencyPercentile(ULONG percent);
+void Bench_DumpOpStats(void);
+#if (LX_STM32_OSPI_SCHED == 1)
+void bench_reader_thread_entry(ULONG thread_input);
+UINT Bench_SchedMixed(CHAR* file_name, ULONG file_size, ULONG reads);
+ULONG Bench_OpPercentile(LX_STM32_OSPI_OP_STATS *op_stats, ULONG percent);
+#endif
+#endif
 /* USER CODE END PFP */
 
 /**
@@ -109,7 +242,95 @@ UINT MX_FileX_Init(VOID *memory_ptr)
     return TX_THREAD_ERROR;
   }
   /* USER CODE BEGIN MX_FileX_Init */
+#if (FX_APP_PREERASE == 1)
+  /* Allocate memory for the pre-erase service thread's stack */
+  ret = tx_byte_allocate(byte_pool, &pointer, FX_APP_PREERASE_STACK_SIZE, TX_NO_WAIT);
+  if (ret != FX_SUCCESS)
+  {
+    return TX_POOL_ERROR;
+  }
+
+  /* Created suspended, it is resumed once the media is open */
+  ret = tx_thread_create(&preerase_thread, "FileX pre-erase thread", preerase_thread_entry, 0, pointer, FX_APP_PREERASE_STACK_SIZE,
+                         FX_APP_PREERASE_THREAD_PRIO, FX_APP_PREERASE_THREAD_PRIO, TX_NO_TIME_SLICE, TX_DONT_START);
+  if (ret != FX_SUCCESS)
+  {
+    return TX_THREAD_ERROR;
+  }
+#endif
+
+#if (FX_APP_XCACHE_TUNE == 1)
+  /* The cache buffers come from their own pool, the application pool only holds the stacks */
+  ret = tx_byte_pool_create(&xcache_pool, "FileX extended cache pool", xcache_pool_memory, sizeof(xcache_pool_memory));
+  if (ret != FX_SUCCESS)
+  {
+    return TX_POOL_ERROR;
+  }
+
+  /* Allocate memory for the tuner thread's stack */
+  ret = tx_byte_allocate(byte_pool, &pointer, FX_APP_XCACHE_STACK_SIZE, TX_NO_WAIT);
+  if (ret != FX_SUCCESS)
+  {
+    return TX_POOL_ERROR;
+  }
+
+  /* Created suspended, it is resumed once the media is open */
+  ret = tx_thread_create(&xcache_thread, "FileX cache tuner thread", xcache_thread_entry, 0, pointer, FX_APP_XCACHE_STACK_SIZE,
+                         FX_APP_XCACHE_THREAD_PRIO, FX_APP_XCACHE_THREAD_PRIO, TX_NO_TIME_SLICE, TX_DONT_START);
+  if (ret != FX_SUCCESS)
+  {
+    return TX_THREAD_ERROR;
+  }
+#endif
+
+#if (FX_APP_BENCHMARK == 1)
+  /* Allocate memory for the load thread's stack */
+  ret = tx_byte_allocate(byte_pool, &pointer, FX_APP_BENCH_LOAD_STACK_SIZE, TX_NO_WAIT);
+  if (ret != FX_SUCCESS)
+  {
+    return TX_POOL_ERROR;
+  }
+
+  /* Created suspended, it is only resumed while a benchmark runs */
+  ret = tx_thread_create(&bench_load_thread, "FileX bench load thread", bench_load_thread_entry, 0, pointer, FX_APP_BENCH_LOAD_STACK_SIZE,
+                         FX_APP_BENCH_LOAD_THREAD_PRIO, FX_APP_BENCH_LOAD_THREAD_PRIO, TX_NO_TIME_SLICE, TX_DONT_START);
+  if (ret != FX_SUCCESS)
+  {
+    return TX_THREAD_ERROR;
+  }
+
+  /* Allocate memory for the writer thread's stack */
+  ret = tx_byte_allocate(byte_pool, &pointer, FX_APP_BENCH_WRITER_STACK_SIZE, TX_NO_WAIT);
+  if (ret != FX_SUCCESS)
+  {
+    return TX_POOL_ERROR;
+  }
+
+  /* Created suspended, it is only resumed while the read/write benchmark runs */
+  ret = tx_thread_create(&bench_writer_thread, "FileX bench writer thread", bench_writer_thread_entry, 0, pointer, FX_APP_BENCH_WRITER_STACK_SIZE,
+                         FX_APP_BENCH_WRITER_THREAD_PRIO, FX_APP_BENCH_WRITER_THREAD_PRIO, TX_NO_TIME_SLICE, TX_DONT_START);
+  if (ret != FX_SUCCESS)
+  {
+    return TX_THREAD_ERROR;
+  }
+
+#if (LX_STM32_OSPI_SCHED == 1)
+  /* Allocate memory for the raw reader thread's stack */
+  ret = tx_byte_allocate(byte_pool, &pointer, FX_APP_BENCH_READER_STACK_SIZE, TX_NO_WAIT);
+  if (ret != FX_SUCCESS)
+  {
+    return TX_POOL_ERROR;
+  }
 
+  /* Created suspended, it is only resumed while the mixed workload benchmark runs */
+  ret = tx_thread_create(&bench_reader_thread, "FileX bench reader thread", bench_reader_thread_entry, 0, pointer, FX_APP_BENCH_READER_STACK_SIZE,
+                         FX_APP_BENCH_READER_THREAD_PRIO, FX_APP_BENCH_READER_THREAD_PRIO, TX_NO_TIME_SLICE, TX_DONT_START);
+  if (ret != FX_SUCCESS)
+  {
+    return TX_THREAD_ERROR;
+  }
+#endif
+#endif
   /* USER CODE END MX_FileX_Init */
 
   /* Initialize FileX.  */
@@ -133,40 +354,21 @@ void fx_app_thread_entry(ULONG thread_input)
   /* USER CODE BEGIN fx_app_thread_entry 0 */
   ULONG available_space_pre;
   ULONG available_space_post;
+  UINT i;
   CHAR read_buffer[32];
   CHAR data[] = "This is FileX working on STM32";
+  UINT formatted;
+  ULONG boot_ticks = tx_time_get();
+  ULONG volume_size;
+  LX_STM32_OSPI_TRANSFER_STATS boot_stats;
 
   printf("FileX/LevelX NOR OCTO-SPI Application Start.\r\n");
-  printf("Total NOR Flash Chip size is: %lu bytes.\r\n", (unsigned long)MX25R6435F_FLASH_SIZE);
+  printf("Total NOR Flash Chip size is: %lu bytes.\r\n", (unsigned long)FX_APP_NOR_FLASH_SIZE);
 
   /* USER CODE END fx_app_thread_entry 0 */
 
-  /* Format the OCTO-SPI NOR flash as FAT */
-  nor_ospi_status =  fx_media_format(&nor_ospi_flash_disk,                               // nor_ospi_flash_disk pointer
-                                     fx_stm32_levelx_nor_driver,                         // Driver entry
-                                     (VOID *)LX_NOR_OSPI_DRIVER_ID,                      // Device info pointer
-                                     (UCHAR *) fx_nor_ospi_media_memory,                 // Media buffer pointer
-                                     sizeof(fx_nor_ospi_media_memory),                   // Media buffer size
-                                     FX_NOR_OSPI_VOLUME_NAME,                            // Volume Name
-                                     FX_NOR_OSPI_NUMBER_OF_FATS,                         // Number of FATs
-                                     32,                                                 // Directory Entries
-                                     FX_NOR_OSPI_HIDDEN_SECTORS,                         // Hidden sectors
-                                     LX_STM32_OSPI_FLASH_SIZE / FX_NOR_OSPI_SECTOR_SIZE, // Total sectors
-                                     FX_NOR_OSPI_SECTOR_SIZE,                            // Sector size
-                                     8,                                                  // Sectors per cluster
-                                     1,                                                  // Heads
-                                     1);                                                 // Sectors per track
-
-  /* Check the format nor_ospi_status */
-  if (nor_ospi_status != FX_SUCCESS)
-  {
-    /* USER CODE BEGIN OCTO-SPI NOR format error */
-    while(1);
-    /* USER CODE END OCTO-SPI NOR format error */
-  }
-
-  /* Open the OCTO-SPI NOR driver */
-  nor_ospi_status =  fx_media_open(&nor_ospi_flash_disk, FX_NOR_OSPI_VOLUME_NAME, fx_stm32_levelx_nor_driver, (VOID *)LX_NOR_OSPI_DRIVER_ID, (VOID *) fx_nor_ospi_media_memory, sizeof(fx_nor_ospi_media_memory));
+  /* Open the OCTO-SPI NOR flash, it is only formatted if it doesn't hold a valid volume */
+  nor_ospi_status = Mount_FxMedia(FX_APP_FORMAT_ON_BOOT, &formatted);
 
   /* Check the media open nor_ospi_status */
   if (nor_ospi_status != FX_SUCCESS)
@@ -177,6 +379,16 @@ void fx_app_thread_entry(ULONG thread_input)
   }
 
   /* USER CODE BEGIN fx_app_thread_entry 1 */
+#if (FX_APP_PREERASE == 1)
+  tx_thread_resume(&preerase_thread);
+#endif
+#if (FX_APP_XCACHE_TUNE == 1)
+  if (Resize_FxExtendedCache(FX_APP_XCACHE_MIN_SECTORS) != LX_SUCCESS)
+  {
+	  Error_Handler();
+  }
+  tx_thread_resume(&xcache_thread);
+#endif
 
   /* Get the available usable space */
   nor_ospi_status =  fx_media_space_available(&nor_ospi_flash_disk, &available_space_pre);
@@ -186,6 +398,18 @@ void fx_app_thread_entry(ULONG thread_input)
   }
   printf("User available NOR Flash disk space size before file is written: %lu bytes.\r\n", available_space_pre);
 
+  /* Boot to ready time, depends on the volume fill level through the LevelX open scan */
+  volume_size = nor_ospi_flash_disk.fx_media_total_clusters * nor_ospi_flash_disk.fx_media_bytes_per_sector * nor_ospi_flash_disk.fx_media_sectors_per_cluster;
+  printf("Media %s and ready in %lu ms, volume %lu%% full.\r\n", formatted ? "formatted" : "opened",
+         ((tx_time_get() - boot_ticks) * 1000) / TX_TIMER_TICKS_PER_SECOND,
+         ((volume_size - available_space_pre) / (volume_size / 100)));
+  lx_stm32_ospi_get_transfer_stats(LX_STM32_OSPI_INSTANCE, &boot_stats);
+  printf("  Flash init in %lu us, %lu of 2 status register writes skipped.\r\n",
+         boot_stats.init_cycles / (SystemCoreClock / 1000000), boot_stats.init_status_writes_saved);
+#if (LX_STM32_OSPI_CHECKPOINT == 1)
+  printf("  %lu reads served by the LevelX open checkpoint.\r\n", boot_stats.checkpoint_hits);
+#endif
+
   nor_ospi_status = Create_FxFile("STM32.TXT", data, sizeof(data));
   if (nor_ospi_status != FX_SUCCESS)
   {
@@ -199,6 +423,46 @@ void fx_app_thread_entry(ULONG thread_input)
   }
   printf("Read File data: %s\r\n", read_buffer);
 
+#if (FX_APP_BENCHMARK == 1)
+  nor_ospi_status = Bench_FxWrite("BENCH.BIN", FX_APP_BENCH_FILE_SIZE, FX_APP_BENCH_CHUNK_SIZE, FX_APP_BENCH_PASSES);
+  if (nor_ospi_status != FX_SUCCESS)
+  {
+	  Error_Handler();
+  }
+
+  nor_ospi_status = Bench_FxSmallFiles(FX_APP_BENCH_SMALL_FILES, FX_APP_BENCH_SMALL_FILE_SIZE);
+  if (nor_ospi_status != FX_SUCCESS)
+  {
+	  Error_Handler();
+  }
+
+  nor_ospi_status = Bench_ReadLatency(FX_APP_BENCH_READ_ITERATIONS);
+  if (nor_ospi_status != FX_SUCCESS)
+  {
+	  Error_Handler();
+  }
+
+  nor_ospi_status = Bench_FxRandomRead("BENCH.BIN", FX_APP_BENCH_FILE_SIZE, FX_APP_BENCH_RANDOM_READS);
+  if (nor_ospi_status != FX_SUCCESS)
+  {
+	  Error_Handler();
+  }
+
+  nor_ospi_status = Bench_FxReadUnderWrite("BENCH.BIN", FX_APP_BENCH_FILE_SIZE, FX_APP_BENCH_RW_READS);
+  if (nor_ospi_status != FX_SUCCESS)
+  {
+	  Error_Handler();
+  }
+
+#if (LX_STM32_OSPI_SCHED == 1)
+  nor_ospi_status = Bench_SchedMixed("LOGGER.BIN", FX_APP_BENCH_FILE_SIZE, FX_APP_BENCH_MIXED_READS);
+  if (nor_ospi_status != FX_SUCCESS)
+  {
+	  Error_Handler();
+  }
+#endif
+#endif
+
   /* Get the available usable space, after the file has been created */
   nor_ospi_status =  fx_media_space_available(&nor_ospi_flash_disk, &available_space_post);
   if (nor_ospi_status != FX_SUCCESS)
@@ -212,6 +476,26 @@ void fx_app_thread_entry(ULONG thread_input)
          nor_ospi_flash_disk.fx_media_bytes_per_sector * nor_ospi_flash_disk.fx_media_sectors_per_cluster);
 
 
+#if (FX_APP_PREERASE == 1)
+  /* Stop the pre-erase service, it suspends itself out of the media mutex: suspended from here,
+   * it could be waiting for the mutex and would keep it once handed over.
+   */
+  preerase_stop = 1;
+  while (preerase_stopped == 0)
+  {
+	  tx_thread_sleep(1);
+  }
+#endif
+#if (FX_APP_XCACHE_TUNE == 1)
+  /* Stop the cache tuner, it suspends itself out of a resize, and report the cache efficiency */
+  xcache_stop = 1;
+  while (xcache_stopped == 0)
+  {
+	  tx_thread_sleep(1);
+  }
+  Print_FxCacheStats();
+#endif
+
   /* Close the media.  */
   nor_ospi_status =  fx_media_close(&nor_ospi_flash_disk);
   if (nor_ospi_status != FX_SUCCESS)
@@ -219,6 +503,17 @@ void fx_app_thread_entry(ULONG thread_input)
 	  Error_Handler();
   }
 
+  /* Program the last LevelX writes kept in RAM by the OSPI write coalescing
+   * and save the checkpoint of the LevelX open.
+   */
+  for (i = 0; i < LX_STM32_OSPI_INSTANCE_COUNT; i++)
+  {
+	  if (lx_stm32_ospi_lowlevel_deinit(i) != 0)
+	  {
+		  Error_Handler();
+	  }
+  }
+
   while(1)
   {
 	  HAL_GPIO_TogglePin(LED2_GPIO_Port, LED2_Pin);
@@ -229,6 +524,148 @@ void fx_app_thread_entry(ULONG thread_input)
 }
 
 /* USER CODE BEGIN 1 */
+/**
+  * @brief  FileX driver of the NOR flash media: the LevelX NOR driver, followed on a FileX flush by the
+  *         program of the pages the OSPI write coalescing keeps in RAM. fx_media_flush and fx_media_close
+  *         then leave nothing to lose in RAM.
+  * @param  media_ptr: the media of the request
+  * @retval None
+  */
+VOID fx_app_nor_driver(FX_MEDIA *media_ptr)
+{
+#if (LX_STM32_OSPI_WRITE_COALESCE == 1) && (LX_STM32_OSPI_SCHED == 0)
+	UINT i;
+#endif
+
+	fx_stm32_levelx_nor_driver(media_ptr);
+
+#if (LX_STM32_OSPI_WRITE_COALESCE == 1)
+	if ((media_ptr->fx_media_driver_request != FX_DRIVER_FLUSH) || (media_ptr->fx_media_driver_status != FX_SUCCESS))
+	{
+		return;
+	}
+
+#if (LX_STM32_OSPI_SCHED == 1)
+	/* The instance is only driven by the scheduler thread */
+	if (lx_stm32_ospi_sched_io(LX_STM32_OSPI_SCHED_FLUSH, NULL, NULL, 0, 0) != 0)
+	{
+		media_ptr->fx_media_driver_status = FX_IO_ERROR;
+	}
+#else
+	for (i = 0; i < LX_STM32_OSPI_INSTANCE_COUNT; i++)
+	{
+		if (lx_stm32_ospi_flush(i) != 0)
+		{
+			media_ptr->fx_media_driver_status = FX_IO_ERROR;
+		}
+	}
+#endif
+#endif
+}
+
+/**
+  * @brief  Open the NOR flash media, formatting it only if requested or if no valid volume is found.
+  *         Any other error, such as FX_IO_ERROR, is returned without touching the media.
+  * @param  format: 1 to format the media whatever it holds
+  * @param  formatted: set to 1 if the media has been formatted
+  * @retval FX status
+  */
+UINT Mount_FxMedia(UINT format, UINT *formatted)
+{
+	UINT nor_ospi_status = FX_SUCCESS;
+
+	*formatted = 0;
+
+	if (format == 0)
+	{
+		nor_ospi_status =  fx_media_open(&nor_ospi_flash_disk, FX_NOR_OSPI_VOLUME_NAME, fx_app_nor_driver, (VOID *)FX_APP_NOR_DRIVER_ID, (VOID *) fx_nor_ospi_media_memory, sizeof(fx_nor_ospi_media_memory));
+		if (nor_ospi_status == FX_SUCCESS)
+		{
+			nor_ospi_status = Validate_FxMedia();
+			if (nor_ospi_status == FX_SUCCESS)
+			{
+				return FX_SUCCESS;
+			}
+
+			fx_media_close(&nor_ospi_flash_disk);
+		}
+
+		/* Only a missing or unreadable volume is formatted, a driver or media check error
+		 * would otherwise erase the user data: it is returned to the caller.
+		 */
+		if ((nor_ospi_status != FX_MEDIA_INVALID) && (nor_ospi_status != FX_BOOT_ERROR) && (nor_ospi_status != FX_FAT_READ_ERROR))
+		{
+			printf("NOR flash volume can't be opened (status 0x%02X).\r\n", nor_ospi_status);
+			return nor_ospi_status;
+		}
+
+		printf("No valid volume in NOR flash (status 0x%02X), formatting it.\r\n", nor_ospi_status);
+	}
+
+	/* Format the OCTO-SPI NOR flash as FAT */
+	nor_ospi_status =  fx_media_format(&nor_ospi_flash_disk,                               // nor_ospi_flash_disk pointer
+	                                   fx_app_nor_driver,                                  // Driver entry
+	                                   (VOID *)FX_APP_NOR_DRIVER_ID,                       // Device info pointer
+	                                   (UCHAR *) fx_nor_ospi_media_memory,                 // Media buffer pointer
+	                                   sizeof(fx_nor_ospi_media_memory),                   // Media buffer size
+	                                   FX_NOR_OSPI_VOLUME_NAME,                            // Volume Name
+	                                   FX_NOR_OSPI_NUMBER_OF_FATS,                         // Number of FATs
+	                                   32,                                                 // Directory Entries
+	                                   FX_NOR_OSPI_HIDDEN_SECTORS,                         // Hidden sectors
+	                                   FX_APP_NOR_FLASH_SIZE / FX_NOR_OSPI_SECTOR_SIZE,    // Total sectors
+	                                   FX_NOR_OSPI_SECTOR_SIZE,                            // Sector size
+	                                   8,                                                  // Sectors per cluster
+	                                   1,                                                  // Heads
+	                                   1);                                                 // Sectors per track
+	if (nor_ospi_status != FX_SUCCESS)
+	{
+		return nor_ospi_status;
+	}
+
+	*formatted = 1;
+
+	/* Open the OCTO-SPI NOR driver */
+	return fx_media_open(&nor_ospi_flash_disk, FX_NOR_OSPI_VOLUME_NAME, fx_app_nor_driver, (VOID *)FX_APP_NOR_DRIVER_ID, (VOID *) fx_nor_ospi_media_memory, sizeof(fx_nor_ospi_media_memory));
+}
+
+/**
+  * @brief  Check that the opened media holds the volume this application formats.
+  * @retval FX status, FX_MEDIA_INVALID if the volume has another geometry or label
+  */
+UINT Validate_FxMedia(void)
+{
+	UINT nor_ospi_status = FX_SUCCESS;
+	CHAR volume_name[FX_APP_VOLUME_LABEL_SIZE + 1];
+#if (FX_APP_MEDIA_CHECK == 1)
+	ULONG errors_detected = 0;
+#endif
+
+	nor_ospi_status = fx_media_volume_get(&nor_ospi_flash_disk, volume_name, FX_BOOT_SECTOR);
+	if (nor_ospi_status != FX_SUCCESS)
+	{
+		return nor_ospi_status;
+	}
+
+	if ((strncmp(volume_name, FX_NOR_OSPI_VOLUME_NAME, FX_APP_VOLUME_LABEL_SIZE) != 0) ||
+	    (nor_ospi_flash_disk.fx_media_bytes_per_sector != FX_NOR_OSPI_SECTOR_SIZE) ||
+	    (nor_ospi_flash_disk.fx_media_total_sectors != (FX_APP_NOR_FLASH_SIZE / FX_NOR_OSPI_SECTOR_SIZE)))
+	{
+		return FX_MEDIA_INVALID;
+	}
+
+#if (FX_APP_MEDIA_CHECK == 1)
+	/* Correct the FAT chains, the directories and the lost clusters, left by a power loss */
+	nor_ospi_status = fx_media_check(&nor_ospi_flash_disk, (UCHAR *) fx_app_check_memory, sizeof(fx_app_check_memory),
+	                                 FX_FAT_CHAIN_ERROR | FX_DIRECTORY_ERROR | FX_LOST_CLUSTER_ERROR, &errors_detected);
+	if ((nor_ospi_status == FX_SUCCESS) && (errors_detected != 0))
+	{
+		printf("fx_media_check corrected errors 0x%02lX.\r\n", errors_detected);
+	}
+#endif
+
+	return nor_ospi_status;
+}
+
 UINT Create_FxFile(CHAR* file_name, VOID* buffer_ptr, ULONG size)
 {
 	UINT nor_ospi_status = FX_SUCCESS;
@@ -319,4 +756,986 @@ READ_FILE_END:
 	return nor_ospi_status;
 }
 
+/**
+  * @brief  Write to a file in FX_APP_WRITE_SLICE slices, the media goes to the waiting readers between them.
+  *         The LevelX reclaims the slices need are done beforehand by Reclaim_FxShared(), not within a slice.
+  * @param  file: file opened for write
+  * @param  buffer: data to write
+  * @param  size: number of bytes to write
+  * @retval FX status
+  */
+UINT Write_FxShared(FX_FILE *file, UCHAR *buffer, ULONG size)
+{
+	UINT nor_ospi_status = FX_SUCCESS;
+	ULONG slice;
+
+	while (size != 0)
+	{
+		slice = (size < FX_APP_WRITE_SLICE) ? size : FX_APP_WRITE_SLICE;
+
+		nor_ospi_status = Reclaim_FxShared();
+		if (nor_ospi_status != FX_SUCCESS)
+		{
+			break;
+		}
+
+		/* Own the media across the slice, its release then hands it to the highest priority waiter
+		 * rather than to the first one, which may be another writer or the pre-erase service.
+		 */
+		tx_mutex_get(&nor_ospi_flash_disk.fx_media_protect, TX_WAIT_FOREVER);
+		nor_ospi_status =  fx_file_write(file, buffer, slice);
+		tx_mutex_prioritize(&nor_ospi_flash_disk.fx_media_protect);
+		tx_mutex_put(&nor_ospi_flash_disk.fx_media_protect);
+		if (nor_ospi_status != FX_SUCCESS)
+		{
+			break;
+		}
+
+		buffer += slice;
+		size -= slice;
+	}
+
+	return nor_ospi_status;
+}
+
+/**
+  * @brief  Reclaim LevelX blocks until a slice of Write_FxShared() can be written without a reclaim.
+  *         LevelX reclaims a block within a sector write once its free sectors fall to one block,
+  *         a reader would then wait for the whole reclaim. Here each block is reclaimed in a media
+  *         mutex ownership of its own, the waiting readers get the media between two blocks.
+  *         With LX_STM32_OSPI_DEFERRED_BUSY_WAIT the erase of the block even completes after the
+  *         release, the reads issued meanwhile suspend it.
+  * @retval FX status
+  */
+UINT Reclaim_FxShared(void)
+{
+	LX_NOR_FLASH *nor_flash = lx_stm32_ospi_nor_flash;
+	UINT status;
+
+	if (nor_flash == NULL)
+	{
+		return FX_SUCCESS;
+	}
+
+	while (1)
+	{
+		tx_mutex_get(&nor_ospi_flash_disk.fx_media_protect, TX_WAIT_FOREVER);
+
+		/* Room for the slice, or nothing to reclaim: LevelX then reports the full media on the write */
+		if ((nor_flash->lx_nor_flash_free_physical_sectors > (nor_flash->lx_nor_flash_physical_sectors_per_block + FX_APP_SLICE_SECTORS)) ||
+		    (nor_flash->lx_nor_flash_obsolete_physical_sectors == 0))
+		{
+			tx_mutex_put(&nor_ospi_flash_disk.fx_media_protect);
+			return FX_SUCCESS;
+		}
+
+		status = lx_nor_flash_partial_defragment(nor_flash, 1);
+
+		tx_mutex_prioritize(&nor_ospi_flash_disk.fx_media_protect);
+		tx_mutex_put(&nor_ospi_flash_disk.fx_media_protect);
+
+		if (status != LX_SUCCESS)
+		{
+			return FX_IO_ERROR;
+		}
+	}
+}
+
+#if (FX_APP_PREERASE == 1)
+/**
+  * @brief  Pre-erase service thread entry, reclaims the obsolete LevelX blocks while FileX is idle.
+  * @param thread_input: ULONG user argument used by the thread entry
+  * @retval none
+  */
+void preerase_thread_entry(ULONG thread_input)
+{
+	LX_NOR_FLASH *nor_flash;
+	ULONG free_blocks;
+
+	while(1)
+	{
+		if (preerase_stop != 0)
+		{
+			preerase_stopped = 1;
+			tx_thread_suspend(&preerase_thread);
+			continue;
+		}
+
+		tx_thread_sleep((FX_APP_PREERASE_PERIOD_MS * TX_TIMER_TICKS_PER_SECOND) / 1000);
+
+		nor_flash = lx_stm32_ospi_nor_flash;
+		if (nor_flash == NULL)
+		{
+			continue;
+		}
+
+		/* Reclaim one block per media mutex ownership, a FileX request waits for one reclaim at most.
+		 * The stop request is checked before each ownership.
+		 */
+		while ((preerase_stop == 0) && (tx_mutex_get(&nor_ospi_flash_disk.fx_media_protect, TX_WAIT_FOREVER) == TX_SUCCESS))
+		{
+			free_blocks = nor_flash->lx_nor_flash_free_physical_sectors / nor_flash->lx_nor_flash_physical_sectors_per_block;
+			if ((free_blocks >= FX_APP_PREERASE_POOL_BLOCKS) || (nor_flash->lx_nor_flash_obsolete_physical_sectors == 0))
+			{
+				tx_mutex_put(&nor_ospi_flash_disk.fx_media_protect);
+				break;
+			}
+
+			/* A failed reclaim is not retried before the next period */
+			if (lx_nor_flash_partial_defragment(nor_flash, 1) != LX_SUCCESS)
+			{
+				tx_mutex_put(&nor_ospi_flash_disk.fx_media_protect);
+				break;
+			}
+			preerase_reclaims++;
+
+			/* A waiting FileX user gets the media before this thread */
+			tx_mutex_prioritize(&nor_ospi_flash_disk.fx_media_protect);
+			tx_mutex_put(&nor_ospi_flash_disk.fx_media_protect);
+			tx_thread_relinquish();
+		}
+	}
+}
+#endif
+
+#if (FX_APP_XCACHE_TUNE == 1)
+/**
+  * @brief  Extended cache tuner thread entry, resizes the cache from the hit rate of each period.
+  * @param thread_input: ULONG user argument used by the thread entry
+  * @retval none
+  */
+void xcache_thread_entry(ULONG thread_input)
+{
+	LX_NOR_FLASH *nor_flash = lx_stm32_ospi_nor_flash;
+	ULONG hits, misses, rate, sectors;
+	ULONG last_hits = nor_flash->lx_nor_flash_extended_cache_hits;
+	ULONG last_misses = nor_flash->lx_nor_flash_extended_cache_misses;
+	ULONG rate_before_growth = 0;
+	ULONG held_rate = 0;
+	UINT grown = 0, held = 0, resized = 0;
+
+	while(1)
+	{
+		if (xcache_stop != 0)
+		{
+			xcache_stopped = 1;
+			tx_thread_suspend(&xcache_thread);
+			continue;
+		}
+
+		tx_thread_sleep((FX_APP_XCACHE_PERIOD_MS * TX_TIMER_TICKS_PER_SECOND) / 1000);
+
+		/* The stop request is checked again before a resize takes the media mutex */
+		if (xcache_stop != 0)
+		{
+			continue;
+		}
+
+		hits = nor_flash->lx_nor_flash_extended_cache_hits - last_hits;
+		misses = nor_flash->lx_nor_flash_extended_cache_misses - last_misses;
+		if ((hits + misses) < FX_APP_XCACHE_MIN_LOOKUPS)
+		{
+			continue;
+		}
+
+		last_hits += hits;
+		last_misses += misses;
+
+		/* The period following a resize starts from an empty cache */
+		if (resized)
+		{
+			resized = 0;
+			continue;
+		}
+
+		rate = (hits * 100) / (hits + misses);
+		sectors = xcache_sectors;
+
+		/* A held size is left once the hit rate moved, the workload has changed */
+		if (held && ((rate + FX_APP_XCACHE_MIN_GAIN_PERCENT) < held_rate))
+		{
+			held = 0;
+		}
+
+		if (grown && (rate < (rate_before_growth + FX_APP_XCACHE_MIN_GAIN_PERCENT)))
+		{
+			/* The last growth didn't pay for its memory */
+			sectors /= 2;
+			held = 1;
+			held_rate = rate_before_growth;
+		}
+		else if ((rate < FX_APP_XCACHE_TARGET_PERCENT) && (held == 0) && ((sectors * 2) <= LX_NOR_EXTENDED_CACHE_SIZE))
+		{
+			sectors *= 2;
+			rate_before_growth = rate;
+		}
+		grown = (sectors > xcache_sectors);
+
+		if (sectors != xcache_sectors)
+		{
+			if (Resize_FxExtendedCache(sectors) != LX_SUCCESS)
+			{
+				Error_Handler();
+			}
+			resized = 1;
+		}
+	}
+}
+
+/**
+  * @brief  Give the LevelX extended cache a buffer of the requested size, the cache restarts empty.
+  * @param  sectors: number of sectors of the cache
+  * @retval LX status
+  */
+UINT Resize_FxExtendedCache(ULONG sectors)
+{
+	LX_NOR_FLASH *nor_flash = lx_stm32_ospi_nor_flash;
+	VOID *memory;
+	UINT status;
+
+	/* LevelX is only called by FileX under the media mutex */
+	tx_mutex_get(&nor_ospi_flash_disk.fx_media_protect, TX_WAIT_FOREVER);
+
+	/* Detach the current buffer before giving its memory back to the pool */
+	lx_nor_flash_extended_cache_enable(nor_flash, NULL, 0);
+	if (xcache_memory != NULL)
+	{
+		tx_byte_release(xcache_memory);
+		xcache_memory = NULL;
+		xcache_sectors = 0;
+	}
+
+	status = tx_byte_allocate(&xcache_pool, &memory, sectors * FX_APP_XCACHE_SECTOR_BYTES, TX_NO_WAIT);
+	if (status == TX_SUCCESS)
+	{
+		status = lx_nor_flash_extended_cache_enable(nor_flash, memory, sectors * FX_APP_XCACHE_SECTOR_BYTES);
+		if (status == LX_SUCCESS)
+		{
+			xcache_memory = memory;
+			xcache_sectors = sectors;
+			xcache_resizes++;
+		}
+		else
+		{
+			tx_byte_release(memory);
+		}
+	}
+	else
+	{
+		status = LX_ERROR;
+	}
+
+	tx_mutex_put(&nor_ospi_flash_disk.fx_media_protect);
+
+	return status;
+}
+
+/**
+  * @brief  Print the LevelX extended cache hits and misses and the reads reaching the flash by block area.
+  * @retval none
+  */
+void Print_FxCacheStats(void)
+{
+	LX_NOR_FLASH *nor_flash = lx_stm32_ospi_nor_flash;
+	LX_STM32_OSPI_AREA_STATS area_stats;
+
+	lx_stm32_ospi_get_area_stats(&area_stats);
+
+	printf("LevelX extended cache: %lu sectors after %lu resizes, %lu hits, %lu misses\r\n", xcache_sectors, xcache_resizes,
+	       nor_flash->lx_nor_flash_extended_cache_hits, nor_flash->lx_nor_flash_extended_cache_misses);
+	printf("  Reads reaching the flash: block header %lu, mapping %lu, data %lu\r\n",
+	       area_stats.reads[LX_STM32_OSPI_AREA_HEADER], area_stats.reads[LX_STM32_OSPI_AREA_MAPPING],
+	       area_stats.reads[LX_STM32_OSPI_AREA_DATA]);
+}
+#endif
+
+#if (FX_APP_BENCHMARK == 1)
+void bench_load_thread_entry(ULONG thread_input)
+{
+	while(1)
+	{
+		bench_load_count++;
+	}
+}
+
+ULONG Bench_LoadCalibrate(void)
+{
+	ULONG load_start;
+
+	/* Let the load thread run alone */
+	load_start = bench_load_count;
+	tx_thread_resume(&bench_load_thread);
+	tx_thread_sleep((FX_APP_BENCH_CALIBRATION_MS * TX_TIMER_TICKS_PER_SECOND) / 1000);
+	tx_thread_suspend(&bench_load_thread);
+
+	return (bench_load_count - load_start) * (1000 / FX_APP_BENCH_CALIBRATION_MS);
+}
+
+UINT Bench_FxWrite(CHAR* file_name, ULONG file_size, ULONG chunk_size, ULONG passes)
+{
+	UINT nor_ospi_status = FX_SUCCESS;
+	ULONG offset, i, pass;
+	ULONG start_ticks, elapsed_ms;
+	ULONG write_cycles, max_write_cycles = 0;
+	ULONG load_per_second, load_start, load_expected;
+	LX_STM32_OSPI_TRANSFER_STATS stats;
+
+	load_per_second = Bench_LoadCalibrate();
+
+	/* Start from an empty file */
+	fx_file_delete(&nor_ospi_flash_disk, file_name);
+
+	nor_ospi_status =  fx_file_create(&nor_ospi_flash_disk, file_name);
+	if (nor_ospi_status != FX_SUCCESS)
+	{
+		goto BENCH_WRITE_END;
+	}
+
+	nor_ospi_status =  fx_file_open(&nor_ospi_flash_disk, &fx_file, file_name, FX_OPEN_FOR_WRITE);
+	if (nor_ospi_status != FX_SUCCESS)
+	{
+		goto BENCH_WRITE_END;
+	}
+
+	lx_stm32_ospi_reset_transfer_stats(LX_STM32_OSPI_INSTANCE);
+	lx_stm32_ospi_reset_op_stats(LX_STM32_OSPI_INSTANCE);
+	memset(bench_latency, 0, sizeof(bench_latency));
+	tx_thread_resume(&bench_load_thread);
+	load_start = bench_load_count;
+	start_ticks = tx_time_get();
+
+	for (pass = 0; pass < passes; pass++)
+	{
+		/* Overwrite the file, the previous data become obsolete LevelX sectors */
+		nor_ospi_status =  fx_file_seek(&fx_file, 0);
+		if (nor_ospi_status != FX_SUCCESS)
+		{
+			goto BENCH_WRITE_END;
+		}
+
+		for (offset = 0; offset < file_size; offset += chunk_size)
+		{
+			/* Build the next chunk, this is the CPU work that overlaps the flash busy time
+			 * when LX_STM32_OSPI_DEFERRED_BUSY_WAIT is enabled.
+			 */
+			for (i = 0; i < chunk_size; i++)
+			{
+				bench_buffer[i] = (UCHAR)((offset + i + pass) * 31);
+			}
+
+			write_cycles = LX_STM32_OSPI_CYCLE_COUNT();
+			nor_ospi_status =  fx_file_write(&fx_file, bench_buffer, chunk_size);
+			if (nor_ospi_status != FX_SUCCESS)
+			{
+				goto BENCH_WRITE_END;
+			}
+
+			/* The slowest writes are the ones that trigger a LevelX block reclaim */
+			write_cycles = LX_STM32_OSPI_CYCLE_COUNT() - write_cycles;
+			Bench_LatencyRecord(write_cycles);
+			if (write_cycles > max_write_cycles)
+			{
+				max_write_cycles = write_cycles;
+			}
+
+			if (FX_APP_BENCH_IDLE_MS != 0)
+			{
+				tx_thread_sleep((FX_APP_BENCH_IDLE_MS * TX_TIMER_TICKS_PER_SECOND) / 1000);
+			}
+		}
+	}
+
+	nor_ospi_status =  fx_file_close(&fx_file);
+	if (nor_ospi_status != FX_SUCCESS)
+	{
+		goto BENCH_WRITE_END;
+	}
+
+	nor_ospi_status = fx_media_flush(&nor_ospi_flash_disk);
+	if (nor_ospi_status != FX_SUCCESS)
+	{
+		goto BENCH_WRITE_END;
+	}
+
+	elapsed_ms = ((tx_time_get() - start_ticks) * 1000) / TX_TIMER_TICKS_PER_SECOND;
+	tx_thread_suspend(&bench_load_thread);
+	load_expected = (load_per_second / 1000) * elapsed_ms;
+	lx_stm32_ospi_get_transfer_stats(LX_STM32_OSPI_INSTANCE, &stats);
+
+	printf("Write benchmark: %lu x %lu bytes in %lu ms (%lu KB/s), deferred busy wait %s\r\n",
+	       passes, file_size, elapsed_ms, (elapsed_ms != 0) ? ((file_size / elapsed_ms) * passes) * 1000 / 1024 : 0,
+	       (LX_STM32_OSPI_DEFERRED_BUSY_WAIT == 1) ? "on" : "off");
+	printf("  LevelX block: %lu bytes, %lu bytes write latency p50: %lu us, p99: %lu us, worst: %lu us\r\n",
+	       (ULONG)LX_STM32_OSPI_SECTOR_SIZE, chunk_size, Bench_LatencyPercentile(50), Bench_LatencyPercentile(99),
+	       max_write_cycles / (SystemCoreClock / 1000000));
+	printf("  Pre-erase service %s, %lu blocks reclaimed in the background so far\r\n",
+	       (FX_APP_PREERASE == 1) ? "on" : "off",
+#if (FX_APP_PREERASE == 1)
+	       preerase_reclaims
+#else
+	       0UL
+#endif
+	       );
+	printf("  DMA transfers: %lu, IT transfers: %lu, max transfer: %lu cycles\r\n",
+	       stats.dma_transfers, stats.it_transfers, stats.max_cycles);
+	printf("  Commands issued: %lu, %lu cycles per command setup\r\n",
+	       stats.commands, (stats.commands != 0) ? (ULONG)(stats.command_cycles / stats.commands) : 0);
+	printf("  CPU left to lower priority threads: %lu%%\r\n",
+	       (load_expected != 0) ? ((bench_load_count - load_start) / (load_expected / 100 + 1)) : 0);
+	printf("  Blank checks: %lu, %lu read from flash\r\n", stats.blank_checks, stats.blank_check_reads);
+	printf("  Erase suspends: %lu, program suspends: %lu\r\n", stats.erase_suspends, stats.program_suspends);
+	printf("  Status checks answered from RAM: %lu, erase waits sleeping until the typical end: %lu\r\n",
+	       stats.status_cached, stats.erase_sleeps);
+	printf("  Read-ahead: %lu windows, %lu hits\r\n", stats.read_ahead_fills, stats.read_ahead_hits);
+	Bench_DumpOpStats();
+
+BENCH_WRITE_END:
+	return nor_ospi_status;
+}
+
+UINT Bench_FxSmallFiles(ULONG count, ULONG size)
+{
+	UINT nor_ospi_status = FX_SUCCESS;
+	CHAR file_name[16];
+	ULONG n, start_ticks, elapsed_ms;
+	LX_STM32_OSPI_TRANSFER_STATS stats;
+	LX_STM32_OSPI_OP_STATS program_stats;
+
+	memset(bench_buffer, 0x5A, size);
+
+	lx_stm32_ospi_reset_transfer_stats(LX_STM32_OSPI_INSTANCE);
+	lx_stm32_ospi_reset_op_stats(LX_STM32_OSPI_INSTANCE);
+	start_ticks = tx_time_get();
+
+	for (n = 0; n < count; n++)
+	{
+		/* 8.3 names: at most 1000 files */
+		snprintf(file_name, sizeof(file_name), "SMALL%03u.BIN", (UINT)(n % 1000));
+
+		/* Start from an empty file */
+		fx_file_delete(&nor_ospi_flash_disk, file_name);
+
+		nor_ospi_status =  fx_file_create(&nor_ospi_flash_disk, file_name);
+		if (nor_ospi_status != FX_SUCCESS)
+		{
+			goto BENCH_SMALL_END;
+		}
+
+		nor_ospi_status =  fx_file_open(&nor_ospi_flash_disk, &fx_file, file_name, FX_OPEN_FOR_WRITE);
+		if (nor_ospi_status != FX_SUCCESS)
+		{
+			goto BENCH_SMALL_END;
+		}
+
+		nor_ospi_status =  fx_file_write(&fx_file, bench_buffer, size);
+		if (nor_ospi_status != FX_SUCCESS)
+		{
+			goto BENCH_SMALL_END;
+		}
+
+		nor_ospi_status =  fx_file_close(&fx_file);
+		if (nor_ospi_status != FX_SUCCESS)
+		{
+			goto BENCH_SMALL_END;
+		}
+
+		nor_ospi_status = fx_media_flush(&nor_ospi_flash_disk);
+		if (nor_ospi_status != FX_SUCCESS)
+		{
+			goto BENCH_SMALL_END;
+		}
+	}
+
+	elapsed_ms = ((tx_time_get() - start_ticks) * 1000) / TX_TIMER_TICKS_PER_SECOND;
+	lx_stm32_ospi_get_transfer_stats(LX_STM32_OSPI_INSTANCE, &stats);
+	lx_stm32_ospi_get_op_stats(LX_STM32_OSPI_INSTANCE, LX_STM32_OSPI_OP_PROGRAM, &program_stats);
+
+	/* Each coalesced write would have been a page program of its own */
+	printf("Small file benchmark: %lu files of %lu bytes in %lu ms, write coalescing %s\r\n",
+	       count, size, elapsed_ms, (LX_STM32_OSPI_WRITE_COALESCE == 1) ? "on" : "off");
+	printf("  Page programs: %lu, %lu without coalescing\r\n",
+	       program_stats.count, program_stats.count + stats.coalesced_writes);
+
+BENCH_SMALL_END:
+	return nor_ospi_status;
+}
+
+UINT Bench_ReadLatency(ULONG iterations)
+{
+	static const ULONG read_sizes[] = {4, 512, 64 * 1024};
+	UINT nor_ospi_status = FX_SUCCESS;
+	ULONG size, address, n, i;
+	ULONG cycles, min_cycles;
+	ULONG64 total_cycles;
+
+	/* The reads go straight to the OSPI driver, LevelX must not use it meanwhile */
+	tx_mutex_get(&nor_ospi_flash_disk.fx_media_protect, TX_WAIT_FOREVER);
+
+	printf("Read latency benchmark: continuous read %s, memory-mapped read %s\r\n",
+	       (LX_STM32_OSPI_CONTINUOUS_READ == 1) ? "on" : "off", (LX_STM32_OSPI_MEMORY_MAPPED_READ == 1) ? "on" : "off");
+
+	for (i = 0; i < sizeof(read_sizes) / sizeof(read_sizes[0]); i++)
+	{
+		size = read_sizes[i];
+		total_cycles = 0;
+		min_cycles = 0xFFFFFFFF;
+
+		for (n = 0; n < iterations; n++)
+		{
+			/* Spread the reads so that none is served by a previous one */
+			address = (n * (LX_STM32_OSPI_SECTOR_SIZE + size)) % (LX_STM32_OSPI_FLASH_SIZE - sizeof(bench_read_buffer));
+			address &= ~(sizeof(ULONG) - 1);
+
+			cycles = LX_STM32_OSPI_CYCLE_COUNT();
+			if ((lx_stm32_ospi_read_start(LX_STM32_OSPI_INSTANCE, (ULONG *)address, bench_read_buffer, size / sizeof(ULONG)) != 0) ||
+			    (lx_stm32_ospi_read_wait(LX_STM32_OSPI_INSTANCE) != 0))
+			{
+				nor_ospi_status = FX_IO_ERROR;
+				goto BENCH_READ_END;
+			}
+			cycles = LX_STM32_OSPI_CYCLE_COUNT() - cycles;
+
+			total_cycles += cycles;
+			if (cycles < min_cycles)
+			{
+				min_cycles = cycles;
+			}
+		}
+
+		printf("  %lu bytes: avg %lu cycles (%lu us), min %lu cycles\r\n", size, (ULONG)(total_cycles / iterations),
+		       (ULONG)(total_cycles / iterations) / (SystemCoreClock / 1000000), min_cycles);
+	}
+
+BENCH_READ_END:
+	tx_mutex_put(&nor_ospi_flash_disk.fx_media_protect);
+	return nor_ospi_status;
+}
+
+UINT Bench_FxRandomRead(CHAR* file_name, ULONG file_size, ULONG reads)
+{
+	UINT nor_ospi_status = FX_SUCCESS;
+	LX_NOR_FLASH *nor_flash = lx_stm32_ospi_nor_flash;
+	ULONG sectors = file_size / FX_NOR_OSPI_SECTOR_SIZE;
+	ULONG seed = 0x2545F491;
+	ULONG n, bytes_read, cycles, max_cycles = 0;
+	ULONG hits, misses;
+	ULONG64 total_cycles = 0;
+
+	nor_ospi_status =  fx_file_open(&nor_ospi_flash_disk, &fx_file, file_name, FX_OPEN_FOR_READ);
+	if (nor_ospi_status != FX_SUCCESS)
+	{
+		return nor_ospi_status;
+	}
+
+	hits = nor_flash->lx_nor_flash_sector_mapping_cache_hits;
+	misses = nor_flash->lx_nor_flash_sector_mapping_cache_misses;
+
+	for (n = 0; n < reads; n++)
+	{
+		/* xorshift, the same sequence on every run */
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+
+		cycles = LX_STM32_OSPI_CYCLE_COUNT();
+
+		nor_ospi_status =  fx_file_seek(&fx_file, (seed % sectors) * FX_NOR_OSPI_SECTOR_SIZE);
+		if (nor_ospi_status != FX_SUCCESS)
+		{
+			goto BENCH_RANDOM_END;
+		}
+
+		nor_ospi_status =  fx_file_read(&fx_file, bench_read_buffer, FX_NOR_OSPI_SECTOR_SIZE, &bytes_read);
+		if ((nor_ospi_status != FX_SUCCESS) || (bytes_read != FX_NOR_OSPI_SECTOR_SIZE))
+		{
+			nor_ospi_status = FX_IO_ERROR;
+			goto BENCH_RANDOM_END;
+		}
+
+		cycles = LX_STM32_OSPI_CYCLE_COUNT() - cycles;
+		total_cycles += cycles;
+		if (cycles > max_cycles)
+		{
+			max_cycles = cycles;
+		}
+	}
+
+	hits = nor_flash->lx_nor_flash_sector_mapping_cache_hits - hits;
+	misses = nor_flash->lx_nor_flash_sector_mapping_cache_misses - misses;
+
+	printf("Random read benchmark: %lu reads of %u bytes over %lu KB, mapping cache of %u entries\r\n",
+	       reads, FX_NOR_OSPI_SECTOR_SIZE, file_size / 1024, LX_NOR_SECTOR_MAPPING_CACHE_SIZE);
+	printf("  %lu IOPS, avg %lu us, max %lu us, mapping cache %lu hits %lu misses\r\n",
+	       (ULONG)(((ULONG64)reads * SystemCoreClock) / total_cycles),
+	       (ULONG)(total_cycles / reads) / (SystemCoreClock / 1000000), max_cycles / (SystemCoreClock / 1000000), hits, misses);
+
+BENCH_RANDOM_END:
+	fx_file_close(&fx_file);
+	return nor_ospi_status;
+}
+
+void bench_writer_thread_entry(ULONG thread_input)
+{
+	ULONG offset = 0, i;
+
+	while(1)
+	{
+		/* Stopped, or stopped by an error: suspend between two slices, leaving the status to the benchmark */
+		if ((bench_writer_stop != 0) || (bench_writer_status != FX_SUCCESS))
+		{
+			bench_writer_stopped = 1;
+			tx_thread_suspend(&bench_writer_thread);
+			continue;
+		}
+
+		/* Rewrite the file in place, LevelX has to reclaim the blocks of the previous data */
+		if (offset >= FX_APP_BENCH_FILE_SIZE)
+		{
+			offset = 0;
+			bench_writer_status = fx_file_seek(&bench_writer_file, 0);
+			if (bench_writer_status != FX_SUCCESS)
+			{
+				continue;
+			}
+		}
+
+		for (i = 0; i < sizeof(bench_writer_buffer); i++)
+		{
+			bench_writer_buffer[i] = (UCHAR)(offset + i);
+		}
+
+		bench_writer_status = Write_FxShared(&bench_writer_file, bench_writer_buffer, sizeof(bench_writer_buffer));
+		if (bench_writer_status != FX_SUCCESS)
+		{
+			continue;
+		}
+
+		offset += sizeof(bench_writer_buffer);
+		bench_writer_bytes += sizeof(bench_writer_buffer);
+	}
+}
+
+UINT Bench_FxReadUnderWrite(CHAR* file_name, ULONG file_size, ULONG reads)
+{
+	UINT nor_ospi_status = FX_SUCCESS;
+	ULONG sectors = file_size / FX_NOR_OSPI_SECTOR_SIZE;
+	ULONG seed = 0x2545F491;
+	ULONG n, phase, bytes_read, cycles, max_cycles;
+	ULONG start_ticks, elapsed_ms;
+
+	/* The writer rewrites its own file, the benchmark reads the write benchmark one */
+	fx_file_delete(&nor_ospi_flash_disk, "WRITER.BIN");
+
+	nor_ospi_status =  fx_file_create(&nor_ospi_flash_disk, "WRITER.BIN");
+	if (nor_ospi_status != FX_SUCCESS)
+	{
+		return nor_ospi_status;
+	}
+
+	nor_ospi_status =  fx_file_open(&nor_ospi_flash_disk, &bench_writer_file, "WRITER.BIN", FX_OPEN_FOR_WRITE);
+	if (nor_ospi_status != FX_SUCCESS)
+	{
+		return nor_ospi_status;
+	}
+
+	nor_ospi_status =  fx_file_open(&nor_ospi_flash_disk, &fx_file, file_name, FX_OPEN_FOR_READ);
+	if (nor_ospi_status != FX_SUCCESS)
+	{
+		fx_file_close(&bench_writer_file);
+		return nor_ospi_status;
+	}
+
+	printf("Read/write benchmark: %lu reads of %u bytes, writer slices of %u bytes\r\n",
+	       reads, FX_NOR_OSPI_SECTOR_SIZE, FX_APP_WRITE_SLICE);
+
+	/* Phase 0 reads alone, phase 1 while the writer runs whenever the reader waits */
+	for (phase = 0; phase < 2; phase++)
+	{
+		memset(bench_latency, 0, sizeof(bench_latency));
+		max_cycles = 0;
+		bench_writer_bytes = 0;
+		bench_writer_status = FX_SUCCESS;
+		if (phase == 1)
+		{
+			bench_writer_stop = 0;
+			bench_writer_stopped = 0;
+			tx_thread_resume(&bench_writer_thread);
+		}
+		start_ticks = tx_time_get();
+
+		for (n = 0; n < reads; n++)
+		{
+			/* Let the writer start a slice */
+			tx_thread_sleep(1);
+
+			seed ^= seed << 13;
+			seed ^= seed >> 17;
+			seed ^= seed << 5;
+
+			cycles = LX_STM32_OSPI_CYCLE_COUNT();
+
+			nor_ospi_status =  fx_file_seek(&fx_file, (seed % sectors) * FX_NOR_OSPI_SECTOR_SIZE);
+			if (nor_ospi_status != FX_SUCCESS)
+			{
+				break;
+			}
+
+			nor_ospi_status =  fx_file_read(&fx_file, bench_read_buffer, FX_NOR_OSPI_SECTOR_SIZE, &bytes_read);
+			if ((nor_ospi_status != FX_SUCCESS) || (bytes_read != FX_NOR_OSPI_SECTOR_SIZE))
+			{
+				nor_ospi_status = FX_IO_ERROR;
+				break;
+			}
+
+			/* The reader waits for the slice and the LevelX reclaim in progress, if any */
+			cycles = LX_STM32_OSPI_CYCLE_COUNT() - cycles;
+			Bench_LatencyRecord(cycles);
+			if (cycles > max_cycles)
+			{
+				max_cycles = cycles;
+			}
+		}
+
+		if (phase == 1)
+		{
+			/* The writer suspends itself between two slices: suspended from here, it could be
+			 * waiting for the media mutex and would keep it once handed over.
+			 */
+			bench_writer_stop = 1;
+			while (bench_writer_stopped == 0)
+			{
+				tx_thread_sleep(1);
+			}
+		}
+		elapsed_ms = ((tx_time_get() - start_ticks) * 1000) / TX_TIMER_TICKS_PER_SECOND;
+
+		if (nor_ospi_status == FX_SUCCESS)
+		{
+			nor_ospi_status = bench_writer_status;
+		}
+		if (nor_ospi_status != FX_SUCCESS)
+		{
+			break;
+		}
+
+		printf("  %s: read latency p50: %lu us, p99: %lu us, worst: %lu us, writer %lu KB/s\r\n",
+		       (phase == 0) ? "alone" : "under write", Bench_LatencyPercentile(50), Bench_LatencyPercentile(99),
+		       max_cycles / (SystemCoreClock / 1000000), (elapsed_ms != 0) ? (bench_writer_bytes / elapsed_ms) * 1000 / 1024 : 0);
+	}
+
+	fx_file_close(&fx_file);
+	fx_file_close(&bench_writer_file);
+	fx_file_delete(&nor_ospi_flash_disk, "WRITER.BIN");
+
+	return nor_ospi_status;
+}
+
+void Bench_LatencyRecord(ULONG cycles)
+{
+	ULONG bucket = (cycles / (SystemCoreClock / 1000000)) / FX_APP_BENCH_LATENCY_STEP_US;
+
+	/* The last bucket also counts the longer latencies */
+	if (bucket >= FX_APP_BENCH_LATENCY_BUCKETS)
+	{
+		bucket = FX_APP_BENCH_LATENCY_BUCKETS - 1;
+	}
+
+	bench_latency[bucket]++;
+}
+
+void Bench_DumpOpStats(void)
+{
+	static const CHAR *op_names[LX_STM32_OSPI_OP_COUNT] = {"read", "program", "write enable", "erase", "poll", "status"};
+	LX_STM32_OSPI_OP_STATS op_stats;
+	ULONG op, i;
+
+	for (op = 0; op < LX_STM32_OSPI_OP_COUNT; op++)
+	{
+		lx_stm32_ospi_get_op_stats(LX_STM32_OSPI_INSTANCE, op, &op_stats);
+		if (op_stats.count == 0)
+		{
+			continue;
+		}
+
+		printf("  %s: %lu ops, %lu bytes, avg %lu cycles, max %lu cycles\r\n", op_names[op], op_stats.count,
+		       (ULONG)op_stats.bytes, (ULONG)(op_stats.total_cycles / op_stats.count), op_stats.max_cycles);
+		for (i = 0; i < LX_STM32_OSPI_LATENCY_BUCKETS; i++)
+		{
+			if (op_stats.histogram[i] != 0)
+			{
+				printf("    < 2^%lu cycles: %lu\r\n", i + LX_STM32_OSPI_LATENCY_MIN_LOG2 + 1, op_stats.histogram[i]);
+			}
+		}
+	}
+}
+
+ULONG Bench_LatencyPercentile(ULONG percent)
+{
+	ULONG total = 0, count = 0, i;
+
+	for (i = 0; i < FX_APP_BENCH_LATENCY_BUCKETS; i++)
+	{
+		total += bench_latency[i];
+	}
+
+	/* Upper bound of the bucket holding the percentile */
+	for (i = 0; i < FX_APP_BENCH_LATENCY_BUCKETS; i++)
+	{
+		count += bench_latency[i];
+		if ((count * 100) >= (total * percent))
+		{
+			break;
+		}
+	}
+
+	return (i + 1) * FX_APP_BENCH_LATENCY_STEP_US;
+}
+
+#if (LX_STM32_OSPI_SCHED == 1)
+void bench_reader_thread_entry(ULONG thread_input)
+{
+	ULONG seed = 0x9E3779B9;
+	ULONG sectors = LX_STM32_OSPI_FLASH_SIZE / FX_NOR_OSPI_SECTOR_SIZE;
+
+	while(1)
+	{
+		/* Done, or stopped by an error: leave the status to the benchmark */
+		if ((bench_reader_count >= bench_reader_reads) || (bench_reader_status != 0))
+		{
+			bench_reader_done = 1;
+			tx_thread_suspend(&bench_reader_thread);
+			continue;
+		}
+
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+
+		/* A FileX sector anywhere in the memory, through the scheduler beside LevelX */
+		bench_reader_status = lx_stm32_ospi_sched_io(LX_STM32_OSPI_SCHED_READ, (ULONG *)((seed % sectors) * FX_NOR_OSPI_SECTOR_SIZE),
+		                                             bench_reader_buffer, FX_NOR_OSPI_SECTOR_SIZE / sizeof(ULONG), 0);
+		bench_reader_count++;
+
+		/* Let the logger post its requests */
+		tx_thread_sleep(1);
+	}
+}
+
+UINT Bench_SchedMixed(CHAR* file_name, ULONG file_size, ULONG reads)
+{
+	static const CHAR *op_names[LX_STM32_OSPI_SCHED_OP_COUNT] = {"read", "program", "erase", "blank check", "flush"};
+	UINT nor_ospi_status = FX_SUCCESS;
+	LX_STM32_OSPI_SCHED_STATS sched_stats;
+	LX_STM32_OSPI_TRANSFER_STATS stats;
+	ULONG offset = 0, written = 0, op;
+
+	fx_file_delete(&nor_ospi_flash_disk, file_name);
+
+	nor_ospi_status =  fx_file_create(&nor_ospi_flash_disk, file_name);
+	if (nor_ospi_status != FX_SUCCESS)
+	{
+		return nor_ospi_status;
+	}
+
+	nor_ospi_status =  fx_file_open(&nor_ospi_flash_disk, &fx_file, file_name, FX_OPEN_FOR_WRITE);
+	if (nor_ospi_status != FX_SUCCESS)
+	{
+		return nor_ospi_status;
+	}
+
+	memset(bench_buffer, 0x5A, sizeof(bench_buffer));
+
+	bench_reader_reads = reads;
+	bench_reader_count = 0;
+	bench_reader_status = 0;
+	bench_reader_done = 0;
+	lx_stm32_ospi_sched_reset_stats();
+	lx_stm32_ospi_reset_transfer_stats(LX_STM32_OSPI_INSTANCE);
+	tx_thread_resume(&bench_reader_thread);
+
+	/* Log until the raw reader is done, rewriting the file in place so that LevelX reclaims blocks */
+	while ((bench_reader_count < reads) && (bench_reader_status == 0))
+	{
+		if (offset >= file_size)
+		{
+			offset = 0;
+			nor_ospi_status = fx_file_seek(&fx_file, 0);
+			if (nor_ospi_status != FX_SUCCESS)
+			{
+				break;
+			}
+		}
+
+		nor_ospi_status = fx_file_write(&fx_file, bench_buffer, sizeof(bench_buffer));
+		if (nor_ospi_status != FX_SUCCESS)
+		{
+			break;
+		}
+
+		offset += sizeof(bench_buffer);
+		written += sizeof(bench_buffer);
+	}
+
+	/* The reader is suspended once done, stop it here on a logger error */
+	bench_reader_reads = 0;
+	while (bench_reader_done == 0)
+	{
+		tx_thread_sleep(1);
+	}
+
+	fx_file_close(&fx_file);
+	fx_file_delete(&nor_ospi_flash_disk, file_name);
+
+	if (nor_ospi_status != FX_SUCCESS)
+	{
+		return nor_ospi_status;
+	}
+	if (bench_reader_status != 0)
+	{
+		return FX_IO_ERROR;
+	}
+
+	lx_stm32_ospi_sched_get_stats(&sched_stats);
+	lx_stm32_ospi_get_transfer_stats(LX_STM32_OSPI_INSTANCE, &stats);
+
+	printf("Mixed workload benchmark: %lu raw reads of %u bytes, %lu bytes logged\r\n",
+	       bench_reader_count, FX_NOR_OSPI_SECTOR_SIZE, written);
+	for (op = 0; op < LX_STM32_OSPI_SCHED_OP_COUNT; op++)
+	{
+		if (sched_stats.op[op].count == 0)
+		{
+			continue;
+		}
+
+		printf("  %s: %lu requests, latency p50: < %lu us, p99: < %lu us, worst: %lu us\r\n", op_names[op], sched_stats.op[op].count,
+		       Bench_OpPercentile(&sched_stats.op[op], 50), Bench_OpPercentile(&sched_stats.op[op], 99),
+		       sched_stats.op[op].max_cycles / (SystemCoreClock / 1000000));
+	}
+	printf("  %lu writes served ahead of waiting reads, at most %lu requests pending\r\n",
+	       sched_stats.promotions, sched_stats.max_pending);
+	printf("  Reads served during a page program: %lu, during an erase: %lu\r\n",
+	       stats.program_suspends, stats.erase_suspends);
+
+	return nor_ospi_status;
+}
+
+ULONG Bench_OpPercentile(LX_STM32_OSPI_OP_STATS *op_stats, ULONG percent)
+{
+	ULONG count = 0, i;
+
+	/* Upper bound of the log2 bucket holding the percentile */
+	for (i = 0; i < LX_STM32_OSPI_LATENCY_BUCKETS - 1; i++)
+	{
+		count += op_stats->histogram[i];
+		if ((count * 100) >= (op_stats->count * percent))
+		{
+			break;
+		}
+	}
+
+	return (1UL << (i + LX_STM32_OSPI_LATENCY_MIN_LOG2 + 1)) / (SystemCoreClock / 1000000);
+}
+#endif
+#endif
+
 /* USER CODE END 1 */
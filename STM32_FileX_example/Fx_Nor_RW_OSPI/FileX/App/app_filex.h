@@ -98,7 +98,145 @@ UINT MX_FileX_Init(VOID *memory_ptr);
 #endif
 
 /* USER CODE BEGIN PD */
+/* Set to 1 to format the NOR flash on every boot. Otherwise the volume in flash is opened
+ * and only formatted when it can't be opened or doesn't pass the validation.
+ */
+#ifndef FX_APP_FORMAT_ON_BOOT
+  #define FX_APP_FORMAT_ON_BOOT 0
+#endif
+
+/* Set to 1 to run fx_media_check on the opened volume, the errors found are corrected. A volume
+ * that can't be repaired is reported, not formatted. It reads the whole FAT and directory tree.
+ */
+#ifndef FX_APP_MEDIA_CHECK
+  #define FX_APP_MEDIA_CHECK 0
+#endif
+
+/* Scratch memory of fx_media_check: a bit per cluster and the directory walk */
+#ifndef FX_APP_MEDIA_CHECK_MEMORY_SIZE
+  #define FX_APP_MEDIA_CHECK_MEMORY_SIZE 4096
+#endif
+
+/* Set to 1 to run the pre-erase service: a low priority thread reclaiming the obsolete
+ * LevelX blocks while FileX is idle, so that the writes seldom have to wait for an erase.
+ */
+#ifndef FX_APP_PREERASE
+  #define FX_APP_PREERASE 0
+#endif
+
+/* Free space, in LevelX blocks, the pre-erase service keeps ahead of the writes */
+#ifndef FX_APP_PREERASE_POOL_BLOCKS
+  #define FX_APP_PREERASE_POOL_BLOCKS 4
+#endif
+
+/* Period at which the pre-erase service checks the LevelX free space */
+#ifndef FX_APP_PREERASE_PERIOD_MS
+  #define FX_APP_PREERASE_PERIOD_MS 100
+#endif
+
+/* Largest write a writer does per media mutex ownership with Write_FxShared(), a reader
+ * waits for one such slice, or for the reclaim of one LevelX block, instead of a whole write.
+ */
+#ifndef FX_APP_WRITE_SLICE
+  #define FX_APP_WRITE_SLICE 512
+#endif
+
+/* Set to 1 to give the LevelX extended cache a buffer from a byte pool, resized at runtime:
+ * it is doubled while its hit rate is below FX_APP_XCACHE_TARGET_PERCENT, and halved back when
+ * doubling gained less than FX_APP_XCACHE_MIN_GAIN_PERCENT. It holds from
+ * FX_APP_XCACHE_MIN_SECTORS to LX_NOR_EXTENDED_CACHE_SIZE sectors.
+ */
+#ifndef FX_APP_XCACHE_TUNE
+  #define FX_APP_XCACHE_TUNE 0
+#endif
+
+#ifndef FX_APP_XCACHE_MIN_SECTORS
+  #define FX_APP_XCACHE_MIN_SECTORS 2
+#endif
+
+#ifndef FX_APP_XCACHE_TARGET_PERCENT
+  #define FX_APP_XCACHE_TARGET_PERCENT 90
+#endif
+
+#ifndef FX_APP_XCACHE_MIN_GAIN_PERCENT
+  #define FX_APP_XCACHE_MIN_GAIN_PERCENT 5
+#endif
+
+/* Period of the cache tuner, and lookups needed for a period to be taken into account */
+#ifndef FX_APP_XCACHE_PERIOD_MS
+  #define FX_APP_XCACHE_PERIOD_MS 500
+#endif
 
+#ifndef FX_APP_XCACHE_MIN_LOOKUPS
+  #define FX_APP_XCACHE_MIN_LOOKUPS 64
+#endif
+
+/* Set to 1 to run the storage benchmarks after the file test */
+#ifndef FX_APP_BENCHMARK
+  #define FX_APP_BENCHMARK 0
+#endif
+
+/* Size of the file written by the sustained write benchmark */
+#ifndef FX_APP_BENCH_FILE_SIZE
+  #define FX_APP_BENCH_FILE_SIZE (256 * 1024)
+#endif
+
+/* Size of each fx_file_write call of the write benchmark */
+#ifndef FX_APP_BENCH_CHUNK_SIZE
+  #define FX_APP_BENCH_CHUNK_SIZE 2048
+#endif
+
+/* Number of times the write benchmark rewrites its file in place. Once the total
+ * exceeds the free flash space LevelX has to reclaim blocks, which shows up in the
+ * worst fx_file_write latency reported for the selected LX_STM32_OSPI_ERASE_UNIT.
+ */
+#ifndef FX_APP_BENCH_PASSES
+  #define FX_APP_BENCH_PASSES 1
+#endif
+
+/* Idle time between two chunks of the write benchmark, the background services run meanwhile */
+#ifndef FX_APP_BENCH_IDLE_MS
+  #define FX_APP_BENCH_IDLE_MS 0
+#endif
+
+/* Number and size of the files created by the small file benchmark, where the
+ * LevelX metadata writes dominate. The size must not exceed FX_APP_BENCH_CHUNK_SIZE.
+ */
+#ifndef FX_APP_BENCH_SMALL_FILES
+  #define FX_APP_BENCH_SMALL_FILES 32
+#endif
+
+#ifndef FX_APP_BENCH_SMALL_FILE_SIZE
+  #define FX_APP_BENCH_SMALL_FILE_SIZE 100
+#endif
+
+/* Number of reads of each size timed by the read latency benchmark */
+#ifndef FX_APP_BENCH_READ_ITERATIONS
+  #define FX_APP_BENCH_READ_ITERATIONS 16
+#endif
+
+/* Number of sector reads at random offsets of the write benchmark file, timed by the random
+ * read benchmark. They miss the LevelX mapping cache unless LX_NOR_SECTOR_MAPPING_CACHE_SIZE
+ * covers the sectors of the file. The sweep-mapping-cache target of the simulator Makefile runs
+ * it for a range of cache sizes.
+ */
+#ifndef FX_APP_BENCH_RANDOM_READS
+  #define FX_APP_BENCH_RANDOM_READS 1024
+#endif
+
+/* Number of sector reads of the write benchmark file timed by the read/write benchmark,
+ * once alone and once while a lower priority thread rewrites a file of the same size.
+ */
+#ifndef FX_APP_BENCH_RW_READS
+  #define FX_APP_BENCH_RW_READS 256
+#endif
+
+/* Number of sector reads at random addresses the raw reader posts to the flash I/O scheduler
+ * while the application logs to a file, with LX_STM32_OSPI_SCHED set.
+ */
+#ifndef FX_APP_BENCH_MIXED_READS
+  #define FX_APP_BENCH_MIXED_READS 256
+#endif
 /* USER CODE END PD */
 
 /* USER CODE BEGIN 1 */
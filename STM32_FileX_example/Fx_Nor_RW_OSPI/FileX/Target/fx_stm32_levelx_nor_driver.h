@@ -72,6 +72,20 @@ extern "C" {
 */
 /* USER CODE BEGIN DEFAULT_DRIVER */
 
+#if defined(LX_NOR_OSPI_DRIVER) && (LX_STM32_OSPI_STRIPE == 1)
+/* LevelX instance striped over both OctoSPI memories, see lx_stm32_ospi_stripe_driver.c */
+#define LX_NOR_OSPI_STRIPE_DRIVER_ID     0x04
+#define LX_NOR_OSPI_STRIPE_DRIVER_NAME   "FX Levelx OctoSPI striped driver"
+#define LX_NOR_CUSTOM_DRIVERS   {.name = LX_NOR_OSPI_STRIPE_DRIVER_NAME, .id = LX_NOR_OSPI_STRIPE_DRIVER_ID, .nor_driver_initialize = lx_stm32_ospi_stripe_initialize}
+#endif
+
+#if defined(LX_NOR_OSPI_DRIVER) && (LX_STM32_OSPI_SCHED == 1)
+/* LevelX instance served by the flash I/O scheduler, see lx_stm32_ospi_sched_driver.c */
+#define LX_NOR_OSPI_SCHED_DRIVER_ID      0x05
+#define LX_NOR_OSPI_SCHED_DRIVER_NAME    "FX Levelx OctoSPI scheduled driver"
+#define LX_NOR_CUSTOM_DRIVERS   {.name = LX_NOR_OSPI_SCHED_DRIVER_NAME, .id = LX_NOR_OSPI_SCHED_DRIVER_ID, .nor_driver_initialize = lx_stm32_ospi_sched_initialize}
+#endif
+
 /* #define LX_NOR_DEFAULT_DRIVER */
 
 #ifdef LX_NOR_DEFAULT_DRIVER
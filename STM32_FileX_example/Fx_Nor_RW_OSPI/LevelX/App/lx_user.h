@@ -101,6 +101,18 @@
 /* #define LX_STANDALONE_ENABLE */
 
 /* USER CODE BEGIN 2 */
+/* Entries of the extended cache, each caching a 512-byte metadata sector in the memory given
+   to lx_nor_flash_extended_cache_enable. Only the entry table is in the LX_NOR_FLASH instance:
+   this is the upper bound of the cache resized at runtime by the application.
+*/
+#ifndef LX_NOR_EXTENDED_CACHE_SIZE
+#define LX_NOR_EXTENDED_CACHE_SIZE               32
+#endif
+
+/* LX_THREAD_SAFE_ENABLE stays off: LevelX is only called by FileX, under the media mutex,
+   and a second mutex around the LevelX API would not let a read in before a reclaim ends.
+   The application shares the media between readers and writers by slicing the writes.
+*/
 
 /* USER CODE END 2 */
 
@@ -27,13 +27,133 @@ extern "C" {
 /* Exported types ------------------------------------------------------------*/
 /* USER CODE BEGIN ET */
 
+/* latency histogram size and first bucket, see LX_STM32_OSPI_OP_STATS */
+#define LX_STM32_OSPI_LATENCY_BUCKETS                    20
+#define LX_STM32_OSPI_LATENCY_MIN_LOG2                   10
+
+/* Per-transfer accounting of the data phase of read and page program operations.
+ * Cycles are counted from the command setup up to the completion notification.
+ * commands/command_cycles account the command phase setup alone, for every issued command.
+ * blank_check_reads counts the lx_stm32_ospi_is_block_erased calls not answered by the erased block map.
+ * read_ahead_fills counts the reads of the next window started after a sequential read,
+ * read_ahead_hits the reads served from that window.
+ * coalesced_writes counts the writes merged into the page program of a previous write.
+ * checkpoint_hits counts the reads served from the checkpoint of the LevelX open.
+ * init_cycles is the duration of the last lx_stm32_ospi_lowlevel_init, init_status_writes the
+ * status/configuration register writes it issued and init_status_writes_saved the ones it
+ * skipped, out of the two a configuration of QE and of the high performance mode takes.
+ * status_cached counts the lx_stm32_ospi_get_status calls answered without a bus transaction,
+ * erase_sleeps the erase end waits that slept through the typical erase time before polling.
+ * erase_suspends and program_suspends count the erases and page programs suspended to serve a read.
+ */
+typedef struct
+{
+	ULONG   dma_transfers;
+	ULONG   it_transfers;
+	ULONG64 dma_bytes;
+	ULONG64 it_bytes;
+	ULONG64 dma_cycles;
+	ULONG64 it_cycles;
+	ULONG   mapped_reads;
+	ULONG64 mapped_bytes;
+	ULONG64 mapped_cycles;
+	ULONG   last_cycles;
+	ULONG   max_cycles;
+	ULONG   commands;
+	ULONG64 command_cycles;
+	ULONG   erase_suspends;
+	ULONG   program_suspends;
+	ULONG   blank_checks;
+	ULONG   blank_check_reads;
+	ULONG   read_ahead_fills;
+	ULONG   read_ahead_hits;
+	ULONG   coalesced_writes;
+	ULONG   checkpoint_hits;
+	ULONG   init_cycles;
+	ULONG   init_status_writes;
+	ULONG   init_status_writes_saved;
+	ULONG   status_cached;
+	ULONG   erase_sleeps;
+} LX_STM32_OSPI_TRANSFER_STATS;
+
+/* Flash operations timed by the driver */
+typedef enum
+{
+	LX_STM32_OSPI_OP_READ = 0,          /* lx_stm32_ospi_read call, program or erase suspend and resume included */
+	LX_STM32_OSPI_OP_PROGRAM,           /* page program command and data phase, the busy time is in POLL */
+	LX_STM32_OSPI_OP_WRITE_ENABLE,      /* WREN command and WEL polling */
+	LX_STM32_OSPI_OP_ERASE,             /* erase command up to the end of erase is checked */
+	LX_STM32_OSPI_OP_POLL,              /* wait for the end of a program or erase */
+	LX_STM32_OSPI_OP_STATUS,            /* register reads of lx_stm32_ospi_get_status */
+	LX_STM32_OSPI_OP_COUNT
+} LX_STM32_OSPI_OP;
+
+/* Per-operation accounting, timed with LX_STM32_OSPI_CYCLE_COUNT().
+ * histogram is a log2 latency histogram, bucket i counting the operations of
+ * [2^(i + LX_STM32_OSPI_LATENCY_MIN_LOG2), 2^(i + 1 + LX_STM32_OSPI_LATENCY_MIN_LOG2)) cycles,
+ * the first and last buckets also count the shorter and longer ones.
+ */
+typedef struct
+{
+	ULONG   count;
+	ULONG64 bytes;
+	ULONG64 total_cycles;
+	ULONG   max_cycles;
+	ULONG   histogram[LX_STM32_OSPI_LATENCY_BUCKETS];
+} LX_STM32_OSPI_OP_STATS;
+
+/* Areas of a LevelX block */
+typedef enum
+{
+	LX_STM32_OSPI_AREA_HEADER = 0,      /* erase count and free sector bit map */
+	LX_STM32_OSPI_AREA_MAPPING,         /* physical sector mapping list */
+	LX_STM32_OSPI_AREA_DATA,            /* sector data */
+	LX_STM32_OSPI_AREA_COUNT
+} LX_STM32_OSPI_AREA;
+
+/* LevelX reads that reached the driver, by area of the block read. The metadata sectors
+ * served by the LevelX extended cache don't reach the driver: these are its misses.
+ */
+typedef struct
+{
+	ULONG   reads[LX_STM32_OSPI_AREA_COUNT];
+	ULONG64 bytes[LX_STM32_OSPI_AREA_COUNT];
+} LX_STM32_OSPI_AREA_STATS;
+
+/* Requests served by the flash I/O scheduler, see lx_stm32_ospi_sched_io() */
+typedef enum
+{
+	LX_STM32_OSPI_SCHED_READ = 0,       /* read of words at address */
+	LX_STM32_OSPI_SCHED_WRITE,          /* program of words at address */
+	LX_STM32_OSPI_SCHED_ERASE,          /* erase of the block given as address */
+	LX_STM32_OSPI_SCHED_VERIFY,         /* blank check of the block given as address */
+	LX_STM32_OSPI_SCHED_FLUSH,          /* program of the page kept in RAM by the write coalescing */
+	LX_STM32_OSPI_SCHED_OP_COUNT
+} LX_STM32_OSPI_SCHED_OP;
+
+/* Scheduler accounting. op holds the latency of each request kind, from its submission to its
+ * completion. promotions counts the writes served while reads were waiting, because the write
+ * reached its deadline or LX_STM32_OSPI_SCHED_READ_BURST reads were served in a row.
+ */
+typedef struct
+{
+	LX_STM32_OSPI_OP_STATS op[LX_STM32_OSPI_SCHED_OP_COUNT];
+	ULONG   promotions;
+	ULONG   max_pending;
+} LX_STM32_OSPI_SCHED_STATS;
+
 /* USER CODE END ET */
 
 extern OSPI_HandleTypeDef hospi1;
 
-/* The following semaphore is being to notify about RX/TX completion. It needs to be released in the transfer callbacks */
-extern TX_SEMAPHORE ospi_rx_semaphore;
-extern TX_SEMAPHORE ospi_tx_semaphore;
+/* The following semaphore is being to notify about RX/TX completion. It needs to be released in the transfer callbacks.
+ * One per OSPI instance, see LX_STM32_OSPI_INSTANCE_COUNT.
+ */
+extern TX_SEMAPHORE ospi_rx_semaphore[];
+extern TX_SEMAPHORE ospi_tx_semaphore[];
+
+/* LevelX instance using this driver, set by LX_STM32_OSPI_POST_INIT for the application flash maintenance */
+extern LX_NOR_FLASH *lx_stm32_ospi_nor_flash;
 
 #define ospi_handle        hospi1
 
@@ -59,6 +179,222 @@ extern TX_SEMAPHORE ospi_tx_semaphore;
 
 /* USER CODE BEGIN EC */
 
+/* when set to 1 the LevelX instance is striped over two NOR memories, one per OSPI instance.
+ * Each LevelX block spans the same erase unit of both memories and the data is interleaved by
+ * chunks of LX_STM32_OSPI_STRIPE_UNIT bytes, so that both memories transfer and program at the
+ * same time. The instance is initialized by lx_stm32_ospi_stripe_initialize().
+ */
+#ifndef LX_STM32_OSPI_STRIPE
+#define LX_STM32_OSPI_STRIPE                             0
+#endif
+
+/* interleave size of the striped LevelX instance, a power of 2 dividing LX_STM32_OSPI_PAGE_SIZE.
+ * The 256 bytes default splits each 512 bytes LevelX sector across both memories.
+ */
+#ifndef LX_STM32_OSPI_STRIPE_UNIT
+#define LX_STM32_OSPI_STRIPE_UNIT                        256
+#endif
+
+/* when set to 1 the LevelX instance goes through a flash I/O scheduler: a thread that alone
+ * drives the OSPI instance and serves the requests its clients post to a ThreadX queue, LevelX
+ * being one of them. Reads are served first, earliest deadline first. Programs, erases and blank
+ * checks keep their order and are served first once the oldest one reached its deadline or after
+ * LX_STM32_OSPI_SCHED_READ_BURST reads in a row. A write is programmed LX_STM32_OSPI_SCHED_WRITE_SLICE
+ * bytes at a time and the waiting reads are served between two slices, a late write still lets
+ * one read through. With LX_STM32_OSPI_DEFERRED_BUSY_WAIT programs and erases complete once
+ * started, their end is checked by the next program or erase and the reads served meanwhile suspend
+ * the page program or the erase. Without it an erase and the last slice of a write are waited for
+ * before their request completes, the reads are still served between the slices of a write.
+ * The instance is initialized by lx_stm32_ospi_sched_initialize().
+ */
+#ifndef LX_STM32_OSPI_SCHED
+#define LX_STM32_OSPI_SCHED                              0
+#endif
+
+/* the scheduler thread must be above all its clients */
+#define LX_STM32_OSPI_SCHED_THREAD_PRIO                  5
+#define LX_STM32_OSPI_SCHED_STACK_SIZE                   1024
+/* requests posted and not yet taken by the scheduler, the clients wait when it is full */
+#define LX_STM32_OSPI_SCHED_QUEUE_DEPTH                  16
+#define LX_STM32_OSPI_SCHED_READ_BURST                   8
+/* bytes programmed before the scheduler looks for waiting reads, a multiple of the page size */
+#define LX_STM32_OSPI_SCHED_WRITE_SLICE                  LX_STM32_OSPI_PAGE_SIZE
+/* default deadlines of the requests, from their submission */
+#define LX_STM32_OSPI_SCHED_READ_DEADLINE_MS             5
+#define LX_STM32_OSPI_SCHED_WRITE_DEADLINE_MS            50
+#define LX_STM32_OSPI_SCHED_ERASE_DEADLINE_MS            500
+
+#if (LX_STM32_OSPI_SCHED == 1) && (LX_STM32_OSPI_STRIPE == 1)
+#error "LX_STM32_OSPI_SCHED drives a single OSPI instance, it can't be used with LX_STM32_OSPI_STRIPE"
+#endif
+
+/* number of OSPI instances driven by the glue, each with its own NOR memory */
+#ifndef LX_STM32_OSPI_INSTANCE_COUNT
+#if (LX_STM32_OSPI_STRIPE == 1)
+#define LX_STM32_OSPI_INSTANCE_COUNT                     2
+#else
+#define LX_STM32_OSPI_INSTANCE_COUNT                     1
+#endif
+#endif
+
+#if (LX_STM32_OSPI_STRIPE == 1) && (LX_STM32_OSPI_INSTANCE_COUNT != 2)
+#error "LX_STM32_OSPI_STRIPE needs LX_STM32_OSPI_INSTANCE_COUNT set to 2"
+#endif
+
+#if (LX_STM32_OSPI_INSTANCE_COUNT > 1)
+/* the second OSPI instance, OCTOSPI2 with its own DMA channel */
+extern OSPI_HandleTypeDef hospi2;
+
+#define ospi2_handle                                     hospi2
+
+#define LX_STM32_OSPI2_MEMORY_MAPPED_BASE                OCTOSPI2_BASE
+#define LX_STM32_OSPI2_DMA_CHANNEL                       DMA1_Channel2
+#define LX_STM32_OSPI2_DMA_REQUEST                       DMA_REQUEST_OCTOSPI2
+#define LX_STM32_OSPI2_DMA_IRQn                          DMA1_Channel2_IRQn
+#define LX_STM32_OSPI2_DMA_IRQHandler                    DMA1_Channel2_IRQHandler
+#endif
+
+/* transfers smaller than this size (in bytes) or not word aligned are done in
+ * interrupt mode, the DMA setup is not worth it for the LevelX metadata accesses.
+ */
+#define LX_STM32_OSPI_DMA_MIN_TRANSFER_SIZE              32
+
+/* DMA channel used for the OctoSPI data phase when LX_STM32_OSPI_DMA_API is set to 1 */
+#define LX_STM32_OSPI_DMA_CHANNEL                        DMA1_Channel1
+#define LX_STM32_OSPI_DMA_REQUEST                        DMA_REQUEST_OCTOSPI1
+#define LX_STM32_OSPI_DMA_IRQn                           DMA1_Channel1_IRQn
+#define LX_STM32_OSPI_DMA_IRQHandler                     DMA1_Channel1_IRQHandler
+
+/* when set to 1 the reads are served from the memory-mapped OctoSPI window.
+ * The driver leaves the memory-mapped mode only to issue program, erase and
+ * register commands, the next read switches back to it.
+ */
+#ifndef LX_STM32_OSPI_MEMORY_MAPPED_READ
+#define LX_STM32_OSPI_MEMORY_MAPPED_READ                 1
+#endif
+#define LX_STM32_OSPI_MEMORY_MAPPED_BASE                 OCTOSPI1_BASE
+
+/* size in bytes of the read-ahead window, used only when LX_STM32_OSPI_MEMORY_MAPPED_READ is 0.
+ * A sequential read reaching the end of the window starts the read of the next window
+ * in the background, in a single command. 0 disables the read-ahead.
+ * The default memory-mapped reads don't use it: the OctoSPI prefetches the bytes following a
+ * memory-mapped access and serves the next sequential access from the same burst.
+ */
+#ifndef LX_STM32_OSPI_READ_AHEAD_SIZE
+#define LX_STM32_OSPI_READ_AHEAD_SIZE                    2048
+#endif
+
+/* when set to 1 the wait for the end of program and erase uses the OctoSPI auto-polling
+ * in interrupt mode: the calling thread is suspended on a semaphore instead of spinning
+ * in HAL_OSPI_AutoPolling, which lets lower priority threads run during the erase.
+ */
+#ifndef LX_STM32_OSPI_AUTO_POLLING_IT
+#define LX_STM32_OSPI_AUTO_POLLING_IT                    1
+#endif
+
+/* convert a HAL timeout in ms into ThreadX ticks, rounded up */
+#define LX_STM32_OSPI_MS_TO_TICKS(__ms__)                ((((ULONG)(__ms__)) * TX_TIMER_TICKS_PER_SECOND + 999) / 1000)
+
+/* when set to 1 lx_stm32_ospi_write and lx_stm32_ospi_erase return as soon as the
+ * last command is issued, the end of the operation is waited for at the start of the
+ * next flash access. lx_stm32_ospi_get_status reports the driver as ready meanwhile,
+ * and the program or erase as failed once the memory has completed it with an error.
+ */
+#ifndef LX_STM32_OSPI_DEFERRED_BUSY_WAIT
+#define LX_STM32_OSPI_DEFERRED_BUSY_WAIT                 0
+#endif
+
+/* when set to 1 a write smaller than a page is kept in RAM, the next writes that
+ * continue it in the same page are appended and the page is programmed once.
+ * The page is programmed before any other write, erase or blank check, and before
+ * a read of its range, so the memory sees the programs in the LevelX order.
+ * lx_stm32_ospi_flush programs it explicitly, the FileX driver of the application calls it
+ * on each FileX flush so that fx_media_flush leaves no write in RAM.
+ */
+#ifndef LX_STM32_OSPI_WRITE_COALESCE
+#define LX_STM32_OSPI_WRITE_COALESCE                     0
+#endif
+
+/* when set to 1 the quad reads keep the memory in performance enhance mode (continuous read):
+ * the reads following the first one are sent without their 8 clocks instruction phase, in
+ * indirect mode as in memory-mapped mode. The memory leaves that mode before any other command.
+ */
+#ifndef LX_STM32_OSPI_CONTINUOUS_READ
+#define LX_STM32_OSPI_CONTINUOUS_READ                    0
+#endif
+
+/* when set to 1 the ranges LevelX and FileX read while the media is opened, up to the first
+ * program or erase, are saved by lx_stm32_ospi_lowlevel_deinit in a checkpoint at the end of
+ * the memory. The next open is served from the checkpoint, read sequentially by chunks of
+ * LX_STM32_OSPI_CHECKPOINT_CHUNK bytes, instead of one command per metadata read. The first
+ * program or erase invalidates the checkpoint, so an open after an unclean shutdown reads the
+ * flash. The last LX_STM32_OSPI_CHECKPOINT_SIZE bytes, rounded up to LevelX blocks, are taken
+ * from LevelX: the volume must be formatted again when the option is changed.
+ * Only for the indirect reads (LX_STM32_OSPI_MEMORY_MAPPED_READ 0), where each read costs a
+ * command: a memory-mapped read is already as cheap as a copy from RAM. The open then pays a
+ * checksum pass over the checkpoint and each clean deinit the erase of its blocks. Its gain
+ * has not been measured, check the boot to ready time printed by the application.
+ */
+#ifndef LX_STM32_OSPI_CHECKPOINT
+#define LX_STM32_OSPI_CHECKPOINT                         0
+#endif
+#define LX_STM32_OSPI_CHECKPOINT_SIZE                    (128 * 1024)
+/* number of ranges recorded, contiguous reads are merged in a single range */
+#define LX_STM32_OSPI_CHECKPOINT_RANGES                  256
+#define LX_STM32_OSPI_CHECKPOINT_CHUNK                   2048
+
+#if (LX_STM32_OSPI_CHECKPOINT == 1) && (LX_STM32_OSPI_MEMORY_MAPPED_READ == 1)
+#error "LX_STM32_OSPI_CHECKPOINT needs the indirect reads, set LX_STM32_OSPI_MEMORY_MAPPED_READ to 0"
+#endif
+
+/* when set to 1, with LX_STM32_OSPI_DEFERRED_BUSY_WAIT, a read issued while a block erase is
+ * in progress suspends the erase, is served and resumes it instead of waiting for the end of
+ * the erase. Reads of the block being erased still wait. An erase is suspended at most
+ * LX_STM32_OSPI_ERASE_SUSPEND_MAX times so that a stream of reads can't keep it from completing.
+ */
+#ifndef LX_STM32_OSPI_ERASE_SUSPEND
+#define LX_STM32_OSPI_ERASE_SUSPEND                      1
+#endif
+#define LX_STM32_OSPI_ERASE_SUSPEND_MAX                  16
+
+/* when set to 1 a read issued while a page program is in progress suspends the program within
+ * tPSL instead of waiting up to tPP for its end, then resumes it. Reads of the page being
+ * programmed still wait. The last page of a write is left in progress with
+ * LX_STM32_OSPI_DEFERRED_BUSY_WAIT or through the scheduler, which also serves the waiting reads
+ * between the pages of a long write. A page program is suspended at most
+ * LX_STM32_OSPI_PROGRAM_SUSPEND_MAX times.
+ */
+#ifndef LX_STM32_OSPI_PROGRAM_SUSPEND
+#define LX_STM32_OSPI_PROGRAM_SUSPEND                    1
+#endif
+#define LX_STM32_OSPI_PROGRAM_SUSPEND_MAX                4
+
+/* when set to 1 lx_stm32_ospi_get_status is answered from RAM once the end of the last program
+ * or erase and its failure bits were checked on the bus, and the wait for the end of an erase
+ * sleeps through its typical duration before polling the memory.
+ */
+#ifndef LX_STM32_OSPI_STATUS_CACHE
+#define LX_STM32_OSPI_STATUS_CACHE                       1
+#endif
+
+/* when set to 1 the indirect commands are issued by writing the OctoSPI CCR/TCR/IR/AR
+ * registers from the driver command table, skipping the HAL_OSPI_Command parameter checks.
+ * Set it to 0 to go through HAL_OSPI_Command, e.g. with a HAL that is not the STM32 one.
+ */
+#ifndef LX_STM32_OSPI_DIRECT_CMD
+#define LX_STM32_OSPI_DIRECT_CMD                         1
+#endif
+
+/* cycle counter used for the transfer accounting, can be redefined for host builds */
+#ifndef LX_STM32_OSPI_CYCLE_COUNT
+#define LX_STM32_OSPI_CYCLE_COUNTER_INIT()               do { \
+                                                           CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk; \
+                                                           DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk; \
+                                                         } while(0)
+#define LX_STM32_OSPI_CYCLE_COUNT()                      (DWT->CYCCNT)
+#define LX_STM32_OSPI_LOG2(__x__)                        (31U - __CLZ(__x__))
+#endif
+
 /* USER CODE END EC */
 
 /* Exported macro ------------------------------------------------------------*/
@@ -72,11 +408,12 @@ extern TX_SEMAPHORE ospi_tx_semaphore;
  /* USER CODE BEGIN LX_STM32_OSPI_POST_INIT */
 
 #define LX_STM32_OSPI_POST_INIT()                        do { \
-                                                         if (tx_semaphore_create(&ospi_rx_semaphore, "ospi rx transfer semaphore", 0) != TX_SUCCESS) \
+                                                         lx_stm32_ospi_nor_flash = nor_flash; \
+                                                         if (tx_semaphore_create(&ospi_rx_semaphore[LX_STM32_OSPI_INSTANCE], "ospi rx transfer semaphore", 0) != TX_SUCCESS) \
                                                          { \
                                                            return LX_ERROR; \
                                                          } \
-                                                         if (tx_semaphore_create(&ospi_tx_semaphore, "ospi tx transfer semaphore", 0) != TX_SUCCESS) \
+                                                         if (tx_semaphore_create(&ospi_tx_semaphore[LX_STM32_OSPI_INSTANCE], "ospi tx transfer semaphore", 0) != TX_SUCCESS) \
                                                          { \
                                                            return LX_ERROR; \
                                                          } \
@@ -96,7 +433,7 @@ extern TX_SEMAPHORE ospi_tx_semaphore;
 /* USER CODE BEGIN LX_STM32_OSPI_READ_CPLT_NOTIFY */
 
 #define LX_STM32_OSPI_READ_CPLT_NOTIFY(__status__)      do { \
-                                                          if(tx_semaphore_get(&ospi_rx_semaphore, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != TX_SUCCESS) \
+                                                          if(tx_semaphore_get(&ospi_rx_semaphore[LX_STM32_OSPI_INSTANCE], HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != TX_SUCCESS) \
                                                           { \
                                                             __status__ = LX_ERROR; \
                                                           } \
@@ -132,7 +469,7 @@ extern TX_SEMAPHORE ospi_tx_semaphore;
 /* USER CODE BEGIN LX_STM32_OSPI_WRITE_CPLT_NOTIFY */
 
 #define LX_STM32_OSPI_WRITE_CPLT_NOTIFY(__status__)     do { \
-                                                          if(tx_semaphore_get(&ospi_tx_semaphore, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != TX_SUCCESS) \
+                                                          if(tx_semaphore_get(&ospi_tx_semaphore[LX_STM32_OSPI_INSTANCE], HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != TX_SUCCESS) \
                                                           { \
                                                             __status__ = LX_ERROR; \
                                                           } \
@@ -182,7 +519,31 @@ extern void MX_OCTOSPI1_Init(void);
 #endif
 
 /* USER CODE BEGIN EFP */
+INT lx_stm32_ospi_read_start(UINT instance, ULONG *address, ULONG *buffer, ULONG words);
+INT lx_stm32_ospi_read_wait(UINT instance);
+INT lx_stm32_ospi_write_start(UINT instance, ULONG *address, ULONG *buffer, ULONG words);
+INT lx_stm32_ospi_erase_start(UINT instance, ULONG block, UINT full_chip_erase);
+INT lx_stm32_ospi_wait_ready(UINT instance);
+INT lx_stm32_ospi_flush(UINT instance);
+
+#if (LX_STM32_OSPI_STRIPE == 1)
+UINT lx_stm32_ospi_stripe_initialize(LX_NOR_FLASH *nor_flash);
+#endif
+
+#if (LX_STM32_OSPI_SCHED == 1)
+UINT lx_stm32_ospi_sched_initialize(LX_NOR_FLASH *nor_flash);
+INT lx_stm32_ospi_sched_io(UINT op, ULONG *address, ULONG *buffer, ULONG words, ULONG deadline_ms);
+VOID lx_stm32_ospi_sched_get_stats(LX_STM32_OSPI_SCHED_STATS *stats);
+VOID lx_stm32_ospi_sched_reset_stats(VOID);
+#endif
 
+VOID lx_stm32_ospi_get_transfer_stats(UINT instance, LX_STM32_OSPI_TRANSFER_STATS *stats);
+VOID lx_stm32_ospi_reset_transfer_stats(UINT instance);
+VOID lx_stm32_ospi_get_op_stats(UINT instance, UINT op, LX_STM32_OSPI_OP_STATS *stats);
+VOID lx_stm32_ospi_reset_op_stats(UINT instance);
+VOID lx_stm32_ospi_area_account(ULONG *address, ULONG words);
+VOID lx_stm32_ospi_get_area_stats(LX_STM32_OSPI_AREA_STATS *stats);
+VOID lx_stm32_ospi_reset_area_stats(VOID);
 /* USER CODE END EFP */
 
 /* Private defines -----------------------------------------------------------*/
@@ -195,13 +556,39 @@ extern void MX_OCTOSPI1_Init(void);
 
 #define LX_STM32_OSPI_DUMMY_CYCLES_READ_OCTAL		0
 
-//#define LX_STM32_OSPI_SECTOR_SIZE					MX25R6435F_SECTOR_SIZE
+/* Flash erase unit used as LevelX block: the 4 KB sector, the 32 KB subblock or the 64 KB block.
+ * Smaller blocks reduce the data copied by the LevelX reclaim, larger ones the number of erases.
+ */
+#define LX_STM32_OSPI_ERASE_UNIT_SECTOR				0
+#define LX_STM32_OSPI_ERASE_UNIT_SUBBLOCK			1
+#define LX_STM32_OSPI_ERASE_UNIT_BLOCK				2
+
+#ifndef LX_STM32_OSPI_ERASE_UNIT
+#define LX_STM32_OSPI_ERASE_UNIT					LX_STM32_OSPI_ERASE_UNIT_BLOCK
+#endif
+
+#if (LX_STM32_OSPI_ERASE_UNIT == LX_STM32_OSPI_ERASE_UNIT_SECTOR)
+#define LX_STM32_OSPI_SECTOR_SIZE					MX25R6435F_SECTOR_SIZE
+#define LX_STM32_OSPI_ERASE_MAX_TIME				MX25R6435F_SECTOR_ERASE_MAX_TIME
+#define LX_STM32_OSPI_ERASE_TYPICAL_TIME			40
+#elif (LX_STM32_OSPI_ERASE_UNIT == LX_STM32_OSPI_ERASE_UNIT_SUBBLOCK)
+#define LX_STM32_OSPI_SECTOR_SIZE					MX25R6435F_SUBBLOCK_SIZE
+#define LX_STM32_OSPI_ERASE_MAX_TIME				MX25R6435F_SUBBLOCK_ERASE_MAX_TIME
+#define LX_STM32_OSPI_ERASE_TYPICAL_TIME			240
+#elif (LX_STM32_OSPI_ERASE_UNIT == LX_STM32_OSPI_ERASE_UNIT_BLOCK)
 #define LX_STM32_OSPI_SECTOR_SIZE					MX25R6435F_BLOCK_SIZE
+#define LX_STM32_OSPI_ERASE_MAX_TIME				MX25R6435F_BLOCK_ERASE_MAX_TIME
+#define LX_STM32_OSPI_ERASE_TYPICAL_TIME			480
+#else
+#error "LX_STM32_OSPI_ERASE_UNIT must be one of the LX_STM32_OSPI_ERASE_UNIT_xxx values"
+#endif
+
 #define LX_STM32_OSPI_FLASH_SIZE					MX25R6435F_FLASH_SIZE
 #define LX_STM32_OSPI_PAGE_SIZE						MX25R6435F_PAGE_SIZE
 
-#define LX_STM32_OSPI_BULK_ERASE_MAX_TIME			CHIP_ERASE_CMD
-//#define LX_STM32_OSPI_BULK_ERASE_MAX_TIME			MX25R6435F_SECTOR_ERASE_MAX_TIME
+#define LX_STM32_OSPI_BULK_ERASE_MAX_TIME			MX25R6435F_CHIP_ERASE_MAX_TIME
+/* typical erase times in ms, high performance mode */
+#define LX_STM32_OSPI_BULK_ERASE_TYPICAL_TIME		50000
 
 #define LX_STM32_OSPI_OCTAL_BULK_ERASE_CMD			CHIP_ERASE_CMD
 #define LX_STM32_OSPI_OCTAL_SECTOR_ERASE_CMD		SECTOR_ERASE_CMD
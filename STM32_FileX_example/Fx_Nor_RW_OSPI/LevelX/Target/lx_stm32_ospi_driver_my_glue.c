@@ -1,21 +1,404 @@
 #include "lx_stm32_ospi_driver.h"
 #include "mx25r6435f_driver.h"
+#include <string.h>
 
 #define OSPI_QUAD_DISABLE       0x0
 #define OSPI_QUAD_ENABLE        0x1
 
-static uint8_t ospi_memory_reset(OSPI_HandleTypeDef *hospi);
-static uint8_t ospi_set_quad_mode(OSPI_HandleTypeDef *hospi);
-static uint8_t ospi_set_write_enable(OSPI_HandleTypeDef *hospi);
-static uint8_t ospi_auto_polling_ready(OSPI_HandleTypeDef *hospi, uint32_t timeout);
-static uint8_t ospi_highperf_mode(OSPI_HandleTypeDef *hospi);
+/* data phase paths, as reported by ospi_dma_eligible() for the first two */
+#define OSPI_TRANSFER_IT        0x0
+#define OSPI_TRANSFER_DMA       0x1
+#define OSPI_TRANSFER_MAPPED    0x2
+
+/* kind of operation whose end is not yet checked, see ospi_set_pending() */
+#define OSPI_PENDING_NONE       0x0
+#define OSPI_PENDING_PROGRAM    0x1
+#define OSPI_PENDING_ERASE      0x2
+
+/* read-ahead window, only used by the indirect reads */
+#if (LX_STM32_OSPI_MEMORY_MAPPED_READ == 0) && (LX_STM32_OSPI_READ_AHEAD_SIZE > 0)
+#define OSPI_READ_AHEAD         1
+#else
+#define OSPI_READ_AHEAD         0
+#endif
+
+/* suspend of the pending program or erase to serve a read */
+#if (LX_STM32_OSPI_ERASE_SUSPEND == 1) || (LX_STM32_OSPI_PROGRAM_SUSPEND == 1)
+#define OSPI_SUSPEND            1
+#else
+#define OSPI_SUSPEND            0
+#endif
+
+/* number of LevelX blocks, tracked in the erased block map */
+#define OSPI_BLOCK_COUNT        (LX_STM32_OSPI_FLASH_SIZE / LX_STM32_OSPI_SECTOR_SIZE)
+
+#if (LX_STM32_OSPI_CHECKPOINT == 1)
+/* checkpoint area, the last LevelX blocks of the memory: the header in the first page, the records from the second one */
+#define OSPI_CHECKPOINT_BLOCKS  ((LX_STM32_OSPI_CHECKPOINT_SIZE + LX_STM32_OSPI_SECTOR_SIZE - 1) / LX_STM32_OSPI_SECTOR_SIZE)
+#define OSPI_CHECKPOINT_BASE    (LX_STM32_OSPI_FLASH_SIZE - (OSPI_CHECKPOINT_BLOCKS * LX_STM32_OSPI_SECTOR_SIZE))
+#define OSPI_CHECKPOINT_RECORDS (OSPI_CHECKPOINT_BASE + LX_STM32_OSPI_PAGE_SIZE)
+#define OSPI_CHECKPOINT_CAPACITY (LX_STM32_OSPI_FLASH_SIZE - OSPI_CHECKPOINT_RECORDS)
+#define OSPI_CHECKPOINT_MAGIC   0x314B5043UL
+
+/* state of the checkpoint in flash */
+#define OSPI_CHECKPOINT_UNKNOWN 0x0
+#define OSPI_CHECKPOINT_VALID   0x1
+#define OSPI_CHECKPOINT_INVALID 0x2
+#endif
+
+/* CCR phase settings of the MX25R6435F commands, all SDR with an 8-bit instruction and a 24-bit address */
+#define OSPI_CCR_INST           (HAL_OSPI_INSTRUCTION_1_LINE | HAL_OSPI_INSTRUCTION_8_BITS)
+#define OSPI_CCR_ADDR_1         (HAL_OSPI_ADDRESS_1_LINE | HAL_OSPI_ADDRESS_24_BITS)
+#define OSPI_CCR_ADDR_2         (HAL_OSPI_ADDRESS_2_LINES | HAL_OSPI_ADDRESS_24_BITS)
+#define OSPI_CCR_ADDR_4         (HAL_OSPI_ADDRESS_4_LINES | HAL_OSPI_ADDRESS_24_BITS)
+#define OSPI_CCR_ALT_4          (HAL_OSPI_ALTERNATE_BYTES_4_LINES | HAL_OSPI_ALTERNATE_BYTES_8_BITS)
+#define OSPI_CCR_DATA_1         HAL_OSPI_DATA_1_LINE
+#define OSPI_CCR_DATA_2         HAL_OSPI_DATA_2_LINES
+#define OSPI_CCR_DATA_4         HAL_OSPI_DATA_4_LINES
+
+/* index of the commands in ospi_cmd_table */
+typedef enum
+{
+	OSPI_CMD_READ = 0,
+	OSPI_CMD_FAST_READ,
+	OSPI_CMD_DUAL_OUT_READ,
+	OSPI_CMD_DUAL_INOUT_READ,
+	OSPI_CMD_QUAD_OUT_READ,
+	OSPI_CMD_QUAD_INOUT_READ,
+	OSPI_CMD_PAGE_PROG,
+	OSPI_CMD_QUAD_PAGE_PROG,
+	OSPI_CMD_SECTOR_ERASE,
+	OSPI_CMD_SUBBLOCK_ERASE,
+	OSPI_CMD_BLOCK_ERASE,
+	OSPI_CMD_CHIP_ERASE,
+	OSPI_CMD_PROG_ERASE_RESUME,
+	OSPI_CMD_PROG_ERASE_SUSPEND,
+	OSPI_CMD_READ_ID,
+	OSPI_CMD_READ_ELECTRONIC_ID,
+	OSPI_CMD_READ_ELEC_MANUFACTURER_DEVICE_ID,
+	OSPI_CMD_READ_SERIAL_FLASH_DISCO_PARAM,
+	OSPI_CMD_WRITE_ENABLE,
+	OSPI_CMD_WRITE_DISABLE,
+	OSPI_CMD_READ_STATUS_REG,
+	OSPI_CMD_READ_CFG_REG,
+	OSPI_CMD_WRITE_STATUS_CFG_REG,
+	OSPI_CMD_READ_SEC_REG,
+	OSPI_CMD_WRITE_SEC_REG,
+	OSPI_CMD_DEEP_POWER_DOWN,
+	OSPI_CMD_SET_BURST_LENGTH,
+	OSPI_CMD_ENTER_SECURED_OTP,
+	OSPI_CMD_EXIT_SECURED_OTP,
+	OSPI_CMD_NO_OPERATION,
+	OSPI_CMD_RESET_ENABLE,
+	OSPI_CMD_RESET_MEMORY,
+	OSPI_CMD_RELEASE_READ_ENHANCED,
+	OSPI_CMD_QUAD_INOUT_READ_PE,
+	OSPI_CMD_QUAD_INOUT_READ_CONT,
+	OSPI_CMD_QUAD_INOUT_READ_PE_EXIT,
+	OSPI_CMD_COUNT
+} OSPI_CmdIdTypeDef;
+
+/* everything but the address and the data length of a command, in the OctoSPI register layout */
+typedef struct
+{
+	uint32_t ccr;
+	uint8_t  instruction;
+	uint8_t  dummy_cycles;
+	uint8_t  alternate;
+} OSPI_CmdDescTypeDef;
+
+/* erase command matching the LevelX block size */
+#if (LX_STM32_OSPI_ERASE_UNIT == LX_STM32_OSPI_ERASE_UNIT_SECTOR)
+#define OSPI_CMD_ERASE_UNIT     OSPI_CMD_SECTOR_ERASE
+#elif (LX_STM32_OSPI_ERASE_UNIT == LX_STM32_OSPI_ERASE_UNIT_SUBBLOCK)
+#define OSPI_CMD_ERASE_UNIT     OSPI_CMD_SUBBLOCK_ERASE
+#else
+#define OSPI_CMD_ERASE_UNIT     OSPI_CMD_BLOCK_ERASE
+#endif
+
+static const OSPI_CmdDescTypeDef ospi_cmd_table[OSPI_CMD_COUNT] =
+{
+	[OSPI_CMD_READ]                             = { OSPI_CCR_INST | OSPI_CCR_ADDR_1 | OSPI_CCR_DATA_1, READ_CMD, 0, 0 },
+	[OSPI_CMD_FAST_READ]                        = { OSPI_CCR_INST | OSPI_CCR_ADDR_1 | OSPI_CCR_DATA_1, FAST_READ_CMD, MX25R6435F_DUMMY_CYCLES_READ, 0 },
+	[OSPI_CMD_DUAL_OUT_READ]                    = { OSPI_CCR_INST | OSPI_CCR_ADDR_1 | OSPI_CCR_DATA_2, DUAL_OUT_READ_CMD, MX25R6435F_DUMMY_CYCLES_READ, 0 },
+	[OSPI_CMD_DUAL_INOUT_READ]                  = { OSPI_CCR_INST | OSPI_CCR_ADDR_2 | OSPI_CCR_DATA_2, DUAL_INOUT_READ_CMD, MX25R6435F_DUMMY_CYCLES_READ_DUAL, 0 },
+	[OSPI_CMD_QUAD_OUT_READ]                    = { OSPI_CCR_INST | OSPI_CCR_ADDR_1 | OSPI_CCR_DATA_4, QUAD_OUT_READ_CMD, MX25R6435F_DUMMY_CYCLES_READ, 0 },
+	[OSPI_CMD_QUAD_INOUT_READ]                  = { OSPI_CCR_INST | OSPI_CCR_ADDR_4 | OSPI_CCR_ALT_4 | OSPI_CCR_DATA_4, QUAD_INOUT_READ_CMD, MX25R6435F_DUMMY_CYCLES_READ_QUAD, MX25R6435F_ALT_BYTES_NO_PE_MODE },
+	[OSPI_CMD_PAGE_PROG]                        = { OSPI_CCR_INST | OSPI_CCR_ADDR_1 | OSPI_CCR_DATA_1, PAGE_PROG_CMD, 0, 0 },
+	[OSPI_CMD_QUAD_PAGE_PROG]                   = { OSPI_CCR_INST | OSPI_CCR_ADDR_4 | OSPI_CCR_DATA_4, QUAD_PAGE_PROG_CMD, 0, 0 },
+	[OSPI_CMD_SECTOR_ERASE]                     = { OSPI_CCR_INST | OSPI_CCR_ADDR_1, SECTOR_ERASE_CMD, 0, 0 },
+	[OSPI_CMD_SUBBLOCK_ERASE]                   = { OSPI_CCR_INST | OSPI_CCR_ADDR_1, SUBBLOCK_ERASE_CMD, 0, 0 },
+	[OSPI_CMD_BLOCK_ERASE]                      = { OSPI_CCR_INST | OSPI_CCR_ADDR_1, BLOCK_ERASE_CMD, 0, 0 },
+	[OSPI_CMD_CHIP_ERASE]                       = { OSPI_CCR_INST, CHIP_ERASE_CMD, 0, 0 },
+	[OSPI_CMD_PROG_ERASE_RESUME]                = { OSPI_CCR_INST, PROG_ERASE_RESUME_CMD, 0, 0 },
+	[OSPI_CMD_PROG_ERASE_SUSPEND]               = { OSPI_CCR_INST, PROG_ERASE_SUSPEND_CMD, 0, 0 },
+	[OSPI_CMD_READ_ID]                          = { OSPI_CCR_INST | OSPI_CCR_DATA_1, READ_ID_CMD, 0, 0 },
+	[OSPI_CMD_READ_ELECTRONIC_ID]               = { OSPI_CCR_INST | OSPI_CCR_DATA_1, READ_ELECTRONIC_ID_CMD, 24, 0 },
+	[OSPI_CMD_READ_ELEC_MANUFACTURER_DEVICE_ID] = { OSPI_CCR_INST | OSPI_CCR_ADDR_1 | OSPI_CCR_DATA_1, READ_ELEC_MANUFACTURER_DEVICE_ID_CMD, 0, 0 },
+	[OSPI_CMD_READ_SERIAL_FLASH_DISCO_PARAM]    = { OSPI_CCR_INST | OSPI_CCR_ADDR_1 | OSPI_CCR_DATA_1, READ_SERIAL_FLASH_DISCO_PARAM_CMD, 8, 0 },
+	[OSPI_CMD_WRITE_ENABLE]                     = { OSPI_CCR_INST, WRITE_ENABLE_CMD, 0, 0 },
+	[OSPI_CMD_WRITE_DISABLE]                    = { OSPI_CCR_INST, WRITE_DISABLE_CMD, 0, 0 },
+	[OSPI_CMD_READ_STATUS_REG]                  = { OSPI_CCR_INST | OSPI_CCR_DATA_1, READ_STATUS_REG_CMD, 0, 0 },
+	[OSPI_CMD_READ_CFG_REG]                     = { OSPI_CCR_INST | OSPI_CCR_DATA_1, READ_CFG_REG_CMD, 0, 0 },
+	[OSPI_CMD_WRITE_STATUS_CFG_REG]             = { OSPI_CCR_INST | OSPI_CCR_DATA_1, WRITE_STATUS_CFG_REG_CMD, 0, 0 },
+	[OSPI_CMD_READ_SEC_REG]                     = { OSPI_CCR_INST | OSPI_CCR_DATA_1, READ_SEC_REG_CMD, 0, 0 },
+	[OSPI_CMD_WRITE_SEC_REG]                    = { OSPI_CCR_INST, WRITE_SEC_REG_CMD, 0, 0 },
+	[OSPI_CMD_DEEP_POWER_DOWN]                  = { OSPI_CCR_INST, DEEP_POWER_DOWN_CMD, 0, 0 },
+	[OSPI_CMD_SET_BURST_LENGTH]                 = { OSPI_CCR_INST | OSPI_CCR_DATA_1, SET_BURST_LENGTH_CMD, 0, 0 },
+	[OSPI_CMD_ENTER_SECURED_OTP]                = { OSPI_CCR_INST, ENTER_SECURED_OTP_CMD, 0, 0 },
+	[OSPI_CMD_EXIT_SECURED_OTP]                 = { OSPI_CCR_INST, EXIT_SECURED_OTP_CMD, 0, 0 },
+	[OSPI_CMD_NO_OPERATION]                     = { OSPI_CCR_INST, NO_OPERATION_CMD, 0, 0 },
+	[OSPI_CMD_RESET_ENABLE]                     = { OSPI_CCR_INST, RESET_ENABLE_CMD, 0, 0 },
+	[OSPI_CMD_RESET_MEMORY]                     = { OSPI_CCR_INST, RESET_MEMORY_CMD, 0, 0 },
+	[OSPI_CMD_RELEASE_READ_ENHANCED]            = { OSPI_CCR_INST, RELEASE_READ_ENHANCED_CMD, 0, 0 },
+	/* performance enhance mode: entered by the 0xA5 mode bits, the next reads have no instruction
+	 * phase until a read with other mode bits. The exit read has a null address so that it is seen
+	 * as an invalid 0x00 instruction by a memory not in performance enhance mode.
+	 */
+	[OSPI_CMD_QUAD_INOUT_READ_PE]               = { OSPI_CCR_INST | OSPI_CCR_ADDR_4 | OSPI_CCR_ALT_4 | OSPI_CCR_DATA_4, QUAD_INOUT_READ_CMD, MX25R6435F_DUMMY_CYCLES_READ_QUAD, MX25R6435F_ALT_BYTES_PE_MODE },
+	[OSPI_CMD_QUAD_INOUT_READ_CONT]             = { OSPI_CCR_ADDR_4 | OSPI_CCR_ALT_4 | OSPI_CCR_DATA_4, 0, MX25R6435F_DUMMY_CYCLES_READ_QUAD, MX25R6435F_ALT_BYTES_PE_MODE },
+	[OSPI_CMD_QUAD_INOUT_READ_PE_EXIT]          = { OSPI_CCR_ADDR_4 | OSPI_CCR_ALT_4 | OSPI_CCR_DATA_4, 0, MX25R6435F_DUMMY_CYCLES_READ_QUAD, MX25R6435F_ALT_BYTES_NO_PE_MODE },
+};
+
+#if (LX_STM32_OSPI_CHECKPOINT == 1)
+/* flash range read by the open, also the header of its record in the checkpoint, followed by the data */
+typedef struct
+{
+	uint32_t address;
+	uint32_t size;
+} OSPI_CheckpointRangeTypeDef;
+
+/* header of the checkpoint, programmed once all the records are */
+typedef struct
+{
+	uint32_t magic;
+	uint32_t size;
+	uint32_t checksum;
+} OSPI_CheckpointHeaderTypeDef;
+#endif
+
+typedef struct OSPI_Context OSPI_ContextTypeDef;
+
+static OSPI_ContextTypeDef *ospi_context_of(OSPI_HandleTypeDef *hospi);
+static uint8_t ospi_memory_reset(OSPI_ContextTypeDef *ctx);
+static uint8_t ospi_configure(OSPI_ContextTypeDef *ctx);
+static uint8_t ospi_set_write_enable(OSPI_ContextTypeDef *ctx);
+static uint8_t ospi_auto_polling_ready(OSPI_ContextTypeDef *ctx, uint32_t timeout);
+static void ospi_cmd_fill(OSPI_CmdIdTypeDef id, uint32_t address, uint32_t nb_data, OSPI_RegularCmdTypeDef *sCommand);
+static uint8_t ospi_issue_cmd(OSPI_ContextTypeDef *ctx, OSPI_CmdIdTypeDef id, uint32_t address, uint32_t nb_data);
+static uint8_t ospi_read_reg(OSPI_ContextTypeDef *ctx, OSPI_CmdIdTypeDef id, uint8_t *reg, uint32_t size);
+static uint8_t ospi_write_reg(OSPI_ContextTypeDef *ctx, OSPI_CmdIdTypeDef id, uint8_t *reg, uint32_t size);
+static uint8_t ospi_transmit(OSPI_ContextTypeDef *ctx, uint8_t *buffer, uint32_t size);
+#if (LX_STM32_OSPI_MEMORY_MAPPED_READ == 0)
+static uint8_t ospi_receive(OSPI_ContextTypeDef *ctx, uint8_t *buffer, uint32_t size);
+static uint8_t ospi_read_indirect_start(OSPI_ContextTypeDef *ctx, uint32_t address, uint8_t *buffer, uint32_t size);
+static uint8_t ospi_read_indirect(OSPI_ContextTypeDef *ctx, uint32_t address, uint8_t *buffer, uint32_t size);
+#endif
+static UINT ospi_dma_eligible(uint8_t *buffer, uint32_t size);
+static void ospi_transfer_account(OSPI_ContextTypeDef *ctx, UINT path, uint32_t size, uint32_t cycles);
+static void ospi_op_account(OSPI_ContextTypeDef *ctx, UINT op, uint32_t bytes, uint32_t cycles);
+static uint8_t ospi_erase_done(OSPI_ContextTypeDef *ctx, uint8_t secr);
+static void ospi_erased_map_update(OSPI_ContextTypeDef *ctx, uint32_t address, uint32_t size, UINT erased);
+static UINT ospi_erased_map_test(OSPI_ContextTypeDef *ctx, uint32_t block);
+static uint8_t ospi_blank_check(OSPI_ContextTypeDef *ctx, uint32_t address, uint32_t size);
+#if (LX_STM32_OSPI_MEMORY_MAPPED_READ == 1)
+static uint8_t ospi_enter_memory_mapped(OSPI_ContextTypeDef *ctx);
+#endif
+static uint8_t ospi_leave_memory_mapped(OSPI_ContextTypeDef *ctx);
+static uint8_t ospi_wait_pending(OSPI_ContextTypeDef *ctx);
+static uint8_t ospi_poll_pending(OSPI_ContextTypeDef *ctx);
+static uint8_t ospi_pending_done(OSPI_ContextTypeDef *ctx, UINT kind);
+static void ospi_set_pending(OSPI_ContextTypeDef *ctx, UINT kind, uint32_t timeout);
+#if (LX_STM32_OSPI_STATUS_CACHE == 1)
+static void ospi_erase_sleep(OSPI_ContextTypeDef *ctx);
+#endif
+#if (OSPI_SUSPEND == 1)
+static uint8_t ospi_suspend_pending(OSPI_ContextTypeDef *ctx, uint32_t address, uint32_t size);
+static uint8_t ospi_resume_pending(OSPI_ContextTypeDef *ctx);
+#endif
+#if (LX_STM32_OSPI_DMA_API == 1)
+static uint8_t ospi_dma_init(OSPI_ContextTypeDef *ctx);
+#endif
+#if (LX_STM32_OSPI_CONTINUOUS_READ == 1)
+static uint8_t ospi_pe_exit(OSPI_ContextTypeDef *ctx);
+#endif
+static uint8_t ospi_program(OSPI_ContextTypeDef *ctx, uint32_t address, uint8_t *buffer, uint32_t size);
+#if (LX_STM32_OSPI_WRITE_COALESCE == 1)
+static uint8_t ospi_write_flush(OSPI_ContextTypeDef *ctx);
+static uint8_t ospi_write_coalesce(OSPI_ContextTypeDef *ctx, uint32_t address, uint8_t *buffer, uint32_t size, UINT *kept);
+#endif
+#if (OSPI_READ_AHEAD == 1)
+static uint8_t ospi_read_ahead_sync(OSPI_ContextTypeDef *ctx);
+static UINT ospi_read_ahead_lookup(OSPI_ContextTypeDef *ctx, uint32_t address, uint8_t *buffer, uint32_t size);
+static void ospi_read_ahead_next(OSPI_ContextTypeDef *ctx);
+static void ospi_read_ahead_invalidate(OSPI_ContextTypeDef *ctx, uint32_t address, uint32_t size);
+#endif
+#if (LX_STM32_OSPI_CHECKPOINT == 1)
+static uint8_t ospi_read_range(OSPI_ContextTypeDef *ctx, uint32_t address, uint8_t *buffer, uint32_t size);
+static uint32_t ospi_checkpoint_sum(uint32_t sum, const ULONG *words, uint32_t count);
+static void ospi_checkpoint_record(OSPI_ContextTypeDef *ctx, uint32_t address, uint32_t size);
+static void ospi_checkpoint_load(OSPI_ContextTypeDef *ctx);
+static uint8_t ospi_checkpoint_copy(OSPI_ContextTypeDef *ctx, uint32_t offset, uint8_t *buffer, uint32_t size);
+static UINT ospi_checkpoint_lookup(OSPI_ContextTypeDef *ctx, uint32_t address, uint8_t *buffer, uint32_t size);
+static uint8_t ospi_checkpoint_invalidate(OSPI_ContextTypeDef *ctx);
+static uint8_t ospi_checkpoint_flush(OSPI_ContextTypeDef *ctx, OSPI_CheckpointHeaderTypeDef *header, uint32_t size);
+static uint8_t ospi_checkpoint_save(OSPI_ContextTypeDef *ctx);
+#endif
 
 /* USER CODE BEGIN SECTOR_BUFFER */
 ULONG ospi_sector_buffer[LX_STM32_OSPI_SECTOR_SIZE / sizeof(ULONG)];
 /* USER CODE END SECTOR_BUFFER */
 
-TX_SEMAPHORE ospi_rx_semaphore;
-TX_SEMAPHORE ospi_tx_semaphore;
+TX_SEMAPHORE ospi_rx_semaphore[LX_STM32_OSPI_INSTANCE_COUNT];
+TX_SEMAPHORE ospi_tx_semaphore[LX_STM32_OSPI_INSTANCE_COUNT];
+
+LX_NOR_FLASH *lx_stm32_ospi_nor_flash = NULL;
+
+/* reads of the LevelX instance, accounted before the striping */
+static LX_STM32_OSPI_AREA_STATS ospi_area_stats;
+
+/* state of one OctoSPI instance and of the NOR memory behind it */
+struct OSPI_Context
+{
+	UINT                instance;
+	OSPI_HandleTypeDef *hospi;
+	uint32_t            mapped_base;
+
+#if (LX_STM32_OSPI_AUTO_POLLING_IT == 1)
+	/* released by HAL_OSPI_StatusMatchCallback when the awaited status is read by the auto-polling */
+	TX_SEMAPHORE        status_semaphore;
+#endif
+
+#if (LX_STM32_OSPI_DMA_API == 1)
+	DMA_Channel_TypeDef *dma_channel;
+	uint32_t            dma_request;
+	IRQn_Type           dma_irqn;
+	DMA_HandleTypeDef   dma_handle;
+#endif
+
+	LX_STM32_OSPI_TRANSFER_STATS transfer_stats;
+	LX_STM32_OSPI_OP_STATS op_stats[LX_STM32_OSPI_OP_COUNT];
+
+	/* set while the OctoSPI is configured in memory-mapped mode */
+	UINT                memory_mapped;
+#if (LX_STM32_OSPI_CONTINUOUS_READ == 1)
+	/* set while the memory may be in performance enhance mode */
+	UINT                pe_mode;
+#endif
+
+	/* set when a program or erase was issued and the end of operation (WIP cleared) is not yet checked */
+	UINT                busy_pending;
+	uint32_t            busy_timeout;
+#if (LX_STM32_OSPI_STATUS_CACHE == 1)
+	/* set once the failure bits were checked after the end of the last program or erase */
+	UINT                status_checked;
+#endif
+
+	/* flash range and start time of the pending erase */
+	uint32_t            erase_address;
+	uint32_t            erase_size;
+	uint32_t            erase_start;
+	/* tick count at the erase start, a bulk erase outlasts the cycle counter */
+	ULONG               erase_start_tick;
+#if (LX_STM32_OSPI_PROGRAM_SUSPEND == 1)
+	/* page of the pending program */
+	uint32_t            program_address;
+#endif
+
+	/* start time, source, destination and size of the read started by lx_stm32_ospi_read_start() */
+	uint32_t            read_start;
+	uint32_t            read_address;
+	ULONG              *read_buffer;
+	uint32_t            read_size;
+
+#if (OSPI_READ_AHEAD == 1)
+	/* read-ahead window holding ra_valid bytes of flash from ra_address, still being received while
+	 * ra_pending is set. ra_next is the end of the last read, a read starting there is sequential.
+	 */
+	ULONG               ra_buffer[LX_STM32_OSPI_READ_AHEAD_SIZE / sizeof(ULONG)];
+	uint32_t            ra_address;
+	uint32_t            ra_valid;
+	uint32_t            ra_next;
+	UINT                ra_pending;
+	/* set when the read started by lx_stm32_ospi_read_start() was served by the window */
+	UINT                read_hit;
+#endif
+
+	/* one bit per LevelX block, set while the block is known to be erased. Cleared on program,
+	 * set at the end of an erase or by a successful blank check, all unknown after reset.
+	 */
+	uint32_t            erased_map[(OSPI_BLOCK_COUNT + 31) / 32];
+
+#if (LX_STM32_OSPI_MEMORY_MAPPED_READ == 0)
+	/* destination of the blank check reads */
+	ULONG               blank_buffer[LX_STM32_OSPI_PAGE_SIZE / sizeof(ULONG)];
+#endif
+
+#if (OSPI_SUSPEND == 1)
+	/* set while the pending program or erase is suspended to serve a read */
+	UINT                suspended;
+	/* number of times the pending program or erase was suspended */
+	UINT                suspends;
+#endif
+
+#if (LX_STM32_OSPI_WRITE_COALESCE == 1)
+	/* wc_size bytes written at wc_address, not programmed yet */
+	ULONG               wc_buffer[LX_STM32_OSPI_PAGE_SIZE / sizeof(ULONG)];
+	uint32_t            wc_address;
+	uint32_t            wc_size;
+#endif
+
+#if (LX_STM32_OSPI_CHECKPOINT == 1)
+	/* state of the checkpoint in flash, loaded by the first read. cp_size bytes of records follow
+	 * the header, cp_next is the offset of the first record not reached by the reads yet and
+	 * cp_record the current one, its data at offset cp_data.
+	 */
+	UINT                cp_state;
+	uint32_t            cp_size;
+	uint32_t            cp_next;
+	OSPI_CheckpointRangeTypeDef cp_record;
+	uint32_t            cp_data;
+	/* cp_chunk_size bytes of records from offset cp_chunk_offset, also the staging buffer of the save */
+	ULONG               cp_chunk[LX_STM32_OSPI_CHECKPOINT_CHUNK / sizeof(ULONG)];
+	uint32_t            cp_chunk_offset;
+	uint32_t            cp_chunk_size;
+	/* ranges read since the init, recorded while cp_recording is set, cp_bytes of records once saved */
+	OSPI_CheckpointRangeTypeDef cp_ranges[LX_STM32_OSPI_CHECKPOINT_RANGES];
+	uint32_t            cp_count;
+	uint32_t            cp_bytes;
+	UINT                cp_recording;
+	/* set once the memory is programmed or erased */
+	UINT                cp_modified;
+	/* set when the read started by lx_stm32_ospi_read_start() was served by the checkpoint */
+	UINT                read_checkpoint;
+#endif
+};
+
+static OSPI_ContextTypeDef ospi_ctx[LX_STM32_OSPI_INSTANCE_COUNT] =
+{
+	[0] = {
+		.instance    = 0,
+		.hospi       = &ospi_handle,
+		.mapped_base = LX_STM32_OSPI_MEMORY_MAPPED_BASE,
+#if (LX_STM32_OSPI_DMA_API == 1)
+		.dma_channel = LX_STM32_OSPI_DMA_CHANNEL,
+		.dma_request = LX_STM32_OSPI_DMA_REQUEST,
+		.dma_irqn    = LX_STM32_OSPI_DMA_IRQn,
+#endif
+	},
+#if (LX_STM32_OSPI_INSTANCE_COUNT > 1)
+	[1] = {
+		.instance    = 1,
+		.hospi       = &ospi2_handle,
+		.mapped_base = LX_STM32_OSPI2_MEMORY_MAPPED_BASE,
+#if (LX_STM32_OSPI_DMA_API == 1)
+		.dma_channel = LX_STM32_OSPI2_DMA_CHANNEL,
+		.dma_request = LX_STM32_OSPI2_DMA_REQUEST,
+		.dma_irqn    = LX_STM32_OSPI2_DMA_IRQn,
+#endif
+	},
+#endif
+};
 
 
 /**
@@ -25,25 +408,66 @@ TX_SEMAPHORE ospi_tx_semaphore;
 */
 INT lx_stm32_ospi_lowlevel_init(UINT instance)
 {
+	OSPI_ContextTypeDef *ctx;
 	INT status = 0;
+	uint32_t start;
 
-	/* OSPI memory reset */
-	if (ospi_memory_reset(&ospi_handle) != 0)
+	if (instance >= LX_STM32_OSPI_INSTANCE_COUNT)
+	{
+		return 1;
+	}
+
+	ctx = &ospi_ctx[instance];
+
+	/* Enable the cycle counter used for the transfer accounting */
+	LX_STM32_OSPI_CYCLE_COUNTER_INIT();
+	start = LX_STM32_OSPI_CYCLE_COUNT();
+
+#if (LX_STM32_OSPI_AUTO_POLLING_IT == 1)
+	/* The status semaphore is needed by the memory reset below */
+	if (tx_semaphore_create(&ctx->status_semaphore, "ospi status match semaphore", 0) != TX_SUCCESS)
+	{
+		return 1;
+	}
+#endif
+
+#if (LX_STM32_OSPI_DMA_API == 1)
+	if (ospi_dma_init(ctx) != 0)
 	{
 		return 1;
 	}
+#endif
 
-	/* Enable octal mode */
-	if (ospi_set_quad_mode(&ospi_handle) != 0)
+	/* OSPI memory reset */
+	if (ospi_memory_reset(ctx) != 0)
 	{
 		return 1;
 	}
 
-	if(ospi_highperf_mode(&ospi_handle) != 0)
+#if (LX_STM32_OSPI_STATUS_CACHE == 1)
+	/* The memory state before the reset is unknown */
+	ctx->status_checked = 0;
+#endif
+
+	/* Enable the quad mode and the high performance mode, unless already set */
+	if (ospi_configure(ctx) != 0)
 	{
 		return 1;
 	}
 
+#if (LX_STM32_OSPI_CHECKPOINT == 1)
+	/* The checkpoint is loaded by the first read, the reads up to the first program or erase are recorded */
+	ctx->cp_state = OSPI_CHECKPOINT_UNKNOWN;
+	ctx->cp_record.size = 0;
+	ctx->cp_chunk_size = 0;
+	ctx->cp_count = 0;
+	ctx->cp_bytes = 0;
+	ctx->cp_recording = 1;
+	ctx->cp_modified = 0;
+#endif
+
+	ctx->transfer_stats.init_cycles = LX_STM32_OSPI_CYCLE_COUNT() - start;
+
 	return status;
 }
 
@@ -55,8 +479,58 @@ INT lx_stm32_ospi_lowlevel_init(UINT instance)
 */
 INT lx_stm32_ospi_lowlevel_deinit(UINT instance)
 {
+	OSPI_ContextTypeDef *ctx;
 	INT status = 0;
 
+	if (instance >= LX_STM32_OSPI_INSTANCE_COUNT)
+	{
+		return 1;
+	}
+
+	ctx = &ospi_ctx[instance];
+
+#if (OSPI_READ_AHEAD == 1)
+	/* The read-ahead in progress must complete before any other command */
+	if (ospi_read_ahead_sync(ctx) != OSPI_OK)
+	{
+		return 1;
+	}
+#endif
+
+#if (LX_STM32_OSPI_WRITE_COALESCE == 1)
+	/* Program the page kept in RAM first */
+	if (ospi_write_flush(ctx) != OSPI_OK)
+	{
+		return 1;
+	}
+#endif
+
+	/* Let the last program or erase complete */
+	if (ospi_wait_pending(ctx) != OSPI_OK)
+	{
+		return 1;
+	}
+
+#if (LX_STM32_OSPI_CHECKPOINT == 1)
+	/* Save the reads of this open for the next one, unless the checkpoint in flash still holds them */
+	if ((ctx->cp_count != 0) && ((ctx->cp_modified != 0) || (ctx->cp_state != OSPI_CHECKPOINT_VALID)))
+	{
+		if (ospi_checkpoint_save(ctx) != OSPI_OK)
+		{
+			return 1;
+		}
+	}
+#endif
+
+	if (ospi_leave_memory_mapped(ctx) != OSPI_OK)
+	{
+		return 1;
+	}
+
+#if (LX_STM32_OSPI_AUTO_POLLING_IT == 1)
+	tx_semaphore_delete(&ctx->status_semaphore);
+#endif
+
 	return status;
 }
 
@@ -67,69 +541,75 @@ INT lx_stm32_ospi_lowlevel_deinit(UINT instance)
 */
 INT lx_stm32_ospi_get_status(UINT instance)
 {
-	uint8_t reg;
-	OSPI_RegularCmdTypeDef sCommand;
-
-	/* Initialize the read security register command */
-	sCommand.OperationType      = HAL_OSPI_OPTYPE_COMMON_CFG;
-	sCommand.FlashId            = HAL_OSPI_FLASH_ID_1;
-	sCommand.Instruction        = READ_SEC_REG_CMD;
-	sCommand.InstructionMode    = HAL_OSPI_INSTRUCTION_1_LINE;
-	sCommand.InstructionSize    = HAL_OSPI_INSTRUCTION_8_BITS;
-	sCommand.InstructionDtrMode = HAL_OSPI_INSTRUCTION_DTR_DISABLE;
-	sCommand.AddressMode        = HAL_OSPI_ADDRESS_NONE;
-	sCommand.AlternateBytesMode = HAL_OSPI_ALTERNATE_BYTES_NONE;
-	sCommand.DataMode           = HAL_OSPI_DATA_1_LINE;
-	sCommand.NbData             = 1;
-	sCommand.DataDtrMode        = HAL_OSPI_DATA_DTR_DISABLE;
-	sCommand.DummyCycles        = 0;
-	sCommand.DQSMode            = HAL_OSPI_DQS_DISABLE;
-	sCommand.SIOOMode           = HAL_OSPI_SIOO_INST_EVERY_CMD;
+	OSPI_ContextTypeDef *ctx = &ospi_ctx[instance];
+	uint8_t reg, secr;
+	uint32_t start;
 
-	/* Configure the command */
-	if (HAL_OSPI_Command(&ospi_handle, &sCommand, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+#if (OSPI_READ_AHEAD == 1)
+	/* The read-ahead in progress must complete before any other command */
+	if (ospi_read_ahead_sync(ctx) != OSPI_OK)
 	{
 		return OSPI_ERROR;
 	}
+#endif
 
-	/* Reception of the data */
-	if (HAL_OSPI_Receive(&ospi_handle, &reg, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+	/* A deferred program or erase still in progress is waited for by the next operation,
+	 * the driver is ready to accept it. Once completed, its result is checked here.
+	 */
+	if (ctx->busy_pending != OSPI_PENDING_NONE)
 	{
-		return OSPI_ERROR;
+		return ospi_poll_pending(ctx);
 	}
 
-	/* Check the value of the register */
-	if ((reg & (MX25R6435F_SECR_P_FAIL | MX25R6435F_SECR_E_FAIL)) != 0)
+#if (LX_STM32_OSPI_STATUS_CACHE == 1)
+	/* Nothing was programmed or erased since the last check */
+	if (ctx->status_checked != 0)
 	{
-		return OSPI_ERROR;
+		ctx->transfer_stats.status_cached++;
+		return OSPI_OK;
 	}
-	else if ((reg & (MX25R6435F_SECR_PSB | MX25R6435F_SECR_ESB)) != 0)
+#endif
+
+	/* Register, program and erase commands are issued in indirect mode */
+	if (ospi_leave_memory_mapped(ctx) != OSPI_OK)
 	{
-		return OSPI_SUSPENDED;
+		return OSPI_ERROR;
 	}
 
-	/* Initialize the read status register command */
-	sCommand.Instruction = READ_STATUS_REG_CMD;
+	start = LX_STM32_OSPI_CYCLE_COUNT();
 
-	/* Configure the command */
-	if (HAL_OSPI_Command(&ospi_handle, &sCommand, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+	/* Read security register */
+	if (ospi_read_reg(ctx, OSPI_CMD_READ_SEC_REG, &secr, 1) != OSPI_OK)
 	{
 		return OSPI_ERROR;
 	}
 
-	/* Reception of the data */
-	if (HAL_OSPI_Receive(&ospi_handle, &reg, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+	/* Read status register */
+	if (ospi_read_reg(ctx, OSPI_CMD_READ_STATUS_REG, &reg, 1) != OSPI_OK)
 	{
 		return OSPI_ERROR;
 	}
 
-	/* Check the value of the register */
-	if ((reg & MX25R6435F_SR_WIP) != 0)
+	ospi_op_account(ctx, LX_STM32_OSPI_OP_STATUS, 2, LX_STM32_OSPI_CYCLE_COUNT() - start);
+
+	/* Check the value of the registers */
+	if ((secr & (MX25R6435F_SECR_P_FAIL | MX25R6435F_SECR_E_FAIL)) != 0)
+	{
+		return OSPI_ERROR;
+	}
+	else if ((secr & (MX25R6435F_SECR_PSB | MX25R6435F_SECR_ESB)) != 0)
+	{
+		return OSPI_SUSPENDED;
+	}
+	else if ((reg & MX25R6435F_SR_WIP) != 0)
 	{
 		return OSPI_BUSY;
 	}
 	else
 	{
+#if (LX_STM32_OSPI_STATUS_CACHE == 1)
+		ctx->status_checked = 1;
+#endif
 		return OSPI_OK;
 	}
 }
@@ -150,6 +630,11 @@ INT lx_stm32_ospi_get_info(UINT instance, ULONG *block_size, ULONG *total_blocks
 	*block_size = LX_STM32_OSPI_SECTOR_SIZE;
 	*total_blocks = (LX_STM32_OSPI_FLASH_SIZE / LX_STM32_OSPI_SECTOR_SIZE);
 
+#if (LX_STM32_OSPI_CHECKPOINT == 1)
+	/* The last blocks hold the checkpoint */
+	*total_blocks -= OSPI_CHECKPOINT_BLOCKS;
+#endif
+
 	return status;
 }
 
@@ -163,579 +648,2481 @@ INT lx_stm32_ospi_get_info(UINT instance, ULONG *block_size, ULONG *total_blocks
 */
 INT lx_stm32_ospi_read(UINT instance, ULONG *address, ULONG *buffer, ULONG words)
 {
-	OSPI_RegularCmdTypeDef sCommand;
-
-	/* Initialize the read command */
-	sCommand.OperationType         = HAL_OSPI_OPTYPE_COMMON_CFG;
-	sCommand.FlashId               = HAL_OSPI_FLASH_ID_1;
-	sCommand.Instruction           = QUAD_INOUT_READ_CMD;
-	sCommand.InstructionMode       = HAL_OSPI_INSTRUCTION_1_LINE;
-	sCommand.InstructionSize       = HAL_OSPI_INSTRUCTION_8_BITS;
-	sCommand.InstructionDtrMode    = HAL_OSPI_INSTRUCTION_DTR_DISABLE;
-	sCommand.Address               = (uint32_t)address;
-	sCommand.AddressMode           = HAL_OSPI_ADDRESS_4_LINES;
-	sCommand.AddressSize           = HAL_OSPI_ADDRESS_24_BITS;
-	sCommand.AddressDtrMode        = HAL_OSPI_ADDRESS_DTR_DISABLE;
-	sCommand.AlternateBytes        = MX25R6435F_ALT_BYTES_NO_PE_MODE;
-	sCommand.AlternateBytesMode    = HAL_OSPI_ALTERNATE_BYTES_4_LINES;
-	sCommand.AlternateBytesSize    = HAL_OSPI_ALTERNATE_BYTES_8_BITS;
-	sCommand.AlternateBytesDtrMode = HAL_OSPI_ALTERNATE_BYTES_DTR_DISABLE;
-	sCommand.DataMode              = HAL_OSPI_DATA_4_LINES;
-	sCommand.NbData                = words * sizeof(ULONG);
-	sCommand.DataDtrMode           = HAL_OSPI_DATA_DTR_DISABLE;
-	sCommand.DummyCycles           = MX25R6435F_DUMMY_CYCLES_READ_QUAD;
-	sCommand.DQSMode               = HAL_OSPI_DQS_DISABLE;
-	sCommand.SIOOMode              = HAL_OSPI_SIOO_INST_EVERY_CMD;
-
-	/* Configure the command */
-	if (HAL_OSPI_Command(&ospi_handle, &sCommand, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
-	{
-		return OSPI_ERROR;
-	}
+	/* Called by the LevelX driver, the address is the LevelX one */
+	lx_stm32_ospi_area_account(address, words);
 
-
-	/* Reception of the data */
-	if (HAL_OSPI_Receive_IT(&ospi_handle, (uint8_t*)buffer) != HAL_OK)
+	if (lx_stm32_ospi_read_start(instance, address, buffer, words) != OSPI_OK)
 	{
 		return OSPI_ERROR;
 	}
 
-	/* Check success of the transmission of the data */
-	if(tx_semaphore_get(&ospi_rx_semaphore, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != TX_SUCCESS)
+	if (lx_stm32_ospi_read_wait(instance) != OSPI_OK)
 	{
 		return OSPI_ERROR;
 	}
 
-	/* Release ospi_transfer_semaphore in case of writing success */
-	tx_semaphore_put(&ospi_rx_semaphore);
+	/* Release ospi_rx_semaphore, it is taken back by LX_STM32_OSPI_READ_CPLT_NOTIFY */
+	tx_semaphore_put(&ospi_rx_semaphore[instance]);
 
 	return OSPI_OK;
 }
 
 /**
-* @brief write a data buffer into the OSPI memory
+* @brief Start reading data from the OSPI memory, the read is completed by lx_stm32_ospi_read_wait().
+*        Reads of different instances can be in progress at the same time.
 * @param UINT instance OSPI instance
-* @param ULONG * address the start address to write into
-* @param ULONG * buffer the data source buffer
-* @param ULONG words the total number of words to be written
+* @param ULONG * address the start address to read from
+* @param ULONG * buffer the destination buffer
+* @param ULONG words the total number of words to be read
 * @retval 0 on Success 1 on Failure
 */
-INT lx_stm32_ospi_write(UINT instance, ULONG *address, ULONG *buffer, ULONG words)
+INT lx_stm32_ospi_read_start(UINT instance, ULONG *address, ULONG *buffer, ULONG words)
 {
-	uint32_t end_addr, current_size, current_addr, data_buffer;
-	OSPI_RegularCmdTypeDef sCommand;
-
-	/* Calculation of the size between the write address and the end of the page */
-	current_size = LX_STM32_OSPI_PAGE_SIZE - ((uint32_t)address % LX_STM32_OSPI_PAGE_SIZE);
-
-	/* Check if the size of the data is less than the remaining place in the page */
-	if (current_size > (((uint32_t) words) * sizeof(ULONG)))
+	OSPI_ContextTypeDef *ctx = &ospi_ctx[instance];
+	uint32_t size = words * sizeof(ULONG);
+
+	ctx->read_start = LX_STM32_OSPI_CYCLE_COUNT();
+	ctx->read_address = (uint32_t)address;
+	ctx->read_buffer = buffer;
+	ctx->read_size = size;
+
+#if (LX_STM32_OSPI_CHECKPOINT == 1)
+	ctx->read_checkpoint = 0;
+	ospi_checkpoint_record(ctx, (uint32_t)address, size);
+#endif
+
+#if (OSPI_READ_AHEAD == 1)
+	/* The read-ahead in progress must complete before any other command */
+	if (ospi_read_ahead_sync(ctx) != OSPI_OK)
 	{
-		current_size = ((uint32_t) words) * sizeof(ULONG);
+		return OSPI_ERROR;
 	}
+#endif
 
-	/* Initialize the adress variables */
-	current_addr = (uint32_t) address;
-	end_addr = ((uint32_t) address) + ((uint32_t) words) * sizeof(ULONG);
-	data_buffer= (uint32_t)buffer;
-
-	/* Initialize the program command */
-	sCommand.OperationType      = HAL_OSPI_OPTYPE_COMMON_CFG;
-	sCommand.FlashId            = HAL_OSPI_FLASH_ID_1;
-	sCommand.Instruction        = QUAD_PAGE_PROG_CMD;
-	sCommand.InstructionMode    = HAL_OSPI_INSTRUCTION_1_LINE;
-	sCommand.InstructionSize    = HAL_OSPI_INSTRUCTION_8_BITS;
-	sCommand.InstructionDtrMode = HAL_OSPI_INSTRUCTION_DTR_DISABLE;
-	sCommand.AddressMode        = HAL_OSPI_ADDRESS_4_LINES;
-	sCommand.AddressSize        = HAL_OSPI_ADDRESS_24_BITS;
-	sCommand.AddressDtrMode     = HAL_OSPI_ADDRESS_DTR_DISABLE;
-	sCommand.AlternateBytesMode = HAL_OSPI_ALTERNATE_BYTES_NONE;
-	sCommand.DataMode           = HAL_OSPI_DATA_4_LINES;
-	sCommand.DataDtrMode        = HAL_OSPI_DATA_DTR_DISABLE;
-	sCommand.DummyCycles        = 0;
-	sCommand.DQSMode            = HAL_OSPI_DQS_DISABLE;
-	sCommand.SIOOMode           = HAL_OSPI_SIOO_INST_EVERY_CMD;
-
-	/* Perform the write page by page */
-	do {
-		sCommand.Address = current_addr;
-		sCommand.NbData  = current_size;
-
-		/* Enable write operations */
-		if (ospi_set_write_enable(&ospi_handle) != OSPI_OK)
+#if (LX_STM32_OSPI_WRITE_COALESCE == 1)
+	/* The page kept in RAM is programmed before it is read back */
+	if ((ctx->wc_size != 0) && ((uint32_t)address < (ctx->wc_address + ctx->wc_size)) && (((uint32_t)address + size) > ctx->wc_address))
+	{
+		if (ospi_write_flush(ctx) != OSPI_OK)
 		{
 			return OSPI_ERROR;
 		}
+	}
+#endif
+
+#if (OSPI_READ_AHEAD == 1)
+	/* Data already in the window doesn't wait for a program or erase in progress,
+	 * the window is invalidated by the program or erase of its range.
+	 */
+	ctx->read_hit = ospi_read_ahead_lookup(ctx, (uint32_t)address, (uint8_t*)buffer, size);
+	if (ctx->read_hit)
+	{
+		return OSPI_OK;
+	}
+#endif
 
-		/* Configure the command */
-		if (HAL_OSPI_Command(&ospi_handle, &sCommand, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
-		{
-			return OSPI_ERROR;
-		}
+#if (LX_STM32_OSPI_CHECKPOINT == 1)
+	/* The metadata reads of the open are served by the checkpoint saved by the previous session */
+	if (ctx->cp_state == OSPI_CHECKPOINT_UNKNOWN)
+	{
+		ospi_checkpoint_load(ctx);
+	}
 
-		/* Transmission of the data */
-		if (HAL_OSPI_Transmit_IT(&ospi_handle, (uint8_t*)data_buffer)!= HAL_OK)
-		{
-			return OSPI_ERROR;
-		}
+	ctx->read_checkpoint = ospi_checkpoint_lookup(ctx, (uint32_t)address, (uint8_t*)buffer, size);
+	if (ctx->read_checkpoint)
+	{
+		return OSPI_OK;
+	}
+#endif
 
-	    /* Check success of the transmission of the data */
-	    if(tx_semaphore_get(&ospi_tx_semaphore, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != TX_SUCCESS)
-	    {
-			return OSPI_ERROR;
-	    }
+#if (OSPI_SUSPEND == 1)
+	/* Serve the read in the middle of the pending program or erase if it is outside its range */
+	if (ospi_suspend_pending(ctx, (uint32_t)address, size) != OSPI_OK)
+	{
+		return OSPI_ERROR;
+	}
 
-		/* Configure automatic polling mode to wait for end of program */
-		if (ospi_auto_polling_ready(&ospi_handle, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != OSPI_OK)
+	if (ctx->suspended == 0)
+#endif
+	{
+		/* The data can't be read while a program or erase is in progress */
+		if (ospi_wait_pending(ctx) != OSPI_OK)
 		{
 			return OSPI_ERROR;
 		}
+	}
 
-		/* Update the address and size variables for next page programming */
-		current_addr += current_size;
-		data_buffer += current_size;
-		current_size = ((current_addr + LX_STM32_OSPI_PAGE_SIZE) > end_addr) ? (end_addr - current_addr) : LX_STM32_OSPI_PAGE_SIZE;
-	} while (current_addr < end_addr);
+#if (LX_STM32_OSPI_MEMORY_MAPPED_READ == 1)
+	/* Switch back to memory-mapped mode if a command was issued since the last read */
+	if (ospi_enter_memory_mapped(ctx) != OSPI_OK)
+	{
+		return OSPI_ERROR;
+	}
 
-	/* Release ospi_transfer_semaphore in case of writing success */
-	tx_semaphore_put(&ospi_tx_semaphore);
+	memcpy(buffer, (void *)(ctx->mapped_base + (uint32_t)address), size);
+#else
+	if (ospi_read_indirect_start(ctx, (uint32_t)address, (uint8_t*)buffer, size) != OSPI_OK)
+	{
+		return OSPI_ERROR;
+	}
+#endif
 
 	return OSPI_OK;
 }
 
 /**
-* @brief Erase the whole flash or a single block
+* @brief Wait for the end of the read started by lx_stm32_ospi_read_start()
 * @param UINT instance OSPI instance
-* @param ULONG  block the block to be erased
-* @param ULONG  erase_count the number of times the block was erased
-* @param UINT full_chip_erase if set to 0 a single block is erased otherwise the whole flash is erased
 * @retval 0 on Success 1 on Failure
 */
-INT lx_stm32_ospi_erase(UINT instance, ULONG block, ULONG erase_count, UINT full_chip_erase)
+INT lx_stm32_ospi_read_wait(UINT instance)
 {
-	OSPI_RegularCmdTypeDef sCommand;
+	OSPI_ContextTypeDef *ctx = &ospi_ctx[instance];
 
-	/* Initialize the erase command */
-	sCommand.OperationType      = HAL_OSPI_OPTYPE_COMMON_CFG;
-	sCommand.FlashId            = HAL_OSPI_FLASH_ID_1;
-	sCommand.InstructionMode    = HAL_OSPI_INSTRUCTION_1_LINE;
-	sCommand.InstructionSize    = HAL_OSPI_INSTRUCTION_8_BITS;
-	sCommand.AlternateBytesMode = HAL_OSPI_ALTERNATE_BYTES_NONE;
-	sCommand.DataMode           = HAL_OSPI_DATA_NONE;
-	sCommand.DummyCycles        = 0;
-	sCommand.DQSMode            = HAL_OSPI_DQS_DISABLE;
-	sCommand.SIOOMode           = HAL_OSPI_SIOO_INST_EVERY_CMD;
-
-	/* DTR mode is enabled */
-	sCommand.InstructionDtrMode = HAL_OSPI_INSTRUCTION_DTR_DISABLE;
-
-	if(full_chip_erase)
+#if (LX_STM32_OSPI_CHECKPOINT == 1)
+	/* The data was copied from RAM by lx_stm32_ospi_read_start() */
+	if (ctx->read_checkpoint)
 	{
-		sCommand.Instruction        = CHIP_ERASE_CMD;
-		sCommand.AddressMode        = HAL_OSPI_ADDRESS_NONE;
+		ospi_op_account(ctx, LX_STM32_OSPI_OP_READ, ctx->read_size, LX_STM32_OSPI_CYCLE_COUNT() - ctx->read_start);
+		return OSPI_OK;
 	}
-	else
+#endif
+
+#if (LX_STM32_OSPI_MEMORY_MAPPED_READ == 1)
+	ospi_transfer_account(ctx, OSPI_TRANSFER_MAPPED, ctx->read_size, LX_STM32_OSPI_CYCLE_COUNT() - ctx->read_start);
+#else
+#if (OSPI_READ_AHEAD == 1)
+	if (ctx->read_hit == 0)
+#endif
 	{
-		sCommand.Instruction        = SECTOR_ERASE_CMD;
-		sCommand.Address            = (block * MX25R6435F_SECTOR_SIZE);
-		sCommand.AddressMode        = HAL_OSPI_ADDRESS_1_LINE;
-		sCommand.AddressSize        = HAL_OSPI_ADDRESS_24_BITS;
-		sCommand.AddressDtrMode     = HAL_OSPI_ADDRESS_DTR_DISABLE;	/* DTR mode is enabled */
-	}
+		/* Check success of the reception of the data */
+		if(tx_semaphore_get(&ospi_rx_semaphore[instance], HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != TX_SUCCESS)
+		{
+			return OSPI_ERROR;
+		}
 
-	/* Enable write operations */
-	if (ospi_set_write_enable(&ospi_handle) != OSPI_OK)
-	{
-		return OSPI_ERROR;
+		ospi_transfer_account(ctx, ospi_dma_eligible((uint8_t*)ctx->read_buffer, ctx->read_size), ctx->read_size,
+		                      LX_STM32_OSPI_CYCLE_COUNT() - ctx->read_start);
 	}
+#endif
 
-	/* Send the command */
-	if (HAL_OSPI_Command(&ospi_handle, &sCommand, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+#if (OSPI_SUSPEND == 1)
+	if (ospi_resume_pending(ctx) != OSPI_OK)
 	{
 		return OSPI_ERROR;
 	}
+#endif
 
-	/* Configure automatic polling mode to wait for end of erase */
-	if (ospi_auto_polling_ready(&ospi_handle, LX_STM32_OSPI_BULK_ERASE_MAX_TIME) != 0)
-	{
-		return 1;
-	}
+	ospi_op_account(ctx, LX_STM32_OSPI_OP_READ, ctx->read_size, LX_STM32_OSPI_CYCLE_COUNT() - ctx->read_start);
+
+#if (OSPI_READ_AHEAD == 1)
+	/* Fetch the data following a sequential read while the caller consumes this one */
+	ospi_read_ahead_next(ctx);
+#endif
 
 	return OSPI_OK;
 }
 
 /**
-* @brief Check that a block was actually erased
+* @brief write a data buffer into the OSPI memory
 * @param UINT instance OSPI instance
-* @param ULONG  block the block to be checked
+* @param ULONG * address the start address to write into
+* @param ULONG * buffer the data source buffer
+* @param ULONG words the total number of words to be written
 * @retval 0 on Success 1 on Failure
 */
-INT lx_stm32_ospi_is_block_erased(UINT instance, ULONG block)
+INT lx_stm32_ospi_write(UINT instance, ULONG *address, ULONG *buffer, ULONG words)
 {
-	OSPI_RegularCmdTypeDef sCommand;
-
-	/* Initialize the erase command */
-	sCommand.OperationType      = HAL_OSPI_OPTYPE_COMMON_CFG;
-	sCommand.FlashId            = HAL_OSPI_FLASH_ID_1;
-	sCommand.Instruction        = BLOCK_ERASE_CMD;
-	sCommand.InstructionMode    = HAL_OSPI_INSTRUCTION_1_LINE;
-	sCommand.InstructionSize    = HAL_OSPI_INSTRUCTION_8_BITS;
-	sCommand.InstructionDtrMode = HAL_OSPI_INSTRUCTION_DTR_DISABLE;
-	sCommand.Address            = block;
-	sCommand.AddressMode        = HAL_OSPI_ADDRESS_1_LINE;
-	sCommand.AddressSize        = HAL_OSPI_ADDRESS_24_BITS;
-	sCommand.AddressDtrMode     = HAL_OSPI_ADDRESS_DTR_DISABLE;
-	sCommand.AlternateBytesMode = HAL_OSPI_ALTERNATE_BYTES_NONE;
-	sCommand.DataMode           = HAL_OSPI_DATA_NONE;
-	sCommand.DummyCycles        = 0;
-	sCommand.DQSMode            = HAL_OSPI_DQS_DISABLE;
-	sCommand.SIOOMode           = HAL_OSPI_SIOO_INST_EVERY_CMD;
-
-	/* Enable write operations */
-	if (ospi_set_write_enable(&ospi_handle) != OSPI_OK)
+	if (lx_stm32_ospi_write_start(instance, address, buffer, words) != OSPI_OK)
 	{
 		return OSPI_ERROR;
 	}
 
-	/* Send the command */
-	if (HAL_OSPI_Command(&ospi_handle, &sCommand, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+#if (LX_STM32_OSPI_DEFERRED_BUSY_WAIT == 0)
+	/* Configure automatic polling mode to wait for end of program */
+	if (lx_stm32_ospi_wait_ready(instance) != OSPI_OK)
 	{
 		return OSPI_ERROR;
 	}
+#endif
 
-	/* Configure automatic polling mode to wait for end of erase */
-	if (ospi_auto_polling_ready(&ospi_handle, MX25R6435F_BLOCK_ERASE_MAX_TIME) != OSPI_OK)
-	{
-		return OSPI_ERROR;
-	}
+	/* Release ospi_transfer_semaphore in case of writing success */
+	tx_semaphore_put(&ospi_tx_semaphore[instance]);
 
 	return OSPI_OK;
 }
 
 /**
-* @brief Handle levelx system errors
-* @param UINT error_code Code of the concerned error.
-* @retval UINT error code.
+* @brief Program a data buffer into the OSPI memory, returning once the last page program is issued.
+*        The end of the program is waited for by the next access to the instance or by lx_stm32_ospi_wait_ready().
+*        With LX_STM32_OSPI_WRITE_COALESCE a small write may only be kept in RAM until lx_stm32_ospi_flush().
+* @param UINT instance OSPI instance
+* @param ULONG * address the start address to write into
+* @param ULONG * buffer the data source buffer
+* @param ULONG words the total number of words to be written
+* @retval 0 on Success 1 on Failure
 */
-
-UINT  lx_ospi_driver_system_error(UINT error_code)
-{
-	UINT status = LX_ERROR;
-
-	return status;
-}
-
-/**
-  * @brief  Reset the OSPI memory.
-  * @param  hospi: OSPI handle pointer
-  * @retval O on success 1 on Failure.
-  */
-static uint8_t ospi_memory_reset(OSPI_HandleTypeDef *hospi)
+INT lx_stm32_ospi_write_start(UINT instance, ULONG *address, ULONG *buffer, ULONG words)
 {
-	OSPI_RegularCmdTypeDef sCommand;
-
-	/* Initialize the reset enable command */
-	sCommand.OperationType      = HAL_OSPI_OPTYPE_COMMON_CFG;
-	sCommand.FlashId            = HAL_OSPI_FLASH_ID_1;
-	sCommand.Instruction        = RESET_ENABLE_CMD;
-	sCommand.InstructionMode    = HAL_OSPI_INSTRUCTION_1_LINE;
-	sCommand.InstructionSize    = HAL_OSPI_INSTRUCTION_8_BITS;
-	sCommand.InstructionDtrMode = HAL_OSPI_INSTRUCTION_DTR_DISABLE;
-	sCommand.AddressMode        = HAL_OSPI_ADDRESS_NONE;
-	sCommand.AlternateBytesMode = HAL_OSPI_ALTERNATE_BYTES_NONE;
-	sCommand.DataMode           = HAL_OSPI_DATA_NONE;
-	sCommand.DummyCycles        = 0;
-	sCommand.DQSMode            = HAL_OSPI_DQS_DISABLE;
-	sCommand.SIOOMode           = HAL_OSPI_SIOO_INST_EVERY_CMD;
-
-
-	/* Send the command */
-	if (HAL_OSPI_Command(hospi, &sCommand, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+	OSPI_ContextTypeDef *ctx = &ospi_ctx[instance];
+	uint32_t current_addr = (uint32_t) address;
+	uint32_t size = ((uint32_t) words) * sizeof(ULONG);
+#if (LX_STM32_OSPI_WRITE_COALESCE == 1)
+	UINT kept;
+#endif
+
+	/* Register, program and erase commands are issued in indirect mode */
+	if (ospi_leave_memory_mapped(ctx) != OSPI_OK)
 	{
 		return OSPI_ERROR;
 	}
 
-	/* Send the reset memory command */
-	sCommand.Instruction = RESET_MEMORY_CMD;
-	if (HAL_OSPI_Command(hospi, &sCommand, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+#if (OSPI_READ_AHEAD == 1)
+	/* The read-ahead in progress must complete before any other command */
+	if (ospi_read_ahead_sync(ctx) != OSPI_OK)
 	{
 		return OSPI_ERROR;
 	}
 
-	/* Configure automatic polling mode to wait the memory is ready */
-	if (ospi_auto_polling_ready(hospi, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != OSPI_OK)
+	ospi_read_ahead_invalidate(ctx, current_addr, size);
+#endif
+
+#if (LX_STM32_OSPI_CHECKPOINT == 1)
+	if (ospi_checkpoint_invalidate(ctx) != OSPI_OK)
 	{
 		return OSPI_ERROR;
 	}
+#endif
 
-	return OSPI_OK;
-}
-
-/**
-  * @brief  Send a Write Enable command and wait its effective.
-  * @param  hospi: OSPI handle pointer
-  * @retval O on success 1 on Failure.
-  */
-static uint8_t ospi_set_write_enable(OSPI_HandleTypeDef *hospi)
-{
-	OSPI_RegularCmdTypeDef sCommand;
-	OSPI_AutoPollingTypeDef sConfig;
+	/* The end of a pending erase marks its range erased: retire it before the blocks written are marked */
+	if ((ctx->busy_pending == OSPI_PENDING_ERASE) && (ospi_wait_pending(ctx) != OSPI_OK))
+	{
+		return OSPI_ERROR;
+	}
 
-	/* Enable write operations */
-	sCommand.OperationType      = HAL_OSPI_OPTYPE_COMMON_CFG;
-	sCommand.FlashId            = HAL_OSPI_FLASH_ID_1;
-	sCommand.Instruction        = WRITE_ENABLE_CMD;
-	sCommand.InstructionMode    = HAL_OSPI_INSTRUCTION_1_LINE;
-	sCommand.InstructionSize    = HAL_OSPI_INSTRUCTION_8_BITS;
-	sCommand.InstructionDtrMode = HAL_OSPI_INSTRUCTION_DTR_DISABLE;
-	sCommand.AddressMode        = HAL_OSPI_ADDRESS_NONE;
-	sCommand.AlternateBytesMode = HAL_OSPI_ALTERNATE_BYTES_NONE;
-	sCommand.DataMode           = HAL_OSPI_DATA_NONE;
-	sCommand.DummyCycles        = 0;
-	sCommand.DQSMode            = HAL_OSPI_DQS_DISABLE;
-	sCommand.SIOOMode           = HAL_OSPI_SIOO_INST_EVERY_CMD;
+	/* The blocks written are no longer blank */
+	ospi_erased_map_update(ctx, current_addr, size, 0);
 
-	if (HAL_OSPI_Command(hospi, &sCommand, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+#if (LX_STM32_OSPI_WRITE_COALESCE == 1)
+	/* A small write is kept in RAM, merged with the writes that continue it */
+	if (ospi_write_coalesce(ctx, current_addr, (uint8_t*)buffer, size, &kept) != OSPI_OK)
 	{
 		return OSPI_ERROR;
 	}
 
-	/* Configure automatic polling mode to wait for write enabling */
-	sConfig.Match         = MX25R6435F_SR_WEL;
-	sConfig.Mask          = MX25R6435F_SR_WEL;
-	sConfig.MatchMode     = HAL_OSPI_MATCH_MODE_AND;
-	sConfig.Interval      = 0x10;
-	sConfig.AutomaticStop = HAL_OSPI_AUTOMATIC_STOP_ENABLE;
+	if (kept)
+	{
+		return OSPI_OK;
+	}
+#endif
 
-	sCommand.Instruction  = READ_STATUS_REG_CMD;
-	sCommand.DataMode     = HAL_OSPI_DATA_1_LINE;
-	sCommand.NbData       = 1;
-	sCommand.DataDtrMode  = HAL_OSPI_DATA_DTR_DISABLE;
+	return ospi_program(ctx, current_addr, (uint8_t*)buffer, size);
+}
 
-	if (HAL_OSPI_Command(hospi, &sCommand, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+/**
+* @brief Erase the whole flash or a single block
+* @param UINT instance OSPI instance
+* @param ULONG  block the block to be erased
+* @param ULONG  erase_count the number of times the block was erased
+* @param UINT full_chip_erase if set to 0 a single block is erased otherwise the whole flash is erased
+* @retval 0 on Success 1 on Failure
+*/
+INT lx_stm32_ospi_erase(UINT instance, ULONG block, ULONG erase_count, UINT full_chip_erase)
+{
+	if (lx_stm32_ospi_erase_start(instance, block, full_chip_erase) != OSPI_OK)
 	{
 		return OSPI_ERROR;
 	}
 
-	if (HAL_OSPI_AutoPolling(hospi, &sConfig, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+#if (LX_STM32_OSPI_DEFERRED_BUSY_WAIT == 0)
+	/* Configure automatic polling mode to wait for end of erase */
+	if (lx_stm32_ospi_wait_ready(instance) != OSPI_OK)
 	{
-		return OSPI_ERROR;
+		return 1;
 	}
+#endif
 
 	return OSPI_OK;
 }
 
 /**
-  * @brief  Read the SR of the memory and wait the EOP.
-  * @param  hospi: OSPI handle pointer
+* @brief Issue the erase of the whole flash or of a single block, returning once the command is issued.
+*        The end of the erase is waited for by the next access to the instance or by lx_stm32_ospi_wait_ready().
+* @param UINT instance OSPI instance
+* @param ULONG  block the block to be erased
+* @param UINT full_chip_erase if set to 0 a single block is erased otherwise the whole flash is erased
+* @retval 0 on Success 1 on Failure
+*/
+INT lx_stm32_ospi_erase_start(UINT instance, ULONG block, UINT full_chip_erase)
+{
+	OSPI_ContextTypeDef *ctx = &ospi_ctx[instance];
+	OSPI_CmdIdTypeDef command;
+	uint32_t address, size, timeout;
+
+	if(full_chip_erase)
+	{
+		command = OSPI_CMD_CHIP_ERASE;
+		address = 0;
+		size = LX_STM32_OSPI_FLASH_SIZE;
+		timeout = LX_STM32_OSPI_BULK_ERASE_MAX_TIME;
+	}
+	else
+	{
+		/* A LevelX block is exactly one erase unit */
+		command = OSPI_CMD_ERASE_UNIT;
+		address = (block * LX_STM32_OSPI_SECTOR_SIZE);
+		size = LX_STM32_OSPI_SECTOR_SIZE;
+		timeout = LX_STM32_OSPI_ERASE_MAX_TIME;
+	}
+
+#if (OSPI_READ_AHEAD == 1)
+	/* The read-ahead in progress must complete before any other command */
+	if (ospi_read_ahead_sync(ctx) != OSPI_OK)
+	{
+		return OSPI_ERROR;
+	}
+
+	ospi_read_ahead_invalidate(ctx, address, size);
+#endif
+
+#if (LX_STM32_OSPI_WRITE_COALESCE == 1)
+	/* Program the page kept in RAM first */
+	if (ospi_write_flush(ctx) != OSPI_OK)
+	{
+		return OSPI_ERROR;
+	}
+#endif
+
+#if (LX_STM32_OSPI_CHECKPOINT == 1)
+	if (ospi_checkpoint_invalidate(ctx) != OSPI_OK)
+	{
+		return OSPI_ERROR;
+	}
+#endif
+
+	/* Wait for the end of the previous program or erase */
+	if (ospi_wait_pending(ctx) != OSPI_OK)
+	{
+		return OSPI_ERROR;
+	}
+
+	/* Register, program and erase commands are issued in indirect mode */
+	if (ospi_leave_memory_mapped(ctx) != OSPI_OK)
+	{
+		return OSPI_ERROR;
+	}
+
+	/* Enable write operations */
+	if (ospi_set_write_enable(ctx) != OSPI_OK)
+	{
+		return OSPI_ERROR;
+	}
+
+	/* The range is marked erased again once the end of erase is checked */
+	ospi_erased_map_update(ctx, address, size, 0);
+
+	ctx->erase_start = LX_STM32_OSPI_CYCLE_COUNT();
+	ctx->erase_start_tick = tx_time_get();
+
+	/* Send the command */
+	if (ospi_issue_cmd(ctx, command, address, 0) != OSPI_OK)
+	{
+		return OSPI_ERROR;
+	}
+
+	/* The end of erase is checked before the next command */
+	ospi_set_pending(ctx, OSPI_PENDING_ERASE, timeout);
+	ctx->erase_address = address;
+	ctx->erase_size = size;
+
+	return OSPI_OK;
+}
+
+/**
+* @brief Wait for the end of the program or erase in progress on the OSPI instance, if any
+* @param UINT instance OSPI instance
+* @retval 0 on Success 1 on Failure
+*/
+INT lx_stm32_ospi_wait_ready(UINT instance)
+{
+	OSPI_ContextTypeDef *ctx = &ospi_ctx[instance];
+
+#if (OSPI_READ_AHEAD == 1)
+	/* The read-ahead in progress must complete before any other command */
+	if (ospi_read_ahead_sync(ctx) != OSPI_OK)
+	{
+		return OSPI_ERROR;
+	}
+#endif
+
+	return ospi_wait_pending(ctx);
+}
+
+/**
+* @brief Program the data of the writes kept in RAM by the write coalescing, if any
+* @param UINT instance OSPI instance
+* @retval 0 on Success 1 on Failure
+*/
+INT lx_stm32_ospi_flush(UINT instance)
+{
+#if (LX_STM32_OSPI_WRITE_COALESCE == 1)
+	OSPI_ContextTypeDef *ctx = &ospi_ctx[instance];
+
+#if (OSPI_READ_AHEAD == 1)
+	/* The read-ahead in progress must complete before any other command */
+	if (ospi_read_ahead_sync(ctx) != OSPI_OK)
+	{
+		return OSPI_ERROR;
+	}
+#endif
+
+	if (ospi_leave_memory_mapped(ctx) != OSPI_OK)
+	{
+		return OSPI_ERROR;
+	}
+
+	return ospi_write_flush(ctx);
+#else
+	return OSPI_OK;
+#endif
+}
+
+/**
+* @brief Check that a block was actually erased
+* @param UINT instance OSPI instance
+* @param ULONG  block the block to be checked
+* @retval 0 on Success 1 on Failure
+*/
+INT lx_stm32_ospi_is_block_erased(UINT instance, ULONG block)
+{
+	OSPI_ContextTypeDef *ctx = &ospi_ctx[instance];
+	if (block >= OSPI_BLOCK_COUNT)
+	{
+		return OSPI_ERROR;
+	}
+
+#if (OSPI_READ_AHEAD == 1)
+	/* The read-ahead in progress must complete before any other command */
+	if (ospi_read_ahead_sync(ctx) != OSPI_OK)
+	{
+		return OSPI_ERROR;
+	}
+#endif
+
+#if (LX_STM32_OSPI_WRITE_COALESCE == 1)
+	/* Program the page kept in RAM first */
+	if (ospi_write_flush(ctx) != OSPI_OK)
+	{
+		return OSPI_ERROR;
+	}
+#endif
+
+	/* Wait for the end of the previous program or erase, the end of an erase of this block marks it erased */
+	if (ospi_wait_pending(ctx) != OSPI_OK)
+	{
+		return OSPI_ERROR;
+	}
+
+	ctx->transfer_stats.blank_checks++;
+
+	if (ospi_erased_map_test(ctx, block))
+	{
+		return OSPI_OK;
+	}
+
+	/* Unknown state, read the block back */
+	ctx->transfer_stats.blank_check_reads++;
+
+	if (ospi_blank_check(ctx, block * LX_STM32_OSPI_SECTOR_SIZE, LX_STM32_OSPI_SECTOR_SIZE) != OSPI_OK)
+	{
+		return OSPI_ERROR;
+	}
+
+	ospi_erased_map_update(ctx, block * LX_STM32_OSPI_SECTOR_SIZE, LX_STM32_OSPI_SECTOR_SIZE, 1);
+
+	return OSPI_OK;
+}
+
+/**
+* @brief Handle levelx system errors
+* @param UINT error_code Code of the concerned error.
+* @retval UINT error code.
+*/
+
+UINT  lx_ospi_driver_system_error(UINT error_code)
+{
+	UINT status = LX_ERROR;
+
+	return status;
+}
+
+/**
+* @brief Get the data transfer accounting of the OSPI instance
+* @param UINT instance OSPI instance
+* @param LX_STM32_OSPI_TRANSFER_STATS * stats pointer to be filled with a copy of the counters
+* @retval None
+*/
+VOID lx_stm32_ospi_get_transfer_stats(UINT instance, LX_STM32_OSPI_TRANSFER_STATS *stats)
+{
+	OSPI_ContextTypeDef *ctx = &ospi_ctx[instance];
+	TX_INTERRUPT_SAVE_AREA
+
+	TX_DISABLE
+	*stats = ctx->transfer_stats;
+	TX_RESTORE
+}
+
+/**
+* @brief Clear the data transfer accounting of the OSPI instance
+* @param UINT instance OSPI instance
+* @retval None
+*/
+VOID lx_stm32_ospi_reset_transfer_stats(UINT instance)
+{
+	OSPI_ContextTypeDef *ctx = &ospi_ctx[instance];
+	TX_INTERRUPT_SAVE_AREA
+
+	TX_DISABLE
+	memset(&ctx->transfer_stats, 0, sizeof(ctx->transfer_stats));
+	TX_RESTORE
+}
+
+/**
+* @brief Get the accounting of a flash operation of the OSPI instance
+* @param UINT instance OSPI instance
+* @param UINT op one of LX_STM32_OSPI_OP
+* @param LX_STM32_OSPI_OP_STATS * stats pointer to be filled with a copy of the counters
+* @retval None
+*/
+VOID lx_stm32_ospi_get_op_stats(UINT instance, UINT op, LX_STM32_OSPI_OP_STATS *stats)
+{
+	OSPI_ContextTypeDef *ctx = &ospi_ctx[instance];
+	TX_INTERRUPT_SAVE_AREA
+
+	if (op >= LX_STM32_OSPI_OP_COUNT)
+	{
+		memset(stats, 0, sizeof(*stats));
+		return;
+	}
+
+	TX_DISABLE
+	*stats = ctx->op_stats[op];
+	TX_RESTORE
+}
+
+/**
+* @brief Clear the flash operation accounting of the OSPI instance
+* @param UINT instance OSPI instance
+* @retval None
+*/
+VOID lx_stm32_ospi_reset_op_stats(UINT instance)
+{
+	OSPI_ContextTypeDef *ctx = &ospi_ctx[instance];
+	TX_INTERRUPT_SAVE_AREA
+
+	TX_DISABLE
+	memset(ctx->op_stats, 0, sizeof(ctx->op_stats));
+	TX_RESTORE
+}
+
+/**
+* @brief Account a LevelX read in the area of the block it starts in
+* @param ULONG * address LevelX address of the read
+* @param ULONG words the total number of words read
+* @retval None
+*/
+VOID lx_stm32_ospi_area_account(ULONG *address, ULONG words)
+{
+	LX_NOR_FLASH *nor_flash = lx_stm32_ospi_nor_flash;
+	ULONG offset;
+	UINT area;
+	TX_INTERRUPT_SAVE_AREA
+
+	if ((nor_flash == NULL) || (nor_flash->lx_nor_flash_words_per_block == 0))
+	{
+		return;
+	}
+
+	/* Offset in the block, in words as the LevelX block layout */
+	offset = (((ULONG)address - (ULONG)nor_flash->lx_nor_flash_base_address) / sizeof(ULONG)) % nor_flash->lx_nor_flash_words_per_block;
+
+	if (offset < nor_flash->lx_nor_flash_block_physical_sector_mapping_offset)
+	{
+		area = LX_STM32_OSPI_AREA_HEADER;
+	}
+	else if (offset < nor_flash->lx_nor_flash_block_physical_sector_offset)
+	{
+		area = LX_STM32_OSPI_AREA_MAPPING;
+	}
+	else
+	{
+		area = LX_STM32_OSPI_AREA_DATA;
+	}
+
+	TX_DISABLE
+	ospi_area_stats.reads[area]++;
+	ospi_area_stats.bytes[area] += words * sizeof(ULONG);
+	TX_RESTORE
+}
+
+/**
+* @brief Get the LevelX reads by block area
+* @param LX_STM32_OSPI_AREA_STATS * stats filled with a snapshot of the accounting
+* @retval None
+*/
+VOID lx_stm32_ospi_get_area_stats(LX_STM32_OSPI_AREA_STATS *stats)
+{
+	TX_INTERRUPT_SAVE_AREA
+
+	TX_DISABLE
+	*stats = ospi_area_stats;
+	TX_RESTORE
+}
+
+/**
+* @brief Clear the LevelX reads by block area
+* @retval None
+*/
+VOID lx_stm32_ospi_reset_area_stats(VOID)
+{
+	TX_INTERRUPT_SAVE_AREA
+
+	TX_DISABLE
+	memset(&ospi_area_stats, 0, sizeof(ospi_area_stats));
+	TX_RESTORE
+}
+
+/**
+  * @brief  Reset the OSPI memory.
+  * @param  ctx: driver context of the OSPI instance
+  * @retval O on success 1 on Failure.
+  */
+static uint8_t ospi_memory_reset(OSPI_ContextTypeDef *ctx)
+{
+#if (LX_STM32_OSPI_CONTINUOUS_READ == 1)
+	/* The memory is still in performance enhance mode after a reset of the MCU alone */
+	if (ospi_pe_exit(ctx) != OSPI_OK)
+	{
+		return OSPI_ERROR;
+	}
+#endif
+
+	/* Send the reset enable command */
+	if (ospi_issue_cmd(ctx, OSPI_CMD_RESET_ENABLE, 0, 0) != OSPI_OK)
+	{
+		return OSPI_ERROR;
+	}
+
+	/* Send the reset memory command */
+	if (ospi_issue_cmd(ctx, OSPI_CMD_RESET_MEMORY, 0, 0) != OSPI_OK)
+	{
+		return OSPI_ERROR;
+	}
+
+	/* Configure automatic polling mode to wait the memory is ready */
+	if (ospi_auto_polling_ready(ctx, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != OSPI_OK)
+	{
+		return OSPI_ERROR;
+	}
+
+	return OSPI_OK;
+}
+
+/**
+  * @brief  Send a Write Enable command and wait its effective.
+  * @param  ctx: driver context of the OSPI instance
+  * @retval O on success 1 on Failure.
+  */
+static uint8_t ospi_set_write_enable(OSPI_ContextTypeDef *ctx)
+{
+	OSPI_AutoPollingTypeDef sConfig;
+	uint32_t start = LX_STM32_OSPI_CYCLE_COUNT();
+
+	/* Enable write operations */
+	if (ospi_issue_cmd(ctx, OSPI_CMD_WRITE_ENABLE, 0, 0) != OSPI_OK)
+	{
+		return OSPI_ERROR;
+	}
+
+	/* Configure automatic polling mode to wait for write enabling */
+	sConfig.Match         = MX25R6435F_SR_WEL;
+	sConfig.Mask          = MX25R6435F_SR_WEL;
+	sConfig.MatchMode     = HAL_OSPI_MATCH_MODE_AND;
+	sConfig.Interval      = 0x10;
+	sConfig.AutomaticStop = HAL_OSPI_AUTOMATIC_STOP_ENABLE;
+
+	if (ospi_issue_cmd(ctx, OSPI_CMD_READ_STATUS_REG, 0, 1) != OSPI_OK)
+	{
+		return OSPI_ERROR;
+	}
+
+	if (HAL_OSPI_AutoPolling(ctx->hospi, &sConfig, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+	{
+		return OSPI_ERROR;
+	}
+
+	ospi_op_account(ctx, LX_STM32_OSPI_OP_WRITE_ENABLE, 0, LX_STM32_OSPI_CYCLE_COUNT() - start);
+
+	return OSPI_OK;
+}
+
+/**
+  * @brief  Read the SR of the memory and wait the EOP.
+  * @param  ctx: driver context of the OSPI instance
   * @param  timeout: timeout value before returning an error
   * @retval O on success 1 on Failure.
   */
-static uint8_t ospi_auto_polling_ready(OSPI_HandleTypeDef *hospi, uint32_t timeout)
+static uint8_t ospi_auto_polling_ready(OSPI_ContextTypeDef *ctx, uint32_t timeout)
+{
+	OSPI_AutoPollingTypeDef sConfig;
+	uint32_t start = LX_STM32_OSPI_CYCLE_COUNT();
+
+	/* Configure automatic polling mode to wait for memory ready */
+	sConfig.Match         = 0;
+	sConfig.Mask          = MX25R6435F_SR_WIP;
+	sConfig.MatchMode     = HAL_OSPI_MATCH_MODE_AND;
+	sConfig.Interval      = 0x10;
+	sConfig.AutomaticStop = HAL_OSPI_AUTOMATIC_STOP_ENABLE;
+
+	if (ospi_issue_cmd(ctx, OSPI_CMD_READ_STATUS_REG, 0, 1) != OSPI_OK)
+	{
+		return OSPI_ERROR;
+	}
+
+#if (LX_STM32_OSPI_AUTO_POLLING_IT == 1)
+	/* The polling is done by the OctoSPI, the calling thread sleeps until the status match */
+	if (HAL_OSPI_AutoPolling_IT(ctx->hospi, &sConfig) != HAL_OK)
+	{
+		return OSPI_ERROR;
+	}
+
+	if (tx_semaphore_get(&ctx->status_semaphore, LX_STM32_OSPI_MS_TO_TICKS(timeout)) != TX_SUCCESS)
+	{
+		/* Stop the polling, the memory is still busy */
+		HAL_OSPI_Abort(ctx->hospi);
+		return OSPI_ERROR;
+	}
+#else
+	if (HAL_OSPI_AutoPolling(ctx->hospi, &sConfig, timeout) != HAL_OK)
+	{
+		return OSPI_ERROR;
+	}
+#endif
+
+	ospi_op_account(ctx, LX_STM32_OSPI_OP_POLL, 0, LX_STM32_OSPI_CYCLE_COUNT() - start);
+
+	return OSPI_OK;
+}
+
+/**
+  * @brief  Set the QE bit and the high performance mode of the memory. Both are non-volatile,
+  *         the registers are read once and only written when a bit is missing, both bits at once.
+  * @param  ctx: driver context of the OSPI instance
+  * @retval O on success 1 on Failure.
+  */
+static uint8_t ospi_configure(OSPI_ContextTypeDef *ctx)
+{
+	uint8_t reg[3];
+
+	/* Read status register */
+	if (ospi_read_reg(ctx, OSPI_CMD_READ_STATUS_REG, &(reg[0]), 1) != OSPI_OK)
+	{
+		return OSPI_ERROR;
+	}
+
+	/* Read configuration registers */
+	if (ospi_read_reg(ctx, OSPI_CMD_READ_CFG_REG, &(reg[1]), 2) != OSPI_OK)
+	{
+		return OSPI_ERROR;
+	}
+
+	ctx->transfer_stats.init_status_writes = 0;
+	ctx->transfer_stats.init_status_writes_saved = 2;
+
+	if ((READ_BIT(reg[0], MX25R6435F_SR_QE) == 0) || (READ_BIT(reg[2], MX25R6435F_CR2_LH_SWITCH) == 0))
+	{
+		/* Enable write operations */
+		if (ospi_set_write_enable(ctx) != OSPI_OK)
+		{
+			return OSPI_ERROR;
+		}
+
+		SET_BIT(reg[0], MX25R6435F_SR_QE);
+		SET_BIT(reg[2], MX25R6435F_CR2_LH_SWITCH);
+
+		if (ospi_write_reg(ctx, OSPI_CMD_WRITE_STATUS_CFG_REG, &(reg[0]), 3) != OSPI_OK)
+		{
+			return OSPI_ERROR;
+		}
+
+		ctx->transfer_stats.init_status_writes = 1;
+		ctx->transfer_stats.init_status_writes_saved = 1;
+
+		/* Wait that memory is ready */
+		if (ospi_auto_polling_ready(ctx, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != OSPI_OK)
+		{
+			return OSPI_ERROR;
+		}
+
+		/* Check the configuration has been correctly done */
+		if ((ospi_read_reg(ctx, OSPI_CMD_READ_STATUS_REG, &(reg[0]), 1) != OSPI_OK) ||
+		    (ospi_read_reg(ctx, OSPI_CMD_READ_CFG_REG, &(reg[1]), 2) != OSPI_OK))
+		{
+			return OSPI_ERROR;
+		}
+
+		if ((READ_BIT(reg[0], MX25R6435F_SR_QE) == 0) || (READ_BIT(reg[2], MX25R6435F_CR2_LH_SWITCH) == 0))
+		{
+			return OSPI_ERROR;
+		}
+	}
+
+	return OSPI_OK;
+}
+
+/**
+  * @brief  Fill a HAL regular command from the command table.
+  * @param  id: command index in ospi_cmd_table
+  * @param  address: address phase value, unused if the command has no address
+  * @param  nb_data: number of data bytes, unused if the command has no data phase
+  * @param  sCommand: HAL command to fill
+  * @retval None
+  */
+static void ospi_cmd_fill(OSPI_CmdIdTypeDef id, uint32_t address, uint32_t nb_data, OSPI_RegularCmdTypeDef *sCommand)
+{
+	const OSPI_CmdDescTypeDef *desc = &ospi_cmd_table[id];
+
+	sCommand->OperationType         = HAL_OSPI_OPTYPE_COMMON_CFG;
+	sCommand->FlashId               = HAL_OSPI_FLASH_ID_1;
+	sCommand->Instruction           = desc->instruction;
+	sCommand->InstructionMode       = desc->ccr & OCTOSPI_CCR_IMODE;
+	sCommand->InstructionSize       = desc->ccr & OCTOSPI_CCR_ISIZE;
+	sCommand->InstructionDtrMode    = HAL_OSPI_INSTRUCTION_DTR_DISABLE;
+	sCommand->Address               = address;
+	sCommand->AddressMode           = desc->ccr & OCTOSPI_CCR_ADMODE;
+	sCommand->AddressSize           = desc->ccr & OCTOSPI_CCR_ADSIZE;
+	sCommand->AddressDtrMode        = HAL_OSPI_ADDRESS_DTR_DISABLE;
+	sCommand->AlternateBytes        = desc->alternate;
+	sCommand->AlternateBytesMode    = desc->ccr & OCTOSPI_CCR_ABMODE;
+	sCommand->AlternateBytesSize    = desc->ccr & OCTOSPI_CCR_ABSIZE;
+	sCommand->AlternateBytesDtrMode = HAL_OSPI_ALTERNATE_BYTES_DTR_DISABLE;
+	sCommand->DataMode              = desc->ccr & OCTOSPI_CCR_DMODE;
+	sCommand->NbData                = nb_data;
+	sCommand->DataDtrMode           = HAL_OSPI_DATA_DTR_DISABLE;
+	sCommand->DummyCycles           = desc->dummy_cycles;
+	sCommand->DQSMode               = HAL_OSPI_DQS_DISABLE;
+	sCommand->SIOOMode              = desc->ccr & OCTOSPI_CCR_SIOO;
+}
+
+/**
+  * @brief  Issue a command of the command table in indirect mode.
+  *         Commands with a data phase are followed by a HAL transfer or auto-polling call,
+  *         the others are complete on return.
+  * @param  ctx: driver context of the OSPI instance
+  * @param  id: command index in ospi_cmd_table
+  * @param  address: address phase value, unused if the command has no address
+  * @param  nb_data: number of data bytes, unused if the command has no data phase
+  * @retval O on success 1 on Failure.
+  */
+static uint8_t ospi_issue_cmd(OSPI_ContextTypeDef *ctx, OSPI_CmdIdTypeDef id, uint32_t address, uint32_t nb_data)
+{
+	uint32_t start;
+#if (LX_STM32_OSPI_DIRECT_CMD == 1)
+	const OSPI_CmdDescTypeDef *desc = &ospi_cmd_table[id];
+	OCTOSPI_TypeDef *regs = ctx->hospi->Instance;
+	uint32_t tickstart;
+#else
+	OSPI_RegularCmdTypeDef sCommand;
+#endif
+
+#if (LX_STM32_OSPI_CONTINUOUS_READ == 1)
+	/* A memory in performance enhance mode would take the instruction for an address */
+	if ((ctx->pe_mode != 0) && (id != OSPI_CMD_QUAD_INOUT_READ_CONT))
+	{
+		if (ospi_pe_exit(ctx) != OSPI_OK)
+		{
+			return OSPI_ERROR;
+		}
+	}
+#endif
+
+	start = LX_STM32_OSPI_CYCLE_COUNT();
+
+#if (LX_STM32_OSPI_DIRECT_CMD == 1)
+	tickstart = HAL_GetTick();
+
+	if (ctx->hospi->State != HAL_OSPI_STATE_READY)
+	{
+		return OSPI_ERROR;
+	}
+
+	/* Wait till the previous command is over */
+	while ((regs->SR & OCTOSPI_SR_BUSY) != 0)
+	{
+		if ((HAL_GetTick() - tickstart) > HAL_OSPI_TIMEOUT_DEFAULT_VALUE)
+		{
+			return OSPI_ERROR;
+		}
+	}
+
+	/* Same register sequence as HAL_OSPI_Command, the command starts on the last IR/AR write */
+	CLEAR_BIT(regs->CR, OCTOSPI_CR_FMODE);
+
+	if ((desc->ccr & OCTOSPI_CCR_DMODE) != 0)
+	{
+		regs->DLR = nb_data - 1;
+	}
+
+	MODIFY_REG(regs->TCR, OCTOSPI_TCR_DCYC, desc->dummy_cycles);
+
+	if ((desc->ccr & OCTOSPI_CCR_ABMODE) != 0)
+	{
+		regs->ABR = desc->alternate;
+	}
+
+	regs->CCR = desc->ccr;
+	regs->IR  = desc->instruction;
+
+	if ((desc->ccr & OCTOSPI_CCR_ADMODE) != 0)
+	{
+		regs->AR = address;
+	}
+
+	if ((desc->ccr & OCTOSPI_CCR_DMODE) != 0)
+	{
+		/* The data phase is started by the HAL transfer or auto-polling function */
+		ctx->hospi->ErrorCode = HAL_OSPI_ERROR_NONE;
+		ctx->hospi->State     = HAL_OSPI_STATE_CMD_CFG;
+	}
+	else
+	{
+		/* Wait for the end of the command */
+		while ((regs->SR & OCTOSPI_SR_TCF) == 0)
+		{
+			if ((HAL_GetTick() - tickstart) > HAL_OSPI_TIMEOUT_DEFAULT_VALUE)
+			{
+				return OSPI_ERROR;
+			}
+		}
+
+		regs->FCR = OCTOSPI_FCR_CTCF;
+	}
+#else
+	ospi_cmd_fill(id, address, nb_data, &sCommand);
+
+	if (HAL_OSPI_Command(ctx->hospi, &sCommand, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+	{
+		return OSPI_ERROR;
+	}
+#endif
+
+	/* Only called from the LevelX thread, no need to lock the counters */
+	ctx->transfer_stats.commands++;
+	ctx->transfer_stats.command_cycles += LX_STM32_OSPI_CYCLE_COUNT() - start;
+
+	return OSPI_OK;
+}
+
+/**
+  * @brief  Read a register of the memory in polling mode.
+  * @param  ctx: driver context of the OSPI instance
+  * @param  id: register read command index in ospi_cmd_table
+  * @param  reg: destination of the register value
+  * @param  size: number of bytes to read
+  * @retval O on success 1 on Failure.
+  */
+static uint8_t ospi_read_reg(OSPI_ContextTypeDef *ctx, OSPI_CmdIdTypeDef id, uint8_t *reg, uint32_t size)
+{
+	if (ospi_issue_cmd(ctx, id, 0, size) != OSPI_OK)
+	{
+		return OSPI_ERROR;
+	}
+
+	if (HAL_OSPI_Receive(ctx->hospi, reg, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+	{
+		return OSPI_ERROR;
+	}
+
+	return OSPI_OK;
+}
+
+/**
+  * @brief  Write a register of the memory in polling mode, the write enable is up to the caller.
+  * @param  ctx: driver context of the OSPI instance
+  * @param  id: register write command index in ospi_cmd_table
+  * @param  reg: register value to write
+  * @param  size: number of bytes to write
+  * @retval O on success 1 on Failure.
+  */
+static uint8_t ospi_write_reg(OSPI_ContextTypeDef *ctx, OSPI_CmdIdTypeDef id, uint8_t *reg, uint32_t size)
+{
+	if (ospi_issue_cmd(ctx, id, 0, size) != OSPI_OK)
+	{
+		return OSPI_ERROR;
+	}
+
+	if (HAL_OSPI_Transmit(ctx->hospi, reg, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+	{
+		return OSPI_ERROR;
+	}
+
+	return OSPI_OK;
+}
+
+#if (LX_STM32_OSPI_MEMORY_MAPPED_READ == 0)
+/**
+  * @brief  Start reading data from the memory in indirect mode, completion is notified by HAL_OSPI_RxCpltCallback.
+  * @param  ctx: driver context of the OSPI instance
+  * @param  address: flash address to read from
+  * @param  buffer: destination buffer
+  * @param  size: number of bytes to read
+  * @retval O on success 1 on Failure.
+  */
+static uint8_t ospi_read_indirect_start(OSPI_ContextTypeDef *ctx, uint32_t address, uint8_t *buffer, uint32_t size)
+{
+	OSPI_CmdIdTypeDef command = OSPI_CMD_QUAD_INOUT_READ;
+
+	if (ospi_leave_memory_mapped(ctx) != OSPI_OK)
+	{
+		return OSPI_ERROR;
+	}
+
+#if (LX_STM32_OSPI_CONTINUOUS_READ == 1)
+	/* The first read enters the performance enhance mode, the next ones skip the instruction */
+	command = (ctx->pe_mode != 0) ? OSPI_CMD_QUAD_INOUT_READ_CONT : OSPI_CMD_QUAD_INOUT_READ_PE;
+	ctx->pe_mode = 1;
+#endif
+
+	/* Configure the command */
+	if (ospi_issue_cmd(ctx, command, address, size) != OSPI_OK)
+	{
+#if (LX_STM32_OSPI_CONTINUOUS_READ == 1)
+		/* The mode of the memory is unknown, leave the performance enhance mode anyway */
+		ospi_pe_exit(ctx);
+#endif
+		return OSPI_ERROR;
+	}
+
+	/* Reception of the data */
+	if (ospi_receive(ctx, buffer, size) != OSPI_OK)
+	{
+		return OSPI_ERROR;
+	}
+
+	return OSPI_OK;
+}
+
+/**
+  * @brief  Read data from the memory in indirect mode and wait for the end of the transfer.
+  * @param  ctx: driver context of the OSPI instance
+  * @param  address: flash address to read from
+  * @param  buffer: destination buffer
+  * @param  size: number of bytes to read
+  * @retval O on success 1 on Failure.
+  */
+static uint8_t ospi_read_indirect(OSPI_ContextTypeDef *ctx, uint32_t address, uint8_t *buffer, uint32_t size)
+{
+	if (ospi_read_indirect_start(ctx, address, buffer, size) != OSPI_OK)
+	{
+		return OSPI_ERROR;
+	}
+
+	/* Check success of the reception of the data */
+	if(tx_semaphore_get(&ospi_rx_semaphore[ctx->instance], HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != TX_SUCCESS)
+	{
+		return OSPI_ERROR;
+	}
+
+	return OSPI_OK;
+}
+#endif
+
+#if (LX_STM32_OSPI_MEMORY_MAPPED_READ == 1)
+/**
+  * @brief  Configure the OSPI in memory-mapped mode, the read configuration matches the indirect read.
+  * @param  ctx: driver context of the OSPI instance
+  * @retval O on success 1 on Failure.
+  */
+static uint8_t ospi_enter_memory_mapped(OSPI_ContextTypeDef *ctx)
+{
+	OSPI_RegularCmdTypeDef sCommand;
+	OSPI_MemoryMappedTypeDef sMemMappedCfg;
+
+	if (ctx->memory_mapped)
+	{
+		return OSPI_OK;
+	}
+
+	/* Initialize the read command */
+#if (LX_STM32_OSPI_CONTINUOUS_READ == 1)
+	/* The OctoSPI sends the instruction of the first read only, the memory stays in performance enhance mode */
+	if (ospi_pe_exit(ctx) != OSPI_OK)
+	{
+		return OSPI_ERROR;
+	}
+
+	ospi_cmd_fill(OSPI_CMD_QUAD_INOUT_READ_PE, 0, 0, &sCommand);
+	sCommand.SIOOMode = HAL_OSPI_SIOO_INST_ONLY_FIRST_CMD;
+#else
+	ospi_cmd_fill(OSPI_CMD_QUAD_INOUT_READ, 0, 0, &sCommand);
+#endif
+	sCommand.OperationType = HAL_OSPI_OPTYPE_READ_CFG;
+
+	if (HAL_OSPI_Command(ctx->hospi, &sCommand, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+	{
+		return OSPI_ERROR;
+	}
+
+	/* Initialize the program command, the window is never written by the driver */
+	ospi_cmd_fill(OSPI_CMD_QUAD_PAGE_PROG, 0, 0, &sCommand);
+	sCommand.OperationType = HAL_OSPI_OPTYPE_WRITE_CFG;
+
+	if (HAL_OSPI_Command(ctx->hospi, &sCommand, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+	{
+		return OSPI_ERROR;
+	}
+
+	sMemMappedCfg.TimeOutActivation = HAL_OSPI_TIMEOUT_COUNTER_DISABLE;
+
+	if (HAL_OSPI_MemoryMapped(ctx->hospi, &sMemMappedCfg) != HAL_OK)
+	{
+		return OSPI_ERROR;
+	}
+
+	ctx->memory_mapped = 1;
+#if (LX_STM32_OSPI_CONTINUOUS_READ == 1)
+	ctx->pe_mode = 1;
+#endif
+
+	return OSPI_OK;
+}
+#endif
+
+/**
+  * @brief  Abort the memory-mapped mode so that indirect commands can be issued.
+  * @param  ctx: driver context of the OSPI instance
+  * @retval O on success 1 on Failure.
+  */
+static uint8_t ospi_leave_memory_mapped(OSPI_ContextTypeDef *ctx)
+{
+	if (ctx->memory_mapped == 0)
+	{
+		return OSPI_OK;
+	}
+
+	if (HAL_OSPI_Abort(ctx->hospi) != HAL_OK)
+	{
+		return OSPI_ERROR;
+	}
+
+	ctx->memory_mapped = 0;
+
+#if (LX_STM32_OSPI_CONTINUOUS_READ == 1)
+	/* The window may not have been read since the OctoSPI was configured, the memory
+	 * is brought back to the normal mode now rather than by the next read.
+	 */
+	if (ospi_pe_exit(ctx) != OSPI_OK)
+	{
+		return OSPI_ERROR;
+	}
+#endif
+
+	return OSPI_OK;
+}
+
+#if (LX_STM32_OSPI_CONTINUOUS_READ == 1)
+/**
+  * @brief  Bring the memory out of performance enhance mode with a read without
+  *         instruction and with other mode bits. Harmless if the memory is not in that mode.
+  * @param  ctx: driver context of the OSPI instance
+  * @retval O on success 1 on Failure.
+  */
+static uint8_t ospi_pe_exit(OSPI_ContextTypeDef *ctx)
+{
+	uint8_t data;
+
+	ctx->pe_mode = 0;
+
+	return ospi_read_reg(ctx, OSPI_CMD_QUAD_INOUT_READ_PE_EXIT, &data, 1);
+}
+#endif
+
+#if (LX_STM32_OSPI_STATUS_CACHE == 1)
+/**
+  * @brief  Sleep until the typical end of the pending erase, the memory is polled from there only.
+  *         Counted in ticks: the cycle counter wraps before the end of a bulk erase.
+  *         The time the erase was suspended is not deducted.
+  * @param  ctx: driver context of the OSPI instance
+  * @retval None
+  */
+static void ospi_erase_sleep(OSPI_ContextTypeDef *ctx)
+{
+	ULONG typical, elapsed;
+
+	typical = (ctx->erase_size == LX_STM32_OSPI_FLASH_SIZE) ? LX_STM32_OSPI_BULK_ERASE_TYPICAL_TIME : LX_STM32_OSPI_ERASE_TYPICAL_TIME;
+	typical = (typical * TX_TIMER_TICKS_PER_SECOND) / 1000;
+	elapsed = tx_time_get() - ctx->erase_start_tick;
+
+	if (elapsed < typical)
+	{
+		ctx->transfer_stats.erase_sleeps++;
+		tx_thread_sleep(typical - elapsed);
+	}
+}
+#endif
+
+/**
+  * @brief  Mark a program or erase as in progress, its end is checked by ospi_wait_pending().
+  * @param  ctx: driver context of the OSPI instance
+  * @param  kind: OSPI_PENDING_PROGRAM or OSPI_PENDING_ERASE
+  * @param  timeout: maximum duration of the operation
+  * @retval None
+  */
+static void ospi_set_pending(OSPI_ContextTypeDef *ctx, UINT kind, uint32_t timeout)
+{
+	ctx->busy_timeout = timeout;
+	ctx->busy_pending = kind;
+#if (LX_STM32_OSPI_STATUS_CACHE == 1)
+	ctx->status_checked = 0;
+#endif
+#if (OSPI_SUSPEND == 1)
+	ctx->suspends = 0;
+#endif
+}
+
+/**
+  * @brief  Wait for the end of the program or erase issued last, if not yet done.
+  * @param  ctx: driver context of the OSPI instance
+  * @retval O on success 1 on Failure.
+  */
+static uint8_t ospi_wait_pending(OSPI_ContextTypeDef *ctx)
+{
+	UINT kind;
+
+	if (ctx->busy_pending == OSPI_PENDING_NONE)
+	{
+		return OSPI_OK;
+	}
+
+#if (OSPI_SUSPEND == 1)
+	/* A failed read may have left the program or erase suspended */
+	if (ospi_resume_pending(ctx) != OSPI_OK)
+	{
+		return OSPI_ERROR;
+	}
+#endif
+
+	kind = ctx->busy_pending;
+	ctx->busy_pending = OSPI_PENDING_NONE;
+
+#if (LX_STM32_OSPI_STATUS_CACHE == 1)
+	if (kind == OSPI_PENDING_ERASE)
+	{
+		ospi_erase_sleep(ctx);
+	}
+#endif
+
+	if (ospi_auto_polling_ready(ctx, ctx->busy_timeout) != OSPI_OK)
+	{
+		return OSPI_ERROR;
+	}
+
+	return ospi_pending_done(ctx, kind);
+}
+
+/**
+  * @brief  Check, without waiting, whether the pending program or erase completed, and retire it if so.
+  * @param  ctx: driver context of the OSPI instance
+  * @retval O on success or while the operation is in progress, 1 on Failure or if the operation failed.
+  */
+static uint8_t ospi_poll_pending(OSPI_ContextTypeDef *ctx)
+{
+	UINT kind;
+	uint8_t reg;
+
+#if (OSPI_SUSPEND == 1)
+	/* Resumed, then waited for, by the next operation */
+	if (ctx->suspended != 0)
+	{
+		return OSPI_OK;
+	}
+#endif
+
+	if (ospi_leave_memory_mapped(ctx) != OSPI_OK)
+	{
+		return OSPI_ERROR;
+	}
+
+	if (ospi_read_reg(ctx, OSPI_CMD_READ_STATUS_REG, &reg, 1) != OSPI_OK)
+	{
+		return OSPI_ERROR;
+	}
+
+	if ((reg & MX25R6435F_SR_WIP) != 0)
+	{
+		return OSPI_OK;
+	}
+
+	kind = ctx->busy_pending;
+	ctx->busy_pending = OSPI_PENDING_NONE;
+
+	return ospi_pending_done(ctx, kind);
+}
+
+/**
+  * @brief  Check the result of the program or erase the memory just completed.
+  * @param  ctx: driver context of the OSPI instance
+  * @param  kind: OSPI_PENDING_PROGRAM or OSPI_PENDING_ERASE
+  * @retval O on success 1 on Failure, or if the memory reports the operation failed.
+  */
+static uint8_t ospi_pending_done(OSPI_ContextTypeDef *ctx, UINT kind)
+{
+	uint8_t secr;
+
+	if (ospi_read_reg(ctx, OSPI_CMD_READ_SEC_REG, &secr, 1) != OSPI_OK)
+	{
+		return OSPI_ERROR;
+	}
+
+	if (kind == OSPI_PENDING_ERASE)
+	{
+		return ospi_erase_done(ctx, secr);
+	}
+
+	if ((secr & MX25R6435F_SECR_P_FAIL) != 0)
+	{
+		return OSPI_ERROR;
+	}
+
+	return OSPI_OK;
+}
+
+#if (OSPI_SUSPEND == 1)
+/**
+  * @brief  Suspend the pending program or erase so that the given range can be read.
+  *         Nothing is done if neither is pending, if the range overlaps the page being programmed
+  *         or the block being erased, or if the operation was already suspended
+  *         LX_STM32_OSPI_PROGRAM_SUSPEND_MAX or LX_STM32_OSPI_ERASE_SUSPEND_MAX times,
+  *         the caller then waits for the end of the operation.
+  * @param  ctx: driver context of the OSPI instance
+  * @param  address: start address of the read
+  * @param  size: number of bytes to read
+  * @retval O on success 1 on Failure.
+  */
+static uint8_t ospi_suspend_pending(OSPI_ContextTypeDef *ctx, uint32_t address, uint32_t size)
+{
+	uint32_t busy_address, busy_size;
+	UINT suspends_max, kind;
+	uint8_t reg, flag;
+
+	if (ctx->suspended != 0)
+	{
+		return OSPI_OK;
+	}
+
+#if (LX_STM32_OSPI_ERASE_SUSPEND == 1)
+	if (ctx->busy_pending == OSPI_PENDING_ERASE)
+	{
+		busy_address = ctx->erase_address;
+		busy_size = ctx->erase_size;
+		suspends_max = LX_STM32_OSPI_ERASE_SUSPEND_MAX;
+		flag = MX25R6435F_SECR_ESB;
+	}
+	else
+#endif
+#if (LX_STM32_OSPI_PROGRAM_SUSPEND == 1)
+	if (ctx->busy_pending == OSPI_PENDING_PROGRAM)
+	{
+		busy_address = ctx->program_address;
+		busy_size = LX_STM32_OSPI_PAGE_SIZE;
+		suspends_max = LX_STM32_OSPI_PROGRAM_SUSPEND_MAX;
+		flag = MX25R6435F_SECR_PSB;
+	}
+	else
+#endif
+	{
+		return OSPI_OK;
+	}
+
+	if (ctx->suspends >= suspends_max)
+	{
+		return OSPI_OK;
+	}
+
+	if ((address < (busy_address + busy_size)) && ((address + size) > busy_address))
+	{
+		return OSPI_OK;
+	}
+
+	if (ospi_leave_memory_mapped(ctx) != OSPI_OK)
+	{
+		return OSPI_ERROR;
+	}
+
+	if (ospi_issue_cmd(ctx, OSPI_CMD_PROG_ERASE_SUSPEND, 0, 0) != OSPI_OK)
+	{
+		return OSPI_ERROR;
+	}
+
+	/* The memory accepts reads once WIP is cleared, within tPSL or tESL */
+	if (ospi_auto_polling_ready(ctx, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != OSPI_OK)
+	{
+		return OSPI_ERROR;
+	}
+
+	if (ospi_read_reg(ctx, OSPI_CMD_READ_SEC_REG, &reg, 1) != OSPI_OK)
+	{
+		return OSPI_ERROR;
+	}
+
+	if ((reg & flag) == 0)
+	{
+		/* The operation completed before the suspend command */
+		kind = ctx->busy_pending;
+		ctx->busy_pending = OSPI_PENDING_NONE;
+
+		if ((kind == OSPI_PENDING_ERASE) && (ospi_erase_done(ctx, reg) != OSPI_OK))
+		{
+			return OSPI_ERROR;
+		}
+
+		if ((kind == OSPI_PENDING_PROGRAM) && ((reg & MX25R6435F_SECR_P_FAIL) != 0))
+		{
+			return OSPI_ERROR;
+		}
+	}
+	else
+	{
+		ctx->suspended = 1;
+		ctx->suspends++;
+		if (flag == MX25R6435F_SECR_ESB)
+		{
+			ctx->transfer_stats.erase_suspends++;
+		}
+		else
+		{
+			ctx->transfer_stats.program_suspends++;
+		}
+	}
+
+	return OSPI_OK;
+}
+
+/**
+  * @brief  Resume the pending program or erase if it was suspended by ospi_suspend_pending().
+  * @param  ctx: driver context of the OSPI instance
+  * @retval O on success 1 on Failure.
+  */
+static uint8_t ospi_resume_pending(OSPI_ContextTypeDef *ctx)
+{
+	if (ctx->suspended == 0)
+	{
+		return OSPI_OK;
+	}
+
+	if (ospi_leave_memory_mapped(ctx) != OSPI_OK)
+	{
+		return OSPI_ERROR;
+	}
+
+	if (ospi_issue_cmd(ctx, OSPI_CMD_PROG_ERASE_RESUME, 0, 0) != OSPI_OK)
+	{
+		return OSPI_ERROR;
+	}
+
+	ctx->suspended = 0;
+
+	return OSPI_OK;
+}
+#endif
+
+/**
+  * @brief  Tell whether a data phase is worth being done by the DMA.
+  * @param  buffer: source or destination buffer
+  * @param  size: number of bytes to transfer
+  * @retval 1 if the DMA is used, 0 if the transfer is done in interrupt mode.
+  */
+static UINT ospi_dma_eligible(uint8_t *buffer, uint32_t size)
+{
+#if (LX_STM32_OSPI_DMA_API == 1)
+	/* The DMA is configured in word mode: both the buffer and the size must be word aligned */
+	if ((size >= LX_STM32_OSPI_DMA_MIN_TRANSFER_SIZE) && ((((uint32_t)buffer) | size) & 0x3) == 0)
+	{
+		return 1;
+	}
+#endif
+
+	return 0;
+}
+
+#if (LX_STM32_OSPI_MEMORY_MAPPED_READ == 0)
+/**
+  * @brief  Start the reception of the data phase, completion is notified by HAL_OSPI_RxCpltCallback.
+  * @param  ctx: driver context of the OSPI instance
+  * @param  buffer: destination buffer
+  * @param  size: number of bytes to receive
+  * @retval O on success 1 on Failure.
+  */
+static uint8_t ospi_receive(OSPI_ContextTypeDef *ctx, uint8_t *buffer, uint32_t size)
+{
+	HAL_StatusTypeDef status;
+
+	if (ospi_dma_eligible(buffer, size))
+	{
+		status = HAL_OSPI_Receive_DMA(ctx->hospi, buffer);
+	}
+	else
+	{
+		status = HAL_OSPI_Receive_IT(ctx->hospi, buffer);
+	}
+
+	return (status == HAL_OK) ? OSPI_OK : OSPI_ERROR;
+}
+#endif
+
+/**
+  * @brief  Start the transmission of the data phase, completion is notified by HAL_OSPI_TxCpltCallback.
+  * @param  ctx: driver context of the OSPI instance
+  * @param  buffer: source buffer
+  * @param  size: number of bytes to transmit
+  * @retval O on success 1 on Failure.
+  */
+static uint8_t ospi_transmit(OSPI_ContextTypeDef *ctx, uint8_t *buffer, uint32_t size)
+{
+	HAL_StatusTypeDef status;
+
+	if (ospi_dma_eligible(buffer, size))
+	{
+		status = HAL_OSPI_Transmit_DMA(ctx->hospi, buffer);
+	}
+	else
+	{
+		status = HAL_OSPI_Transmit_IT(ctx->hospi, buffer);
+	}
+
+	return (status == HAL_OK) ? OSPI_OK : OSPI_ERROR;
+}
+
+/**
+  * @brief  Account a completed data transfer.
+  * @param  ctx: driver context of the OSPI instance
+  * @param  path: OSPI_TRANSFER_IT, OSPI_TRANSFER_DMA or OSPI_TRANSFER_MAPPED
+  * @param  size: number of bytes transferred
+  * @param  cycles: cycles elapsed from the command setup to the completion
+  * @retval None
+  */
+static void ospi_transfer_account(OSPI_ContextTypeDef *ctx, UINT path, uint32_t size, uint32_t cycles)
+{
+	TX_INTERRUPT_SAVE_AREA
+
+	TX_DISABLE
+	if (path == OSPI_TRANSFER_DMA)
+	{
+		ctx->transfer_stats.dma_transfers++;
+		ctx->transfer_stats.dma_bytes += size;
+		ctx->transfer_stats.dma_cycles += cycles;
+	}
+	else if (path == OSPI_TRANSFER_MAPPED)
+	{
+		ctx->transfer_stats.mapped_reads++;
+		ctx->transfer_stats.mapped_bytes += size;
+		ctx->transfer_stats.mapped_cycles += cycles;
+	}
+	else
+	{
+		ctx->transfer_stats.it_transfers++;
+		ctx->transfer_stats.it_bytes += size;
+		ctx->transfer_stats.it_cycles += cycles;
+	}
+
+	ctx->transfer_stats.last_cycles = cycles;
+	if (cycles > ctx->transfer_stats.max_cycles)
+	{
+		ctx->transfer_stats.max_cycles = cycles;
+	}
+	TX_RESTORE
+}
+
+/**
+  * @brief  Update the known erased state of the LevelX blocks covering a flash range.
+  * @param  ctx: driver context of the OSPI instance
+  * @param  address: start of the range
+  * @param  size: number of bytes of the range
+  * @param  erased: 1 to mark the blocks erased, 0 to mark them as not blank
+  * @retval None
+  */
+static void ospi_erased_map_update(OSPI_ContextTypeDef *ctx, uint32_t address, uint32_t size, UINT erased)
+{
+	uint32_t block = address / LX_STM32_OSPI_SECTOR_SIZE;
+	uint32_t last = (address + size - 1) / LX_STM32_OSPI_SECTOR_SIZE;
+
+	if (size == 0)
+	{
+		return;
+	}
+
+	for (; (block <= last) && (block < OSPI_BLOCK_COUNT); block++)
+	{
+		if (erased)
+		{
+			ctx->erased_map[block / 32] |= (1UL << (block % 32));
+		}
+		else
+		{
+			ctx->erased_map[block / 32] &= ~(1UL << (block % 32));
+		}
+	}
+}
+
+/**
+  * @brief  Tell whether a LevelX block is known to be erased.
+  * @param  ctx: driver context of the OSPI instance
+  * @param  block: LevelX block index
+  * @retval 1 if the block is erased, 0 if its state is unknown.
+  */
+static UINT ospi_erased_map_test(OSPI_ContextTypeDef *ctx, uint32_t block)
+{
+	return (ctx->erased_map[block / 32] >> (block % 32)) & 0x1;
+}
+
+/**
+  * @brief  Check that a flash range reads as erased, stopping at the first programmed word.
+  * @param  ctx: driver context of the OSPI instance
+  * @param  address: start of the range, word aligned
+  * @param  size: number of bytes of the range, multiple of LX_STM32_OSPI_PAGE_SIZE
+  * @retval O if the range is blank 1 otherwise.
+  */
+static uint8_t ospi_blank_check(OSPI_ContextTypeDef *ctx, uint32_t address, uint32_t size)
+{
+	uint32_t i;
+#if (LX_STM32_OSPI_MEMORY_MAPPED_READ == 1)
+	const uint32_t *word;
+
+	/* The memory-mapped window streams the block with quad reads as the words are compared */
+	if (ospi_enter_memory_mapped(ctx) != OSPI_OK)
+	{
+		return OSPI_ERROR;
+	}
+
+	word = (const uint32_t *)(ctx->mapped_base + address);
+	for (i = 0; i < (size / sizeof(uint32_t)); i++)
+	{
+		if (word[i] != 0xFFFFFFFFUL)
+		{
+			return OSPI_ERROR;
+		}
+	}
+#else
+	uint32_t offset;
+
+	for (offset = 0; offset < size; offset += sizeof(ctx->blank_buffer))
+	{
+		if (ospi_read_indirect(ctx, address + offset, (uint8_t*)ctx->blank_buffer, sizeof(ctx->blank_buffer)) != OSPI_OK)
+		{
+			return OSPI_ERROR;
+		}
+
+		for (i = 0; i < (sizeof(ctx->blank_buffer) / sizeof(ULONG)); i++)
+		{
+			if (ctx->blank_buffer[i] != 0xFFFFFFFFUL)
+			{
+				return OSPI_ERROR;
+			}
+		}
+	}
+#endif
+
+	return OSPI_OK;
+}
+
+/**
+  * @brief  Account a completed flash operation.
+  * @param  ctx: driver context of the OSPI instance
+  * @param  op: one of LX_STM32_OSPI_OP
+  * @param  bytes: number of bytes read, programmed or erased
+  * @param  cycles: duration of the operation
+  * @retval None
+  */
+static void ospi_op_account(OSPI_ContextTypeDef *ctx, UINT op, uint32_t bytes, uint32_t cycles)
+{
+	TX_INTERRUPT_SAVE_AREA
+	LX_STM32_OSPI_OP_STATS *stats = &ctx->op_stats[op];
+	UINT bucket = 0;
+
+	if (cycles >= (1UL << LX_STM32_OSPI_LATENCY_MIN_LOG2))
+	{
+		bucket = LX_STM32_OSPI_LOG2(cycles) - LX_STM32_OSPI_LATENCY_MIN_LOG2;
+		if (bucket >= LX_STM32_OSPI_LATENCY_BUCKETS)
+		{
+			bucket = LX_STM32_OSPI_LATENCY_BUCKETS - 1;
+		}
+	}
+
+	TX_DISABLE
+	stats->count++;
+	stats->bytes += bytes;
+	stats->total_cycles += cycles;
+	stats->histogram[bucket]++;
+	if (cycles > stats->max_cycles)
+	{
+		stats->max_cycles = cycles;
+	}
+	TX_RESTORE
+}
+
+/**
+  * @brief  Record the end of the pending erase, the range is marked erased only if the erase succeeded.
+  * @param  ctx: driver context of the OSPI instance
+  * @param  secr: security register read once the erase completed
+  * @retval O on success 1 if the memory reports the erase failed.
+  */
+static uint8_t ospi_erase_done(OSPI_ContextTypeDef *ctx, uint8_t secr)
+{
+	if ((secr & MX25R6435F_SECR_E_FAIL) != 0)
+	{
+		ospi_erased_map_update(ctx, ctx->erase_address, ctx->erase_size, 0);
+		return OSPI_ERROR;
+	}
+
+	ospi_erased_map_update(ctx, ctx->erase_address, ctx->erase_size, 1);
+	ospi_op_account(ctx, LX_STM32_OSPI_OP_ERASE, ctx->erase_size, LX_STM32_OSPI_CYCLE_COUNT() - ctx->erase_start);
+
+	return OSPI_OK;
+}
+
+/**
+  * @brief  Program a range page by page.
+  * @param  ctx: driver context of the OSPI instance
+  * @param  address: start address of the range
+  * @param  buffer: data to program
+  * @param  size: number of bytes to program
+  * @retval O on success 1 on Failure.
+  */
+static uint8_t ospi_program(OSPI_ContextTypeDef *ctx, uint32_t address, uint8_t *buffer, uint32_t size)
+{
+	uint32_t end_addr, current_size, current_addr;
+	uint8_t *data_buffer;
+	uint32_t start, program_start;
+
+	/* Calculation of the size between the write address and the end of the page */
+	current_size = LX_STM32_OSPI_PAGE_SIZE - (address % LX_STM32_OSPI_PAGE_SIZE);
+
+	/* Check if the size of the data is less than the remaining place in the page */
+	if (current_size > size)
+	{
+		current_size = size;
+	}
+
+	/* Initialize the adress variables */
+	current_addr = address;
+	end_addr = address + size;
+	data_buffer = buffer;
+
+	/* Perform the write page by page */
+	do {
+		start = LX_STM32_OSPI_CYCLE_COUNT();
+
+		/* Wait for the end of the previous page program */
+		if (ospi_wait_pending(ctx) != OSPI_OK)
+		{
+			return OSPI_ERROR;
+		}
+
+		/* Enable write operations */
+		if (ospi_set_write_enable(ctx) != OSPI_OK)
+		{
+			return OSPI_ERROR;
+		}
+
+		program_start = LX_STM32_OSPI_CYCLE_COUNT();
+
+		/* Configure the command */
+		if (ospi_issue_cmd(ctx, OSPI_CMD_QUAD_PAGE_PROG, current_addr, current_size) != OSPI_OK)
+		{
+			return OSPI_ERROR;
+		}
+
+		/* Transmission of the data */
+		if (ospi_transmit(ctx, data_buffer, current_size) != OSPI_OK)
+		{
+			return OSPI_ERROR;
+		}
+
+	    /* Check success of the transmission of the data */
+	    if(tx_semaphore_get(&ospi_tx_semaphore[ctx->instance], HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != TX_SUCCESS)
+	    {
+			return OSPI_ERROR;
+	    }
+
+		ospi_op_account(ctx, LX_STM32_OSPI_OP_PROGRAM, current_size, LX_STM32_OSPI_CYCLE_COUNT() - program_start);
+		ospi_transfer_account(ctx, ospi_dma_eligible(data_buffer, current_size), current_size, LX_STM32_OSPI_CYCLE_COUNT() - start);
+
+		/* The end of program is checked before the next command */
+		ospi_set_pending(ctx, OSPI_PENDING_PROGRAM, HAL_OSPI_TIMEOUT_DEFAULT_VALUE);
+#if (LX_STM32_OSPI_PROGRAM_SUSPEND == 1)
+		ctx->program_address = current_addr & ~(LX_STM32_OSPI_PAGE_SIZE - 1);
+#endif
+
+		/* Update the address and size variables for next page programming */
+		current_addr += current_size;
+		data_buffer += current_size;
+		current_size = ((current_addr + LX_STM32_OSPI_PAGE_SIZE) > end_addr) ? (end_addr - current_addr) : LX_STM32_OSPI_PAGE_SIZE;
+	} while (current_addr < end_addr);
+
+	return OSPI_OK;
+}
+
+#if (LX_STM32_OSPI_WRITE_COALESCE == 1)
+/**
+  * @brief  Program the page kept in RAM, if any.
+  * @param  ctx: driver context of the OSPI instance
+  * @retval O on success 1 on Failure.
+  */
+static uint8_t ospi_write_flush(OSPI_ContextTypeDef *ctx)
 {
-	OSPI_RegularCmdTypeDef sCommand;
-	OSPI_AutoPollingTypeDef sConfig;
+	uint32_t size = ctx->wc_size;
 
-	/* Configure automatic polling mode to wait for memory ready */
-	sCommand.OperationType      = HAL_OSPI_OPTYPE_COMMON_CFG;
-	sCommand.FlashId            = HAL_OSPI_FLASH_ID_1;
-	sCommand.Instruction        = READ_STATUS_REG_CMD;
-	sCommand.InstructionMode    = HAL_OSPI_INSTRUCTION_1_LINE;
-	sCommand.InstructionSize    = HAL_OSPI_INSTRUCTION_8_BITS;
-	sCommand.InstructionDtrMode = HAL_OSPI_INSTRUCTION_DTR_DISABLE;
-	sCommand.AddressMode        = HAL_OSPI_ADDRESS_NONE;
-	sCommand.AlternateBytesMode = HAL_OSPI_ALTERNATE_BYTES_NONE;
-	sCommand.DataMode           = HAL_OSPI_DATA_1_LINE;
-	sCommand.NbData             = 1;
-	sCommand.DataDtrMode        = HAL_OSPI_DATA_DTR_DISABLE;
-	sCommand.DummyCycles        = 0;
-	sCommand.DQSMode            = HAL_OSPI_DQS_DISABLE;
-	sCommand.SIOOMode           = HAL_OSPI_SIOO_INST_EVERY_CMD;
+	if (size == 0)
+	{
+		return OSPI_OK;
+	}
 
-	sConfig.Match         = 0;
-	sConfig.Mask          = MX25R6435F_SR_WIP;
-	sConfig.MatchMode     = HAL_OSPI_MATCH_MODE_AND;
-	sConfig.Interval      = 0x10;
-	sConfig.AutomaticStop = HAL_OSPI_AUTOMATIC_STOP_ENABLE;
+	/* The data is dropped on failure, as an uncoalesced write would have failed */
+	ctx->wc_size = 0;
+
+#if (OSPI_READ_AHEAD == 1)
+	/* A window read since the write holds the previous content of the page */
+	ospi_read_ahead_invalidate(ctx, ctx->wc_address, size);
+#endif
 
-	if (HAL_OSPI_Command(hospi, &sCommand, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+	return ospi_program(ctx, ctx->wc_address, (uint8_t *)ctx->wc_buffer, size);
+}
+
+/**
+  * @brief  Keep a write smaller than a page in RAM. A write that continues the one kept
+  *         in the same page is appended to it, any other write programs it first.
+  * @param  ctx: driver context of the OSPI instance
+  * @param  address: start address of the write
+  * @param  buffer: data to write
+  * @param  size: number of bytes to write
+  * @param  kept: set to 1 if the write is kept in RAM, to 0 if it has to be programmed
+  * @retval O on success 1 on Failure.
+  */
+static uint8_t ospi_write_coalesce(OSPI_ContextTypeDef *ctx, uint32_t address, uint8_t *buffer, uint32_t size, UINT *kept)
+{
+	uint32_t page_offset = address % LX_STM32_OSPI_PAGE_SIZE;
+
+	*kept = 0;
+
+	if ((ctx->wc_size != 0) && (address == (ctx->wc_address + ctx->wc_size)) && (page_offset != 0) &&
+	    ((page_offset + size) <= LX_STM32_OSPI_PAGE_SIZE))
 	{
-		return OSPI_ERROR;
+		memcpy(((uint8_t *)ctx->wc_buffer) + ctx->wc_size, buffer, size);
+		ctx->wc_size += size;
+		ctx->transfer_stats.coalesced_writes++;
+		*kept = 1;
+		return OSPI_OK;
 	}
 
-	if (HAL_OSPI_AutoPolling(hospi, &sConfig, timeout) != HAL_OK)
+	/* Keep the LevelX order: the previous write is programmed before this one */
+	if (ospi_write_flush(ctx) != OSPI_OK)
 	{
 		return OSPI_ERROR;
 	}
 
+	/* A write reaching the end of its page can't be continued */
+	if ((page_offset + size) < LX_STM32_OSPI_PAGE_SIZE)
+	{
+		memcpy(ctx->wc_buffer, buffer, size);
+		ctx->wc_address = address;
+		ctx->wc_size = size;
+		*kept = 1;
+	}
+
 	return OSPI_OK;
 }
+#endif
 
+#if (OSPI_READ_AHEAD == 1)
 /**
-  * @brief  This function enables the octal mode of the memory.
-  * @param  hospi: OSPI handle
-  * @retval 0 on success 1 on Failure.
+  * @brief  Wait for the end of the read-ahead in progress, if any.
+  * @param  ctx: driver context of the OSPI instance
+  * @retval O on success 1 on Failure.
   */
-static uint8_t ospi_set_quad_mode(OSPI_HandleTypeDef *hospi)
+static uint8_t ospi_read_ahead_sync(OSPI_ContextTypeDef *ctx)
 {
-	uint8_t reg;
-	OSPI_RegularCmdTypeDef sCommand;
+	if (ctx->ra_pending == 0)
+	{
+		return OSPI_OK;
+	}
 
-	/* Read status register */
-	sCommand.OperationType      = HAL_OSPI_OPTYPE_COMMON_CFG;
-	sCommand.FlashId            = HAL_OSPI_FLASH_ID_1;
-	sCommand.Instruction        = READ_STATUS_REG_CMD;
-	sCommand.InstructionMode    = HAL_OSPI_INSTRUCTION_1_LINE;
-	sCommand.InstructionSize    = HAL_OSPI_INSTRUCTION_8_BITS;
-	sCommand.InstructionDtrMode = HAL_OSPI_INSTRUCTION_DTR_DISABLE;
-	sCommand.AddressMode        = HAL_OSPI_ADDRESS_NONE;
-	sCommand.AlternateBytesMode = HAL_OSPI_ALTERNATE_BYTES_NONE;
-	sCommand.DataMode           = HAL_OSPI_DATA_1_LINE;
-	sCommand.DataDtrMode        = HAL_OSPI_DATA_DTR_DISABLE;
-	sCommand.DummyCycles        = 0;
-	sCommand.NbData             = 1;
-	sCommand.DQSMode            = HAL_OSPI_DQS_DISABLE;
-	sCommand.SIOOMode           = HAL_OSPI_SIOO_INST_EVERY_CMD;
+	ctx->ra_pending = 0;
 
-	if (HAL_OSPI_Command(hospi, &sCommand, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+	if (tx_semaphore_get(&ospi_rx_semaphore[ctx->instance], HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != TX_SUCCESS)
 	{
+		ctx->ra_valid = 0;
 		return OSPI_ERROR;
 	}
 
-	if (HAL_OSPI_Receive(hospi, &reg, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+	return OSPI_OK;
+}
+
+/**
+  * @brief  Serve a read from the read-ahead window if the window holds the whole range.
+  * @param  ctx: driver context of the OSPI instance
+  * @param  address: start address of the read
+  * @param  buffer: destination buffer
+  * @param  size: number of bytes to read
+  * @retval 1 if the read was served, 0 otherwise.
+  */
+static UINT ospi_read_ahead_lookup(OSPI_ContextTypeDef *ctx, uint32_t address, uint8_t *buffer, uint32_t size)
+{
+	if ((ctx->ra_valid == 0) || (address < ctx->ra_address) || ((address + size) > (ctx->ra_address + ctx->ra_valid)))
 	{
-		return OSPI_ERROR;
+		return 0;
 	}
 
-	/* Enable write operations */
-	if (ospi_set_write_enable(hospi) != OSPI_OK)
+	memcpy(buffer, ((uint8_t *)ctx->ra_buffer) + (address - ctx->ra_address), size);
+	ctx->transfer_stats.read_ahead_hits++;
+
+	return 1;
+}
+
+/**
+  * @brief  Start reading the next window in the background after a sequential read.
+  *         Reads shorter than LX_STM32_OSPI_DMA_MIN_TRANSFER_SIZE are LevelX metadata accesses,
+  *         they don't break the sequence of the sector reads.
+  * @param  ctx: driver context of the OSPI instance
+  * @retval None
+  */
+static void ospi_read_ahead_next(OSPI_ContextTypeDef *ctx)
+{
+	uint32_t end = ctx->read_address + ctx->read_size;
+	uint32_t size;
+	UINT sequential = (ctx->read_hit != 0) || (ctx->read_address == ctx->ra_next);
+
+	if ((ctx->read_hit == 0) && (ctx->read_size < LX_STM32_OSPI_DMA_MIN_TRANSFER_SIZE))
 	{
-		return OSPI_ERROR;
+		return;
 	}
 
-	SET_BIT(reg, MX25R6435F_SR_QE);
+	ctx->ra_next = end;
 
-	sCommand.Instruction = WRITE_STATUS_CFG_REG_CMD;
-	if (HAL_OSPI_Command(hospi, &sCommand, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+	/* Nothing to do if the window already holds the next data */
+	if ((sequential == 0) || ((ctx->ra_valid != 0) && (end >= ctx->ra_address) && (end < (ctx->ra_address + ctx->ra_valid))))
 	{
-		return OSPI_ERROR;
+		return;
 	}
 
-	if (HAL_OSPI_Transmit(hospi, &reg, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+	/* The memory can't be read while a program or erase is in progress, even suspended */
+	if ((ctx->busy_pending != OSPI_PENDING_NONE) || (end >= LX_STM32_OSPI_FLASH_SIZE))
 	{
-		return OSPI_ERROR;
+		return;
 	}
 
-	/* Wait that memory is ready */
-	if (ospi_auto_polling_ready(hospi, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != OSPI_OK)
+	size = LX_STM32_OSPI_FLASH_SIZE - end;
+	if (size > LX_STM32_OSPI_READ_AHEAD_SIZE)
 	{
-		return OSPI_ERROR;
+		size = LX_STM32_OSPI_READ_AHEAD_SIZE;
 	}
 
-	/* Check the configuration has been correctly done */
-	sCommand.Instruction = READ_STATUS_REG_CMD;
-	if (HAL_OSPI_Command(hospi, &sCommand, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+	ctx->ra_address = end;
+	ctx->ra_valid = size;
+
+	/* A single long read, completed by the next access to the instance */
+	if (ospi_read_indirect_start(ctx, end, (uint8_t *)ctx->ra_buffer, size) != OSPI_OK)
 	{
-		return OSPI_ERROR;
+		ctx->ra_valid = 0;
+		return;
+	}
+
+	ctx->ra_pending = 1;
+	ctx->transfer_stats.read_ahead_fills++;
+}
+
+/**
+  * @brief  Drop the read-ahead window if it overlaps a range being programmed or erased.
+  * @param  ctx: driver context of the OSPI instance
+  * @param  address: start of the range
+  * @param  size: number of bytes of the range
+  * @retval None
+  */
+static void ospi_read_ahead_invalidate(OSPI_ContextTypeDef *ctx, uint32_t address, uint32_t size)
+{
+	if ((address < (ctx->ra_address + ctx->ra_valid)) && ((address + size) > ctx->ra_address))
+	{
+		ctx->ra_valid = 0;
 	}
+}
+#endif
 
-	if (HAL_OSPI_Receive(hospi, &reg, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+#if (LX_STM32_OSPI_CHECKPOINT == 1)
+/**
+  * @brief  Read a flash range and wait for the data, once the program or erase in progress completes.
+  * @param  ctx: driver context of the OSPI instance
+  * @param  address: flash address to read from
+  * @param  buffer: destination buffer
+  * @param  size: number of bytes to read
+  * @retval O on success 1 on Failure.
+  */
+static uint8_t ospi_read_range(OSPI_ContextTypeDef *ctx, uint32_t address, uint8_t *buffer, uint32_t size)
+{
+	if (ospi_wait_pending(ctx) != OSPI_OK)
 	{
 		return OSPI_ERROR;
 	}
 
+	return ospi_read_indirect(ctx, address, buffer, size);
+}
+
+/**
+  * @brief  Accumulate words into the checksum of the checkpoint records.
+  * @param  sum: checksum of the previous words
+  * @param  words: words to add
+  * @param  count: number of words
+  * @retval the updated checksum.
+  */
+static uint32_t ospi_checkpoint_sum(uint32_t sum, const ULONG *words, uint32_t count)
+{
+	uint32_t i;
+
+	/* The rotation makes the sum depend on the order of the words */
+	for (i = 0; i < count; i++)
+	{
+		sum = ((sum << 1) | (sum >> 31)) + (uint32_t)words[i];
+	}
+
+	return sum;
+}
+
+/**
+  * @brief  Record a read of the open, merged with the previous range when it continues it.
+  *         The recording stops when the ranges or their records don't fit anymore.
+  * @param  ctx: driver context of the OSPI instance
+  * @param  address: start address of the read
+  * @param  size: number of bytes of the read
+  * @retval None
+  */
+static void ospi_checkpoint_record(OSPI_ContextTypeDef *ctx, uint32_t address, uint32_t size)
+{
+	OSPI_CheckpointRangeTypeDef *range;
+	uint32_t end = address + size;
+
+	if ((ctx->cp_recording == 0) || (size == 0) || (end > OSPI_CHECKPOINT_BASE))
+	{
+		return;
+	}
+
+	if (ctx->cp_count != 0)
+	{
+		range = &ctx->cp_ranges[ctx->cp_count - 1];
+
+		if ((address >= range->address) && (address <= (range->address + range->size)))
+		{
+			if (end > (range->address + range->size))
+			{
+				size = end - (range->address + range->size);
+				if ((ctx->cp_bytes + size) > OSPI_CHECKPOINT_CAPACITY)
+				{
+					ctx->cp_recording = 0;
+					return;
+				}
+
+				range->size += size;
+				ctx->cp_bytes += size;
+			}
+
+			return;
+		}
+	}
+
+	if ((ctx->cp_count == LX_STM32_OSPI_CHECKPOINT_RANGES) ||
+	    ((ctx->cp_bytes + sizeof(OSPI_CheckpointRangeTypeDef) + size) > OSPI_CHECKPOINT_CAPACITY))
+	{
+		ctx->cp_recording = 0;
+		return;
+	}
+
+	range = &ctx->cp_ranges[ctx->cp_count++];
+	range->address = address;
+	range->size = size;
+	ctx->cp_bytes += sizeof(OSPI_CheckpointRangeTypeDef) + size;
+}
+
+/**
+  * @brief  Check the checkpoint in flash, its records are read once to verify the checksum.
+  *         cp_state is left invalid if the checkpoint is missing, torn or can't be read.
+  * @param  ctx: driver context of the OSPI instance
+  * @retval None
+  */
+static void ospi_checkpoint_load(OSPI_ContextTypeDef *ctx)
+{
+	OSPI_CheckpointHeaderTypeDef header;
+	uint32_t offset, checksum = 0;
+
+	ctx->cp_state = OSPI_CHECKPOINT_INVALID;
+
+	if (ospi_read_range(ctx, OSPI_CHECKPOINT_BASE, (uint8_t *)&header, sizeof(header)) != OSPI_OK)
+	{
+		return;
+	}
+
+	if ((header.magic != OSPI_CHECKPOINT_MAGIC) || (header.size > OSPI_CHECKPOINT_CAPACITY) ||
+	    ((header.size % sizeof(ULONG)) != 0))
+	{
+		return;
+	}
+
+	ctx->cp_size = header.size;
+
+	for (offset = 0; offset < ctx->cp_size; offset += ctx->cp_chunk_size)
+	{
+		ctx->cp_chunk_offset = offset;
+		ctx->cp_chunk_size = ctx->cp_size - offset;
+		if (ctx->cp_chunk_size > sizeof(ctx->cp_chunk))
+		{
+			ctx->cp_chunk_size = sizeof(ctx->cp_chunk);
+		}
+
+		if (ospi_read_range(ctx, OSPI_CHECKPOINT_RECORDS + offset, (uint8_t *)ctx->cp_chunk, ctx->cp_chunk_size) != OSPI_OK)
+		{
+			ctx->cp_chunk_size = 0;
+			return;
+		}
+
+		checksum = ospi_checkpoint_sum(checksum, ctx->cp_chunk, ctx->cp_chunk_size / sizeof(ULONG));
+	}
+
+	if (checksum != header.checksum)
+	{
+		return;
+	}
+
+	ctx->cp_next = 0;
+	ctx->cp_record.size = 0;
+	ctx->cp_state = OSPI_CHECKPOINT_VALID;
+}
+
+/**
+  * @brief  Copy bytes of the checkpoint records, the chunk buffer is refilled by a single read when needed.
+  * @param  ctx: driver context of the OSPI instance
+  * @param  offset: offset in the records, word aligned
+  * @param  buffer: destination buffer
+  * @param  size: number of bytes to copy, within the records
+  * @retval O on success 1 on Failure.
+  */
+static uint8_t ospi_checkpoint_copy(OSPI_ContextTypeDef *ctx, uint32_t offset, uint8_t *buffer, uint32_t size)
+{
+	uint32_t part;
+
+	while (size != 0)
+	{
+		if ((offset < ctx->cp_chunk_offset) || (offset >= (ctx->cp_chunk_offset + ctx->cp_chunk_size)))
+		{
+			ctx->cp_chunk_offset = offset;
+			ctx->cp_chunk_size = ctx->cp_size - offset;
+			if (ctx->cp_chunk_size > sizeof(ctx->cp_chunk))
+			{
+				ctx->cp_chunk_size = sizeof(ctx->cp_chunk);
+			}
+
+			if (ospi_read_range(ctx, OSPI_CHECKPOINT_RECORDS + offset, (uint8_t *)ctx->cp_chunk, ctx->cp_chunk_size) != OSPI_OK)
+			{
+				ctx->cp_chunk_size = 0;
+				return OSPI_ERROR;
+			}
+		}
+
+		part = ctx->cp_chunk_offset + ctx->cp_chunk_size - offset;
+		if (part > size)
+		{
+			part = size;
+		}
+
+		memcpy(buffer, ((uint8_t *)ctx->cp_chunk) + (offset - ctx->cp_chunk_offset), part);
+		buffer += part;
+		offset += part;
+		size -= part;
+	}
+
 	return OSPI_OK;
 }
 
-static uint8_t ospi_highperf_mode(OSPI_HandleTypeDef *hospi)
+/**
+  * @brief  Serve a read from the checkpoint if the current or the next record holds the whole range.
+  *         The records are replayed in the order of the reads of the previous open: a read missing
+  *         from them is served by the flash, the following ones still match the next record.
+  * @param  ctx: driver context of the OSPI instance
+  * @param  address: start address of the read
+  * @param  buffer: destination buffer
+  * @param  size: number of bytes to read
+  * @retval 1 if the read was served, 0 otherwise.
+  */
+static UINT ospi_checkpoint_lookup(OSPI_ContextTypeDef *ctx, uint32_t address, uint8_t *buffer, uint32_t size)
 {
-	uint8_t reg[3];
-	OSPI_RegularCmdTypeDef sCommand;
+	OSPI_CheckpointRangeTypeDef next;
 
-	/* Read status register */
-	sCommand.OperationType      = HAL_OSPI_OPTYPE_COMMON_CFG;
-	sCommand.FlashId            = HAL_OSPI_FLASH_ID_1;
-	sCommand.Instruction        = READ_STATUS_REG_CMD;
-	sCommand.InstructionMode    = HAL_OSPI_INSTRUCTION_1_LINE;
-	sCommand.InstructionSize    = HAL_OSPI_INSTRUCTION_8_BITS;
-	sCommand.InstructionDtrMode = HAL_OSPI_INSTRUCTION_DTR_DISABLE;
-	sCommand.AddressMode        = HAL_OSPI_ADDRESS_NONE;
-	sCommand.AlternateBytesMode = HAL_OSPI_ALTERNATE_BYTES_NONE;
-	sCommand.DataMode           = HAL_OSPI_DATA_1_LINE;
-	sCommand.DataDtrMode        = HAL_OSPI_DATA_DTR_DISABLE;
-	sCommand.DummyCycles        = 0;
-	sCommand.NbData             = 1;
-	sCommand.DQSMode            = HAL_OSPI_DQS_DISABLE;
-	sCommand.SIOOMode           = HAL_OSPI_SIOO_INST_EVERY_CMD;
+	if ((ctx->cp_state != OSPI_CHECKPOINT_VALID) || (ctx->cp_modified != 0))
+	{
+		return 0;
+	}
 
-	if (HAL_OSPI_Command(hospi, &sCommand, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+	/* Move to the next record if the read starts in it */
+	if (((address < ctx->cp_record.address) || (address >= (ctx->cp_record.address + ctx->cp_record.size))) &&
+	    (ctx->cp_next < ctx->cp_size))
 	{
-		return OSPI_ERROR;
+		if (ospi_checkpoint_copy(ctx, ctx->cp_next, (uint8_t *)&next, sizeof(next)) != OSPI_OK)
+		{
+			ctx->cp_state = OSPI_CHECKPOINT_INVALID;
+			return 0;
+		}
+
+		if ((address >= next.address) && (address < (next.address + next.size)))
+		{
+			ctx->cp_record = next;
+			ctx->cp_data = ctx->cp_next + sizeof(next);
+			ctx->cp_next = ctx->cp_data + next.size;
+		}
 	}
 
-	if (HAL_OSPI_Receive(hospi, &(reg[0]), HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+	if ((address < ctx->cp_record.address) || ((address + size) > (ctx->cp_record.address + ctx->cp_record.size)) ||
+	    (ctx->cp_next > ctx->cp_size))
 	{
-		return OSPI_ERROR;
+		return 0;
 	}
 
-	/* Read configuration registers */
-	sCommand.Instruction = READ_CFG_REG_CMD;
-	sCommand.NbData      = 2;
+	if (ospi_checkpoint_copy(ctx, ctx->cp_data + (address - ctx->cp_record.address), buffer, size) != OSPI_OK)
+	{
+		ctx->cp_state = OSPI_CHECKPOINT_INVALID;
+		return 0;
+	}
 
-	if (HAL_OSPI_Command(hospi, &sCommand, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+	ctx->transfer_stats.checkpoint_hits++;
+
+	return 1;
+}
+
+/**
+  * @brief  Stop the recording on the first program or erase and clear the magic of the checkpoint,
+  *         so that the open following an unclean shutdown reads the flash.
+  * @param  ctx: driver context of the OSPI instance
+  * @retval O on success 1 on Failure.
+  */
+static uint8_t ospi_checkpoint_invalidate(OSPI_ContextTypeDef *ctx)
+{
+	uint32_t magic = 0;
+
+	ctx->cp_recording = 0;
+	ctx->cp_modified = 1;
+
+	if (ctx->cp_state == OSPI_CHECKPOINT_INVALID)
+	{
+		return OSPI_OK;
+	}
+
+	ctx->cp_state = OSPI_CHECKPOINT_INVALID;
+
+	if (ospi_leave_memory_mapped(ctx) != OSPI_OK)
 	{
 		return OSPI_ERROR;
 	}
 
-	if (HAL_OSPI_Receive(hospi, &(reg[1]), HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+	/* Bits can always be cleared without an erase */
+	return ospi_program(ctx, OSPI_CHECKPOINT_BASE, (uint8_t *)&magic, sizeof(magic));
+}
+
+/**
+  * @brief  Program the records staged in the chunk buffer after the ones already programmed.
+  * @param  ctx: driver context of the OSPI instance
+  * @param  header: header of the checkpoint, its size and checksum are updated
+  * @param  size: number of bytes staged
+  * @retval O on success 1 on Failure.
+  */
+static uint8_t ospi_checkpoint_flush(OSPI_ContextTypeDef *ctx, OSPI_CheckpointHeaderTypeDef *header, uint32_t size)
+{
+	if (size == 0)
+	{
+		return OSPI_OK;
+	}
+
+	header->checksum = ospi_checkpoint_sum(header->checksum, ctx->cp_chunk, size / sizeof(ULONG));
+
+	if (ospi_leave_memory_mapped(ctx) != OSPI_OK)
 	{
 		return OSPI_ERROR;
 	}
 
-	/* Enable write operations */
-	if (ospi_set_write_enable(hospi) != OSPI_OK)
+	if (ospi_program(ctx, OSPI_CHECKPOINT_RECORDS + header->size, (uint8_t *)ctx->cp_chunk, size) != OSPI_OK)
 	{
 		return OSPI_ERROR;
 	}
 
-	SET_BIT(reg[2], MX25R6435F_CR2_LH_SWITCH);
+	header->size += size;
+
+	return OSPI_OK;
+}
+
+/**
+  * @brief  Save the recorded ranges with their current content in the checkpoint area.
+  *         The header is programmed last, an interrupted save leaves no valid checkpoint.
+  * @param  ctx: driver context of the OSPI instance
+  * @retval O on success 1 on Failure.
+  */
+static uint8_t ospi_checkpoint_save(OSPI_ContextTypeDef *ctx)
+{
+	OSPI_CheckpointHeaderTypeDef header = { OSPI_CHECKPOINT_MAGIC, 0, 0 };
+	OSPI_CheckpointRangeTypeDef *range;
+	uint32_t i, offset, part, fill = 0;
+
+	/* The chunk buffer stages the records from now on */
+	ctx->cp_state = OSPI_CHECKPOINT_INVALID;
+	ctx->cp_chunk_size = 0;
 
-	sCommand.Instruction = WRITE_STATUS_CFG_REG_CMD;
-	sCommand.NbData      = 3;
+	for (i = (OSPI_CHECKPOINT_BASE / LX_STM32_OSPI_SECTOR_SIZE); i < OSPI_BLOCK_COUNT; i++)
+	{
+		if (lx_stm32_ospi_erase_start(ctx->instance, i, 0) != OSPI_OK)
+		{
+			return OSPI_ERROR;
+		}
+	}
 
-	if (HAL_OSPI_Command(hospi, &sCommand, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+	for (i = 0; i < ctx->cp_count; i++)
 	{
-		return OSPI_ERROR;
+		range = &ctx->cp_ranges[i];
+
+		if ((fill + sizeof(*range)) > sizeof(ctx->cp_chunk))
+		{
+			if (ospi_checkpoint_flush(ctx, &header, fill) != OSPI_OK)
+			{
+				return OSPI_ERROR;
+			}
+			fill = 0;
+		}
+
+		memcpy(((uint8_t *)ctx->cp_chunk) + fill, range, sizeof(*range));
+		fill += sizeof(*range);
+
+		for (offset = 0; offset < range->size; offset += part)
+		{
+			if (fill == sizeof(ctx->cp_chunk))
+			{
+				if (ospi_checkpoint_flush(ctx, &header, fill) != OSPI_OK)
+				{
+					return OSPI_ERROR;
+				}
+				fill = 0;
+			}
+
+			part = range->size - offset;
+			if (part > (sizeof(ctx->cp_chunk) - fill))
+			{
+				part = sizeof(ctx->cp_chunk) - fill;
+			}
+
+			if (ospi_read_range(ctx, range->address + offset, ((uint8_t *)ctx->cp_chunk) + fill, part) != OSPI_OK)
+			{
+				return OSPI_ERROR;
+			}
+			fill += part;
+		}
 	}
 
-	if (HAL_OSPI_Transmit(hospi, &(reg[0]), HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+	if (ospi_checkpoint_flush(ctx, &header, fill) != OSPI_OK)
 	{
 		return OSPI_ERROR;
 	}
 
-	/* Wait that memory is ready */
-	if (ospi_auto_polling_ready(hospi, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != OSPI_OK)
+	if (ospi_leave_memory_mapped(ctx) != OSPI_OK)
 	{
 		return OSPI_ERROR;
 	}
 
-	/* Check the configuration has been correctly done */
-	sCommand.Instruction = READ_CFG_REG_CMD;
-	sCommand.NbData      = 2;
-
-	if (HAL_OSPI_Command(hospi, &sCommand, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+	if (ospi_program(ctx, OSPI_CHECKPOINT_BASE, (uint8_t *)&header, sizeof(header)) != OSPI_OK)
 	{
 		return OSPI_ERROR;
 	}
 
-	if (HAL_OSPI_Receive(hospi, &(reg[0]), HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+	ospi_erased_map_update(ctx, OSPI_CHECKPOINT_BASE, OSPI_CHECKPOINT_CAPACITY + LX_STM32_OSPI_PAGE_SIZE, 0);
+
+	return ospi_wait_pending(ctx);
+}
+#endif
+
+#if (LX_STM32_OSPI_DMA_API == 1)
+/**
+  * @brief  Configure the DMA channel used for the data phase and link it to the OSPI handle.
+  *         The direction is updated by the HAL on each HAL_OSPI_Receive_DMA/HAL_OSPI_Transmit_DMA call.
+  * @param  ctx: driver context of the OSPI instance
+  * @retval O on success 1 on Failure.
+  */
+static uint8_t ospi_dma_init(OSPI_ContextTypeDef *ctx)
+{
+	__HAL_RCC_DMAMUX1_CLK_ENABLE();
+	__HAL_RCC_DMA1_CLK_ENABLE();
+
+	ctx->dma_handle.Instance                 = ctx->dma_channel;
+	ctx->dma_handle.Init.Request             = ctx->dma_request;
+	ctx->dma_handle.Init.Direction           = DMA_PERIPH_TO_MEMORY;
+	ctx->dma_handle.Init.PeriphInc           = DMA_PINC_DISABLE;
+	ctx->dma_handle.Init.MemInc              = DMA_MINC_ENABLE;
+	ctx->dma_handle.Init.PeriphDataAlignment = DMA_PDATAALIGN_WORD;
+	ctx->dma_handle.Init.MemDataAlignment    = DMA_MDATAALIGN_WORD;
+	ctx->dma_handle.Init.Mode                = DMA_NORMAL;
+	ctx->dma_handle.Init.Priority            = DMA_PRIORITY_HIGH;
+
+	if (HAL_DMA_Init(&ctx->dma_handle) != HAL_OK)
 	{
 		return OSPI_ERROR;
 	}
 
+	__HAL_LINKDMA(ctx->hospi, hdma, ctx->dma_handle);
+
+	HAL_NVIC_SetPriority(ctx->dma_irqn, 0, 0);
+	HAL_NVIC_EnableIRQ(ctx->dma_irqn);
+
 	return OSPI_OK;
 }
 
+/**
+  * @brief  DMA channel interrupt handler for the OSPI data phase.
+  * @retval None
+  */
+void LX_STM32_OSPI_DMA_IRQHandler(void)
+{
+	HAL_DMA_IRQHandler(&ospi_ctx[0].dma_handle);
+}
+
+#if (LX_STM32_OSPI_INSTANCE_COUNT > 1)
+/**
+  * @brief  DMA channel interrupt handler for the data phase of the second OSPI instance.
+  * @retval None
+  */
+void LX_STM32_OSPI2_DMA_IRQHandler(void)
+{
+	HAL_DMA_IRQHandler(&ospi_ctx[1].dma_handle);
+}
+#endif
+#endif
+
+/**
+  * @brief  Find the driver context of an OSPI handle.
+  * @param  hospi: OSPI handle pointer
+  * @retval the context, NULL if the handle is not driven by LevelX.
+  */
+static OSPI_ContextTypeDef *ospi_context_of(OSPI_HandleTypeDef *hospi)
+{
+	UINT i;
+
+	for (i = 0; i < LX_STM32_OSPI_INSTANCE_COUNT; i++)
+	{
+		if (ospi_ctx[i].hospi == hospi)
+		{
+			return &ospi_ctx[i];
+		}
+	}
+
+	return NULL;
+}
 
 /**
   * @brief  Rx Transfer completed callbacks.
@@ -744,8 +3131,30 @@ static uint8_t ospi_highperf_mode(OSPI_HandleTypeDef *hospi)
   */
 void HAL_OSPI_RxCpltCallback(OSPI_HandleTypeDef *hospi)
 {
-	tx_semaphore_put(&ospi_rx_semaphore);
+	OSPI_ContextTypeDef *ctx = ospi_context_of(hospi);
+
+	if (ctx != NULL)
+	{
+		tx_semaphore_put(&ospi_rx_semaphore[ctx->instance]);
+	}
+}
+
+#if (LX_STM32_OSPI_AUTO_POLLING_IT == 1)
+/**
+  * @brief  Status Match callbacks.
+  * @param  hospi OSPI handle
+  * @retval None
+  */
+void HAL_OSPI_StatusMatchCallback(OSPI_HandleTypeDef *hospi)
+{
+	OSPI_ContextTypeDef *ctx = ospi_context_of(hospi);
+
+	if (ctx != NULL)
+	{
+		tx_semaphore_put(&ctx->status_semaphore);
+	}
 }
+#endif
 
 /**
   * @brief  Tx Transfer completed callbacks.
@@ -754,5 +3163,10 @@ void HAL_OSPI_RxCpltCallback(OSPI_HandleTypeDef *hospi)
   */
 void HAL_OSPI_TxCpltCallback(OSPI_HandleTypeDef *hospi)
 {
-	tx_semaphore_put(&ospi_tx_semaphore);
+	OSPI_ContextTypeDef *ctx = ospi_context_of(hospi);
+
+	if (ctx != NULL)
+	{
+		tx_semaphore_put(&ospi_tx_semaphore[ctx->instance]);
+	}
 }
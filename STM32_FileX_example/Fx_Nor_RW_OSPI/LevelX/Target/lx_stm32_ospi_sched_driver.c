@@ -0,0 +1,519 @@
+#include "lx_stm32_ospi_driver.h"
+#include <string.h>
+
+#if (LX_STM32_OSPI_SCHED == 1)
+
+/* request posted by a client, on the client stack until the scheduler completes it */
+typedef struct OSPI_SchedRequest
+{
+	UINT                      op;
+	ULONG                    *address;
+	ULONG                    *buffer;
+	ULONG                     words;
+	/* words of a write already programmed */
+	ULONG                     programmed;
+	/* tx_time_get() value by which the request should be served */
+	ULONG                     deadline;
+	/* cycle count at submission, for the latency accounting */
+	uint32_t                  submit;
+	INT                       status;
+	TX_SEMAPHORE              done;
+	struct OSPI_SchedRequest *next;
+} OSPI_SchedRequestTypeDef;
+
+static UINT lx_ospi_sched_read(ULONG *flash_address, ULONG *destination, ULONG words);
+static UINT lx_ospi_sched_write(ULONG *flash_address, ULONG *source, ULONG words);
+static UINT lx_ospi_sched_block_erase(ULONG block, ULONG erase_count);
+static UINT lx_ospi_sched_block_erased_verify(ULONG block);
+static UINT lx_ospi_sched_system_error(UINT error_code);
+static void ospi_sched_thread_entry(ULONG thread_input);
+static void ospi_sched_enqueue(OSPI_SchedRequestTypeDef *request);
+static void ospi_sched_requeue(OSPI_SchedRequestTypeDef *request);
+static OSPI_SchedRequestTypeDef *ospi_sched_next(void);
+static INT ospi_sched_execute(OSPI_SchedRequestTypeDef *request);
+static void ospi_sched_account(OSPI_SchedRequestTypeDef *request);
+
+/* the LevelX sector buffer of the glue, unused by the glue when LevelX goes through the scheduler */
+extern ULONG ospi_sector_buffer[];
+
+static TX_THREAD ospi_sched_thread;
+static ULONG ospi_sched_stack[LX_STM32_OSPI_SCHED_STACK_SIZE / sizeof(ULONG)];
+static TX_QUEUE ospi_sched_queue;
+static ULONG ospi_sched_queue_memory[LX_STM32_OSPI_SCHED_QUEUE_DEPTH];
+
+/* requests taken from the queue: the reads by deadline, the other requests in submission order */
+static OSPI_SchedRequestTypeDef *ospi_sched_reads;
+static OSPI_SchedRequestTypeDef *ospi_sched_writes;
+static OSPI_SchedRequestTypeDef *ospi_sched_writes_tail;
+static UINT ospi_sched_pending;
+/* reads served since the last write */
+static UINT ospi_sched_burst;
+
+static LX_STM32_OSPI_SCHED_STATS ospi_sched_stats;
+
+static UINT ospi_sched_initialized = LX_FALSE;
+
+/**
+* @brief Initialize a LevelX NOR instance whose flash accesses go through the scheduler thread
+* @param LX_NOR_FLASH * nor_flash the LevelX instance to initialize
+* @retval LX_SUCCESS on Success LX_ERROR on Failure
+*/
+UINT lx_stm32_ospi_sched_initialize(LX_NOR_FLASH *nor_flash)
+{
+	ULONG block_size, total_blocks;
+
+	if (ospi_sched_initialized == LX_FALSE)
+	{
+		if (lx_stm32_ospi_lowlevel_init(LX_STM32_OSPI_INSTANCE) != 0)
+		{
+			return LX_ERROR;
+		}
+
+		if (tx_semaphore_create(&ospi_rx_semaphore[LX_STM32_OSPI_INSTANCE], "ospi rx transfer semaphore", 0) != TX_SUCCESS)
+		{
+			return LX_ERROR;
+		}
+
+		if (tx_semaphore_create(&ospi_tx_semaphore[LX_STM32_OSPI_INSTANCE], "ospi tx transfer semaphore", 0) != TX_SUCCESS)
+		{
+			return LX_ERROR;
+		}
+
+		if (tx_queue_create(&ospi_sched_queue, "ospi scheduler queue", TX_1_ULONG,
+		                    ospi_sched_queue_memory, sizeof(ospi_sched_queue_memory)) != TX_SUCCESS)
+		{
+			return LX_ERROR;
+		}
+
+		/* From here on only the scheduler thread drives the OSPI instance */
+		if (tx_thread_create(&ospi_sched_thread, "ospi scheduler thread", ospi_sched_thread_entry, 0,
+		                     ospi_sched_stack, sizeof(ospi_sched_stack), LX_STM32_OSPI_SCHED_THREAD_PRIO,
+		                     LX_STM32_OSPI_SCHED_THREAD_PRIO, TX_NO_TIME_SLICE, TX_AUTO_START) != TX_SUCCESS)
+		{
+			return LX_ERROR;
+		}
+
+		ospi_sched_initialized = LX_TRUE;
+	}
+
+	if (lx_stm32_ospi_get_info(LX_STM32_OSPI_INSTANCE, &block_size, &total_blocks) != 0)
+	{
+		return LX_ERROR;
+	}
+
+	nor_flash->lx_nor_flash_base_address = 0;
+	nor_flash->lx_nor_flash_total_blocks = total_blocks;
+	nor_flash->lx_nor_flash_words_per_block = block_size / sizeof(ULONG);
+
+	nor_flash->lx_nor_flash_driver_read = lx_ospi_sched_read;
+	nor_flash->lx_nor_flash_driver_write = lx_ospi_sched_write;
+	nor_flash->lx_nor_flash_driver_block_erase = lx_ospi_sched_block_erase;
+	nor_flash->lx_nor_flash_driver_block_erased_verify = lx_ospi_sched_block_erased_verify;
+	nor_flash->lx_nor_flash_driver_system_error = lx_ospi_sched_system_error;
+
+	nor_flash->lx_nor_flash_sector_buffer = &ospi_sector_buffer[0];
+
+	lx_stm32_ospi_nor_flash = nor_flash;
+
+	return LX_SUCCESS;
+}
+
+/**
+* @brief Post a request to the scheduler and wait for its completion, callable from any thread but the scheduler
+* @param UINT op the request, one of LX_STM32_OSPI_SCHED_OP
+* @param ULONG * address the flash address, or the block for an erase or a blank check
+* @param ULONG * buffer the source or destination buffer of a write or a read
+* @param ULONG words the number of words to write or read
+* @param ULONG deadline_ms the time from now by which the request should be served, 0 for the default of op
+* @retval 0 on Success 1 on Failure
+*/
+INT lx_stm32_ospi_sched_io(UINT op, ULONG *address, ULONG *buffer, ULONG words, ULONG deadline_ms)
+{
+	OSPI_SchedRequestTypeDef request;
+	OSPI_SchedRequestTypeDef *message = &request;
+
+	if ((op >= LX_STM32_OSPI_SCHED_OP_COUNT) || (ospi_sched_initialized == LX_FALSE))
+	{
+		return 1;
+	}
+
+	if (deadline_ms == 0)
+	{
+		deadline_ms = (op == LX_STM32_OSPI_SCHED_READ) ? LX_STM32_OSPI_SCHED_READ_DEADLINE_MS :
+		              (op == LX_STM32_OSPI_SCHED_WRITE) ? LX_STM32_OSPI_SCHED_WRITE_DEADLINE_MS : LX_STM32_OSPI_SCHED_ERASE_DEADLINE_MS;
+	}
+
+	request.op = op;
+	request.address = address;
+	request.buffer = buffer;
+	request.words = words;
+	request.programmed = 0;
+	request.deadline = tx_time_get() + LX_STM32_OSPI_MS_TO_TICKS(deadline_ms);
+	request.submit = LX_STM32_OSPI_CYCLE_COUNT();
+	request.status = 1;
+
+	if (tx_semaphore_create(&request.done, "ospi request semaphore", 0) != TX_SUCCESS)
+	{
+		return 1;
+	}
+
+	/* The message is the request address, tx_queue_send() copies the message from the pointer given */
+	if ((tx_queue_send(&ospi_sched_queue, (VOID *)&message, TX_WAIT_FOREVER) != TX_SUCCESS) ||
+	    (tx_semaphore_get(&request.done, TX_WAIT_FOREVER) != TX_SUCCESS))
+	{
+		tx_semaphore_delete(&request.done);
+		return 1;
+	}
+
+	tx_semaphore_delete(&request.done);
+
+	return request.status;
+}
+
+/**
+* @brief Get the scheduler accounting
+* @param LX_STM32_OSPI_SCHED_STATS * stats filled with the accounting
+* @retval None
+*/
+VOID lx_stm32_ospi_sched_get_stats(LX_STM32_OSPI_SCHED_STATS *stats)
+{
+	TX_INTERRUPT_SAVE_AREA
+
+	TX_DISABLE
+	*stats = ospi_sched_stats;
+	TX_RESTORE
+}
+
+/**
+* @brief Reset the scheduler accounting
+* @retval None
+*/
+VOID lx_stm32_ospi_sched_reset_stats(VOID)
+{
+	TX_INTERRUPT_SAVE_AREA
+
+	TX_DISABLE
+	memset(&ospi_sched_stats, 0, sizeof(ospi_sched_stats));
+	TX_RESTORE
+}
+
+/**
+* @brief Read a range of the LevelX instance through the scheduler
+* @param ULONG * flash_address LevelX address of the range
+* @param ULONG * destination the destination buffer
+* @param ULONG words the total number of words to be read
+* @retval LX_SUCCESS on Success LX_ERROR on Failure
+*/
+static UINT lx_ospi_sched_read(ULONG *flash_address, ULONG *destination, ULONG words)
+{
+	lx_stm32_ospi_area_account(flash_address, words);
+
+	if (lx_stm32_ospi_sched_io(LX_STM32_OSPI_SCHED_READ, flash_address, destination, words, 0) != 0)
+	{
+		return LX_ERROR;
+	}
+
+	return LX_SUCCESS;
+}
+
+/**
+* @brief Program a range of the LevelX instance through the scheduler
+* @param ULONG * flash_address LevelX address of the range
+* @param ULONG * source the data source buffer
+* @param ULONG words the total number of words to be written
+* @retval LX_SUCCESS on Success LX_ERROR on Failure
+*/
+static UINT lx_ospi_sched_write(ULONG *flash_address, ULONG *source, ULONG words)
+{
+	if (lx_stm32_ospi_sched_io(LX_STM32_OSPI_SCHED_WRITE, flash_address, source, words, 0) != 0)
+	{
+		return LX_ERROR;
+	}
+
+	return LX_SUCCESS;
+}
+
+/**
+* @brief Erase a block of the LevelX instance through the scheduler
+* @param ULONG block the LevelX block to be erased
+* @param ULONG erase_count the number of times the block was erased
+* @retval LX_SUCCESS on Success LX_ERROR on Failure
+*/
+static UINT lx_ospi_sched_block_erase(ULONG block, ULONG erase_count)
+{
+	if (lx_stm32_ospi_sched_io(LX_STM32_OSPI_SCHED_ERASE, (ULONG *)block, NULL, 0, 0) != 0)
+	{
+		return LX_ERROR;
+	}
+
+	return LX_SUCCESS;
+}
+
+/**
+* @brief Check that a block of the LevelX instance is erased, through the scheduler
+* @param ULONG block the LevelX block to be checked
+* @retval LX_SUCCESS on Success LX_ERROR on Failure
+*/
+static UINT lx_ospi_sched_block_erased_verify(ULONG block)
+{
+	if (lx_stm32_ospi_sched_io(LX_STM32_OSPI_SCHED_VERIFY, (ULONG *)block, NULL, 0, 0) != 0)
+	{
+		return LX_ERROR;
+	}
+
+	return LX_SUCCESS;
+}
+
+/**
+* @brief Handle levelx system errors
+* @param UINT error_code Code of the concerned error.
+* @retval UINT error code.
+*/
+static UINT lx_ospi_sched_system_error(UINT error_code)
+{
+	return lx_ospi_driver_system_error(error_code);
+}
+
+/**
+  * @brief  Scheduler thread entry: takes the posted requests and serves them one at a time.
+  * @param  thread_input: unused
+  * @retval None
+  */
+static void ospi_sched_thread_entry(ULONG thread_input)
+{
+	OSPI_SchedRequestTypeDef *request;
+	OSPI_SchedRequestTypeDef *message;
+	ULONG wait;
+
+	while(1)
+	{
+		/* Take all the posted requests before choosing, sleep only when none is left */
+		wait = (ospi_sched_pending == 0) ? TX_WAIT_FOREVER : TX_NO_WAIT;
+		while (tx_queue_receive(&ospi_sched_queue, (VOID *)&message, wait) == TX_SUCCESS)
+		{
+			ospi_sched_enqueue(message);
+			wait = TX_NO_WAIT;
+		}
+
+		request = ospi_sched_next();
+		if (request == NULL)
+		{
+			continue;
+		}
+
+		request->status = ospi_sched_execute(request);
+
+		/* The rest of a write waits behind the reads posted meanwhile */
+		if ((request->status == 0) && (request->programmed < request->words))
+		{
+			ospi_sched_requeue(request);
+			continue;
+		}
+
+		ospi_sched_account(request);
+
+		/* The request may go out of scope as soon as the client runs */
+		tx_semaphore_put(&request->done);
+	}
+}
+
+/**
+  * @brief  Add a request to the pending ones: a read by deadline, any other request at the end.
+  * @param  request: the request taken from the queue
+  * @retval None
+  */
+static void ospi_sched_enqueue(OSPI_SchedRequestTypeDef *request)
+{
+	OSPI_SchedRequestTypeDef **link;
+
+	request->next = NULL;
+
+	if (request->op == LX_STM32_OSPI_SCHED_READ)
+	{
+		/* Earliest deadline first, in submission order for equal deadlines */
+		link = &ospi_sched_reads;
+		while ((*link != NULL) && ((LONG)(request->deadline - (*link)->deadline) >= 0))
+		{
+			link = &((*link)->next);
+		}
+		request->next = *link;
+		*link = request;
+	}
+	else
+	{
+		/* Programs, erases and blank checks are served in the LevelX order */
+		if (ospi_sched_writes == NULL)
+		{
+			ospi_sched_writes = request;
+		}
+		else
+		{
+			ospi_sched_writes_tail->next = request;
+		}
+		ospi_sched_writes_tail = request;
+	}
+
+	ospi_sched_pending++;
+	if (ospi_sched_pending > ospi_sched_stats.max_pending)
+	{
+		ospi_sched_stats.max_pending = ospi_sched_pending;
+	}
+}
+
+/**
+  * @brief  Put back the rest of a partially programmed write at the head of the writes.
+  * @param  request: the write
+  * @retval None
+  */
+static void ospi_sched_requeue(OSPI_SchedRequestTypeDef *request)
+{
+	request->next = ospi_sched_writes;
+	if (ospi_sched_writes == NULL)
+	{
+		ospi_sched_writes_tail = request;
+	}
+	ospi_sched_writes = request;
+
+	ospi_sched_pending++;
+}
+
+/**
+  * @brief  Choose the next request to serve. Reads go first, unless LX_STM32_OSPI_SCHED_READ_BURST
+  *         reads were served since the last write, or the oldest write reached its deadline and
+  *         a read was served since the last write.
+  * @retval the request removed from the pending ones, NULL if none is pending
+  */
+static OSPI_SchedRequestTypeDef *ospi_sched_next(void)
+{
+	OSPI_SchedRequestTypeDef *request;
+
+	if ((ospi_sched_writes != NULL) &&
+	    ((ospi_sched_reads == NULL) || (ospi_sched_burst >= LX_STM32_OSPI_SCHED_READ_BURST) ||
+	     ((ospi_sched_burst != 0) && ((LONG)(tx_time_get() - ospi_sched_writes->deadline) >= 0))))
+	{
+		if (ospi_sched_reads != NULL)
+		{
+			ospi_sched_stats.promotions++;
+		}
+
+		request = ospi_sched_writes;
+		ospi_sched_writes = request->next;
+		ospi_sched_burst = 0;
+	}
+	else if (ospi_sched_reads != NULL)
+	{
+		request = ospi_sched_reads;
+		ospi_sched_reads = request->next;
+		ospi_sched_burst++;
+	}
+	else
+	{
+		return NULL;
+	}
+
+	ospi_sched_pending--;
+
+	return request;
+}
+
+/**
+  * @brief  Serve a request on the OSPI instance, a write up to the end of its next slice. With
+  *         LX_STM32_OSPI_DEFERRED_BUSY_WAIT programs and erases are only started: a read served
+  *         while one is in progress suspends it, the end of both is checked by the next program,
+  *         erase or blank check. Otherwise the last slice of a write and an erase are waited for.
+  * @param  request: the request to serve
+  * @retval 0 on success 1 on Failure.
+  */
+static INT ospi_sched_execute(OSPI_SchedRequestTypeDef *request)
+{
+	ULONG address, words;
+
+	switch (request->op)
+	{
+	case LX_STM32_OSPI_SCHED_READ:
+		if (lx_stm32_ospi_read_start(LX_STM32_OSPI_INSTANCE, request->address, request->buffer, request->words) != 0)
+		{
+			return 1;
+		}
+		return lx_stm32_ospi_read_wait(LX_STM32_OSPI_INSTANCE);
+
+	case LX_STM32_OSPI_SCHED_WRITE:
+		/* Slices are aligned so that a slice of a page multiple never splits a page */
+		address = (ULONG)request->address + (request->programmed * sizeof(ULONG));
+		words = (LX_STM32_OSPI_SCHED_WRITE_SLICE - (address % LX_STM32_OSPI_SCHED_WRITE_SLICE)) / sizeof(ULONG);
+		if (words > (request->words - request->programmed))
+		{
+			words = request->words - request->programmed;
+		}
+
+		if (lx_stm32_ospi_write_start(LX_STM32_OSPI_INSTANCE, (ULONG *)address, request->buffer + request->programmed, words) != 0)
+		{
+			return 1;
+		}
+
+		request->programmed += words;
+#if (LX_STM32_OSPI_DEFERRED_BUSY_WAIT == 0)
+		/* Without deferred busy wait a write completes with its last slice */
+		if (request->programmed == request->words)
+		{
+			return lx_stm32_ospi_wait_ready(LX_STM32_OSPI_INSTANCE);
+		}
+#endif
+		return 0;
+
+	case LX_STM32_OSPI_SCHED_ERASE:
+		if (lx_stm32_ospi_erase_start(LX_STM32_OSPI_INSTANCE, (ULONG)request->address, 0) != 0)
+		{
+			return 1;
+		}
+#if (LX_STM32_OSPI_DEFERRED_BUSY_WAIT == 0)
+		return lx_stm32_ospi_wait_ready(LX_STM32_OSPI_INSTANCE);
+#else
+		return 0;
+#endif
+
+	case LX_STM32_OSPI_SCHED_VERIFY:
+		return lx_stm32_ospi_is_block_erased(LX_STM32_OSPI_INSTANCE, (ULONG)request->address);
+
+	case LX_STM32_OSPI_SCHED_FLUSH:
+		return lx_stm32_ospi_flush(LX_STM32_OSPI_INSTANCE);
+
+	default:
+		return 1;
+	}
+}
+
+/**
+  * @brief  Account the latency of a served request, from its submission.
+  * @param  request: the served request
+  * @retval None
+  */
+static void ospi_sched_account(OSPI_SchedRequestTypeDef *request)
+{
+	TX_INTERRUPT_SAVE_AREA
+	LX_STM32_OSPI_OP_STATS *stats = &ospi_sched_stats.op[request->op];
+	uint32_t cycles = LX_STM32_OSPI_CYCLE_COUNT() - request->submit;
+	UINT bucket = 0;
+
+	if (cycles >= (1UL << LX_STM32_OSPI_LATENCY_MIN_LOG2))
+	{
+		bucket = LX_STM32_OSPI_LOG2(cycles) - LX_STM32_OSPI_LATENCY_MIN_LOG2;
+		if (bucket >= LX_STM32_OSPI_LATENCY_BUCKETS)
+		{
+			bucket = LX_STM32_OSPI_LATENCY_BUCKETS - 1;
+		}
+	}
+
+	TX_DISABLE
+	stats->count++;
+	stats->bytes += request->words * sizeof(ULONG);
+	stats->total_cycles += cycles;
+	stats->histogram[bucket]++;
+	if (cycles > stats->max_cycles)
+	{
+		stats->max_cycles = cycles;
+	}
+	TX_RESTORE
+}
+
+#endif /* LX_STM32_OSPI_SCHED == 1 */
@@ -0,0 +1,299 @@
+#include "lx_stm32_ospi_driver.h"
+
+#if (LX_STM32_OSPI_STRIPE == 1)
+
+#if ((LX_STM32_OSPI_STRIPE_UNIT & (LX_STM32_OSPI_STRIPE_UNIT - 1)) != 0) || ((LX_STM32_OSPI_PAGE_SIZE % LX_STM32_OSPI_STRIPE_UNIT) != 0) || ((LX_STM32_OSPI_STRIPE_UNIT % 4) != 0)
+#error "LX_STM32_OSPI_STRIPE_UNIT must be a power of 2 dividing LX_STM32_OSPI_PAGE_SIZE"
+#endif
+
+/* number of OSPI instances a LevelX block is striped over */
+#define OSPI_STRIPE_WIDTH       2
+
+/* size of a LevelX block: the same erase unit on each memory */
+#define OSPI_STRIPE_BLOCK_SIZE  (OSPI_STRIPE_WIDTH * LX_STM32_OSPI_SECTOR_SIZE)
+
+static UINT lx_ospi_stripe_read(ULONG *flash_address, ULONG *destination, ULONG words);
+static UINT lx_ospi_stripe_write(ULONG *flash_address, ULONG *source, ULONG words);
+static UINT lx_ospi_stripe_block_erase(ULONG block, ULONG erase_count);
+static UINT lx_ospi_stripe_block_erased_verify(ULONG block);
+static UINT lx_ospi_stripe_system_error(UINT error_code);
+static void ospi_stripe_map(ULONG address, UINT *instance, ULONG *device_address);
+static UINT ospi_stripe_wait_ready(void);
+
+static ULONG ospi_stripe_sector_buffer[OSPI_STRIPE_BLOCK_SIZE / sizeof(ULONG)];
+
+static UINT ospi_stripe_initialized = LX_FALSE;
+
+/**
+* @brief Initialize a LevelX NOR instance striped over the two OSPI instances
+* @param LX_NOR_FLASH * nor_flash the LevelX instance to initialize
+* @retval LX_SUCCESS on Success LX_ERROR on Failure
+*/
+UINT lx_stm32_ospi_stripe_initialize(LX_NOR_FLASH *nor_flash)
+{
+	ULONG block_size, total_blocks;
+	UINT instance;
+
+	if (ospi_stripe_initialized == LX_FALSE)
+	{
+		for (instance = 0; instance < OSPI_STRIPE_WIDTH; instance++)
+		{
+			if (lx_stm32_ospi_lowlevel_init(instance) != 0)
+			{
+				return LX_ERROR;
+			}
+
+			if (tx_semaphore_create(&ospi_rx_semaphore[instance], "ospi rx transfer semaphore", 0) != TX_SUCCESS)
+			{
+				return LX_ERROR;
+			}
+
+			if (tx_semaphore_create(&ospi_tx_semaphore[instance], "ospi tx transfer semaphore", 0) != TX_SUCCESS)
+			{
+				return LX_ERROR;
+			}
+		}
+
+		ospi_stripe_initialized = LX_TRUE;
+	}
+
+	/* Both memories have the same geometry */
+	if (lx_stm32_ospi_get_info(0, &block_size, &total_blocks) != 0)
+	{
+		return LX_ERROR;
+	}
+
+	nor_flash->lx_nor_flash_base_address = 0;
+	nor_flash->lx_nor_flash_total_blocks = total_blocks;
+	nor_flash->lx_nor_flash_words_per_block = (OSPI_STRIPE_WIDTH * block_size) / sizeof(ULONG);
+
+	nor_flash->lx_nor_flash_driver_read = lx_ospi_stripe_read;
+	nor_flash->lx_nor_flash_driver_write = lx_ospi_stripe_write;
+	nor_flash->lx_nor_flash_driver_block_erase = lx_ospi_stripe_block_erase;
+	nor_flash->lx_nor_flash_driver_block_erased_verify = lx_ospi_stripe_block_erased_verify;
+	nor_flash->lx_nor_flash_driver_system_error = lx_ospi_stripe_system_error;
+
+	nor_flash->lx_nor_flash_sector_buffer = &ospi_stripe_sector_buffer[0];
+
+	lx_stm32_ospi_nor_flash = nor_flash;
+
+	return LX_SUCCESS;
+}
+
+/**
+* @brief Read a striped range, the chunks of both memories are read at the same time
+* @param ULONG * flash_address LevelX address of the range
+* @param ULONG * destination the destination buffer
+* @param ULONG words the total number of words to be read
+* @retval LX_SUCCESS on Success LX_ERROR on Failure
+*/
+static UINT lx_ospi_stripe_read(ULONG *flash_address, ULONG *destination, ULONG words)
+{
+	ULONG address = (ULONG)flash_address;
+	ULONG remaining = words * sizeof(ULONG);
+	UCHAR *buffer = (UCHAR *)destination;
+	ULONG device_address, chunk;
+	UINT started[OSPI_STRIPE_WIDTH];
+	UINT instance, i;
+	UINT status = LX_SUCCESS;
+
+	lx_stm32_ospi_area_account(flash_address, words);
+
+	while ((remaining != 0) && (status == LX_SUCCESS))
+	{
+		/* Consecutive chunks are on different memories, start one read on each */
+		for (instance = 0; instance < OSPI_STRIPE_WIDTH; instance++)
+		{
+			started[instance] = LX_FALSE;
+		}
+
+		for (i = 0; (i < OSPI_STRIPE_WIDTH) && (remaining != 0); i++)
+		{
+			ospi_stripe_map(address, &instance, &device_address);
+
+			chunk = LX_STM32_OSPI_STRIPE_UNIT - (address % LX_STM32_OSPI_STRIPE_UNIT);
+			if (chunk > remaining)
+			{
+				chunk = remaining;
+			}
+
+			if (lx_stm32_ospi_read_start(instance, (ULONG *)device_address, (ULONG *)buffer, chunk / sizeof(ULONG)) != 0)
+			{
+				status = LX_ERROR;
+				break;
+			}
+
+			started[instance] = LX_TRUE;
+			address += chunk;
+			buffer += chunk;
+			remaining -= chunk;
+		}
+
+		/* Reads already started are completed even on failure */
+		for (instance = 0; instance < OSPI_STRIPE_WIDTH; instance++)
+		{
+			if ((started[instance] == LX_TRUE) && (lx_stm32_ospi_read_wait(instance) != 0))
+			{
+				status = LX_ERROR;
+			}
+		}
+	}
+
+	return status;
+}
+
+/**
+* @brief Program a striped range, a memory programs its chunk while the next chunk is sent to the other one
+* @param ULONG * flash_address LevelX address of the range
+* @param ULONG * source the data source buffer
+* @param ULONG words the total number of words to be written
+* @retval LX_SUCCESS on Success LX_ERROR on Failure
+*/
+static UINT lx_ospi_stripe_write(ULONG *flash_address, ULONG *source, ULONG words)
+{
+	ULONG address = (ULONG)flash_address;
+	ULONG remaining = words * sizeof(ULONG);
+	UCHAR *buffer = (UCHAR *)source;
+	ULONG device_address, chunk;
+	UINT instance;
+
+	while (remaining != 0)
+	{
+		ospi_stripe_map(address, &instance, &device_address);
+
+		chunk = LX_STM32_OSPI_STRIPE_UNIT - (address % LX_STM32_OSPI_STRIPE_UNIT);
+		if (chunk > remaining)
+		{
+			chunk = remaining;
+		}
+
+#if (LX_STM32_OSPI_WRITE_COALESCE == 1)
+		/* A write kept in RAM by the other memory is programmed first, in the LevelX order */
+		if (lx_stm32_ospi_flush((instance + 1) % OSPI_STRIPE_WIDTH) != 0)
+		{
+			return LX_ERROR;
+		}
+#endif
+
+		/* Waits for the end of the previous program of this memory only */
+		if (lx_stm32_ospi_write_start(instance, (ULONG *)device_address, (ULONG *)buffer, chunk / sizeof(ULONG)) != 0)
+		{
+			return LX_ERROR;
+		}
+
+		address += chunk;
+		buffer += chunk;
+		remaining -= chunk;
+	}
+
+#if (LX_STM32_OSPI_DEFERRED_BUSY_WAIT == 0)
+	return ospi_stripe_wait_ready();
+#else
+	return LX_SUCCESS;
+#endif
+}
+
+/**
+* @brief Erase a striped block, both memories erase their part at the same time
+* @param ULONG block the LevelX block to be erased
+* @param ULONG erase_count the number of times the block was erased
+* @retval LX_SUCCESS on Success LX_ERROR on Failure
+*/
+static UINT lx_ospi_stripe_block_erase(ULONG block, ULONG erase_count)
+{
+	UINT instance;
+
+#if (LX_STM32_OSPI_WRITE_COALESCE == 1)
+	/* The writes kept in RAM by both memories are programmed before the erase starts */
+	for (instance = 0; instance < OSPI_STRIPE_WIDTH; instance++)
+	{
+		if (lx_stm32_ospi_flush(instance) != 0)
+		{
+			return LX_ERROR;
+		}
+	}
+#endif
+
+	for (instance = 0; instance < OSPI_STRIPE_WIDTH; instance++)
+	{
+		if (lx_stm32_ospi_erase_start(instance, block, 0) != 0)
+		{
+			return LX_ERROR;
+		}
+	}
+
+#if (LX_STM32_OSPI_DEFERRED_BUSY_WAIT == 0)
+	return ospi_stripe_wait_ready();
+#else
+	return LX_SUCCESS;
+#endif
+}
+
+/**
+* @brief Check that a striped block is erased on both memories
+* @param ULONG block the LevelX block to be checked
+* @retval LX_SUCCESS on Success LX_ERROR on Failure
+*/
+static UINT lx_ospi_stripe_block_erased_verify(ULONG block)
+{
+	UINT instance;
+
+	for (instance = 0; instance < OSPI_STRIPE_WIDTH; instance++)
+	{
+		if (lx_stm32_ospi_is_block_erased(instance, block) != 0)
+		{
+			return LX_ERROR;
+		}
+	}
+
+	return LX_SUCCESS;
+}
+
+/**
+* @brief Handle levelx system errors
+* @param UINT error_code Code of the concerned error.
+* @retval UINT error code.
+*/
+static UINT lx_ospi_stripe_system_error(UINT error_code)
+{
+	return lx_ospi_driver_system_error(error_code);
+}
+
+/**
+  * @brief  Translate a LevelX address into an OSPI instance and an address in its memory.
+  *         Stripe unit n of the LevelX address space is unit n / 2 of memory n % 2,
+  *         so LevelX block b is made of block b of both memories.
+  * @param  address: LevelX address
+  * @param  instance: filled with the OSPI instance holding the address
+  * @param  device_address: filled with the address in the memory of that instance
+  * @retval None
+  */
+static void ospi_stripe_map(ULONG address, UINT *instance, ULONG *device_address)
+{
+	ULONG unit = address / LX_STM32_OSPI_STRIPE_UNIT;
+
+	*instance = (UINT)(unit % OSPI_STRIPE_WIDTH);
+	*device_address = ((unit / OSPI_STRIPE_WIDTH) * LX_STM32_OSPI_STRIPE_UNIT) + (address % LX_STM32_OSPI_STRIPE_UNIT);
+}
+
+/**
+  * @brief  Wait for the end of the program or erase in progress on both memories.
+  * @retval LX_SUCCESS on Success LX_ERROR on Failure
+  */
+static UINT ospi_stripe_wait_ready(void)
+{
+	UINT instance;
+	UINT status = LX_SUCCESS;
+
+	for (instance = 0; instance < OSPI_STRIPE_WIDTH; instance++)
+	{
+		if (lx_stm32_ospi_wait_ready(instance) != 0)
+		{
+			status = LX_ERROR;
+		}
+	}
+
+	return status;
+}
+
+#endif /* LX_STM32_OSPI_STRIPE == 1 */
@@ -0,0 +1,26 @@
+/**
+  ******************************************************************************
+  * @file    main.h
+  * @brief   Host replacement of the application main.h for the simulator build.
+  ******************************************************************************
+  */
+
+#ifndef __MAIN_H
+#define __MAIN_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32l4xx_hal.h"
+
+void Error_Handler(void);
+
+#define LED2_Pin        GPIO_PIN_14
+#define LED2_GPIO_Port  GPIOB
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MAIN_H */
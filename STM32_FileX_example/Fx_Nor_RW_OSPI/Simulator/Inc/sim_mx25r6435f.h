@@ -0,0 +1,111 @@
+/**
+  ******************************************************************************
+  * @file    sim_mx25r6435f.h
+  * @brief   Host simulator of the MX25R6435F NOR flash behind the HAL OSPI API.
+  ******************************************************************************
+  * The simulator replaces the OctoSPI peripheral and the memory in a host build
+  * of the application (ThreadX Linux port). It keeps a simulated clock: the host
+  * monotonic time plus the time the simulated CPU spent waiting on the memory,
+  * so that an operation overlapping CPU work costs only its remaining time.
+  ******************************************************************************
+  */
+
+#ifndef SIM_MX25R6435F_H
+#define SIM_MX25R6435F_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "mx25r6425f.h"
+
+/* number of simulated memories, one per OctoSPI instance */
+#define SIM_MX25R_INSTANCE_COUNT         2
+
+/* when set to 1 the waits on the memory sleep for real instead of moving the simulated clock,
+ * the figures based on tx_time_get() then match the ones based on the cycle counter.
+ */
+#ifndef SIM_MX25R_REALTIME
+#define SIM_MX25R_REALTIME               0
+#endif
+
+/* Timings of the memory and of the bus, see sim_mx25r_init() for the defaults */
+typedef struct
+{
+	uint32_t sclk_hz;                /*!< OctoSPI clock in high performance mode */
+	uint32_t lp_sclk_hz;             /*!< OctoSPI clock limit in low power mode */
+	uint32_t cpu_hz;                 /*!< core clock, scale of the cycle counter */
+	uint32_t byte_program_us;        /*!< tBP, program of a single byte */
+	uint32_t page_program_us;        /*!< tPP, program of a whole page */
+	uint32_t sector_erase_us;        /*!< tSE, 4 KB */
+	uint32_t subblock_erase_us;      /*!< tBE32, 32 KB */
+	uint32_t block_erase_us;         /*!< tBE, 64 KB */
+	uint32_t chip_erase_us;          /*!< tCE */
+	uint32_t write_status_us;        /*!< tW */
+	uint32_t suspend_latency_us;     /*!< tESL / tPSL */
+	uint32_t reset_recovery_us;      /*!< tREADY2 */
+	uint32_t wake_up_us;             /*!< tRDP, deep power down release */
+} SIM_MX25R_TimingTypeDef;
+
+/* Counters of a simulated memory. The *_errors counters report what the real memory
+ * would have ignored or got wrong, a correct driver leaves them at 0.
+ */
+typedef struct
+{
+	uint32_t commands;
+	uint32_t reads;
+	uint64_t read_bytes;
+	uint32_t programs;
+	uint64_t program_bytes;
+	uint32_t erases;
+	uint32_t suspends;
+	uint32_t resumes;
+	uint64_t bus_ns;                 /*!< time the bus was driven */
+	uint64_t busy_ns;                /*!< time spent programming and erasing */
+	uint32_t program_bit_errors;     /*!< bytes programmed with a 0 to 1 transition */
+	uint32_t sequence_errors;        /*!< commands ignored: no WEL, busy, QE clear, bad format */
+	uint32_t busy_read_errors;       /*!< array reads while busy or from the suspended range */
+} SIM_MX25R_StatsTypeDef;
+
+/* Phases of a transaction, as sent by the OctoSPI */
+typedef struct
+{
+	uint32_t instruction;
+	uint32_t instruction_lines;      /*!< 0 when the instruction phase is skipped */
+	uint32_t address;
+	uint32_t address_lines;
+	uint32_t address_bytes;
+	uint32_t alternate;
+	uint32_t alternate_lines;
+	uint32_t alternate_bytes;
+	uint32_t dummy_cycles;
+	uint32_t data_lines;
+} SIM_MX25R_CmdTypeDef;
+
+/* contents of the simulated memories, also the memory-mapped windows */
+extern uint8_t sim_mx25r_memory[SIM_MX25R_INSTANCE_COUNT][MX25R6435F_FLASH_SIZE];
+
+void     sim_mx25r_init(const SIM_MX25R_TimingTypeDef *timing);
+int      sim_mx25r_load(uint32_t instance, const char *path);
+int      sim_mx25r_save(uint32_t instance, const char *path);
+void     sim_mx25r_get_stats(uint32_t instance, SIM_MX25R_StatsTypeDef *stats);
+void     sim_mx25r_reset_stats(uint32_t instance);
+
+/* simulated clock */
+uint64_t sim_mx25r_now_ns(void);
+void     sim_mx25r_wait_until_ns(uint64_t time);
+uint32_t sim_mx25r_cycles(void);
+
+/* transaction level interface, used by the HAL OSPI simulation */
+void     sim_mx25r_select(uint32_t instance, const SIM_MX25R_CmdTypeDef *cmd);
+void     sim_mx25r_transfer(uint32_t instance, uint8_t *data, uint32_t size, uint32_t write);
+void     sim_mx25r_deselect(uint32_t instance);
+uint64_t sim_mx25r_next_event_ns(uint32_t instance);
+void     sim_mx25r_memory_mapped(uint32_t instance, const SIM_MX25R_CmdTypeDef *read_cmd, uint32_t sioo);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_MX25R6435F_H */
@@ -0,0 +1,389 @@
+/**
+  ******************************************************************************
+  * @file    stm32l4xx_hal.h
+  * @brief   Host replacement of the STM32L4xx HAL header for the simulator build.
+  ******************************************************************************
+  * Declares the subset of the HAL used by the OSPI LevelX glue, the MX25R6435F
+  * BSP driver and the FileX application, with the register values of the
+  * STM32L4+ reference manual. The OSPI functions are implemented on top of the
+  * memory model by stm32l4xx_hal_ospi_sim.c.
+  ******************************************************************************
+  */
+
+#ifndef STM32L4xx_HAL_H
+#define STM32L4xx_HAL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include "sim_mx25r6435f.h"
+
+#if (UINTPTR_MAX != 0xFFFFFFFFU)
+#error "The simulator is built for a 32-bit host (-m32): the glue and LevelX keep flash and buffer addresses in 32-bit integers"
+#endif
+
+/* Host configuration of the OSPI LevelX glue ---------------------------------*/
+/* the OctoSPI registers are not simulated, commands go through HAL_OSPI_Command */
+#define LX_STM32_OSPI_DIRECT_CMD                 0
+/* same for the BSP driver */
+#define MX25R6435F_DIRECT_CMD                    0
+
+/* the cycle counter follows the simulated clock */
+#define LX_STM32_OSPI_CYCLE_COUNTER_INIT()       do { } while(0)
+#define LX_STM32_OSPI_CYCLE_COUNT()              sim_mx25r_cycles()
+#define LX_STM32_OSPI_LOG2(__x__)                (31U - (uint32_t)__builtin_clz(__x__))
+
+/* Common definitions ---------------------------------------------------------*/
+#define __IO    volatile
+#define UNUSED(X) (void)X
+
+typedef enum
+{
+	HAL_OK       = 0x00U,
+	HAL_ERROR    = 0x01U,
+	HAL_BUSY     = 0x02U,
+	HAL_TIMEOUT  = 0x03U
+} HAL_StatusTypeDef;
+
+typedef enum
+{
+	HAL_UNLOCKED = 0x00U,
+	HAL_LOCKED   = 0x01U
+} HAL_LockTypeDef;
+
+typedef int32_t IRQn_Type;
+
+#define SET_BIT(REG, BIT)                        ((REG) |= (BIT))
+#define CLEAR_BIT(REG, BIT)                      ((REG) &= ~(BIT))
+#define READ_BIT(REG, BIT)                       ((REG) & (BIT))
+#define MODIFY_REG(REG, CLEARMASK, SETMASK)      ((REG) = (((REG) & (~(CLEARMASK))) | (SETMASK)))
+
+#define __HAL_LINKDMA(__HANDLE__, __PPP_DMA_FIELD__, __DMA_HANDLE__) \
+	do { \
+		(__HANDLE__)->__PPP_DMA_FIELD__ = &(__DMA_HANDLE__); \
+		(__DMA_HANDLE__).Parent = (__HANDLE__); \
+	} while(0)
+
+#define __HAL_RCC_DMA1_CLK_ENABLE()              do { } while(0)
+#define __HAL_RCC_DMAMUX1_CLK_ENABLE()           do { } while(0)
+
+extern uint32_t SystemCoreClock;
+
+/* OCTOSPI registers, only kept for the type of the handle instance ---------*/
+typedef struct
+{
+	__IO uint32_t CR;
+	__IO uint32_t DCR1;
+	__IO uint32_t DCR2;
+	__IO uint32_t DCR3;
+	__IO uint32_t DCR4;
+	__IO uint32_t SR;
+	__IO uint32_t FCR;
+	__IO uint32_t DLR;
+	__IO uint32_t AR;
+	__IO uint32_t DR;
+	__IO uint32_t PSMKR;
+	__IO uint32_t PSMAR;
+	__IO uint32_t PIR;
+	__IO uint32_t CCR;
+	__IO uint32_t TCR;
+	__IO uint32_t IR;
+	__IO uint32_t ABR;
+	__IO uint32_t LPTR;
+} OCTOSPI_TypeDef;
+
+extern OCTOSPI_TypeDef sim_octospi_regs[SIM_MX25R_INSTANCE_COUNT];
+
+#define OCTOSPI1                                 (&sim_octospi_regs[0])
+#define OCTOSPI2                                 (&sim_octospi_regs[1])
+
+/* the memory-mapped windows are the simulated memories */
+#define OCTOSPI1_BASE                            ((uint32_t)&sim_mx25r_memory[0][0])
+#define OCTOSPI2_BASE                            ((uint32_t)&sim_mx25r_memory[1][0])
+
+#define OCTOSPI_CR_FMODE                         (0x3UL << 28)
+#define OCTOSPI_CR_PMM                           (0x1UL << 23)
+#define OCTOSPI_CR_APMS                          (0x1UL << 22)
+#define OCTOSPI_SR_TCF                           (0x1UL << 1)
+#define OCTOSPI_SR_BUSY                          (0x1UL << 5)
+#define OCTOSPI_FCR_CTCF                         (0x1UL << 1)
+#define OCTOSPI_TCR_DCYC                         (0x1FUL << 0)
+#define OCTOSPI_CCR_IMODE                        (0x7UL << 0)
+#define OCTOSPI_CCR_IDTR                         (0x1UL << 3)
+#define OCTOSPI_CCR_ISIZE                        (0x3UL << 4)
+#define OCTOSPI_CCR_ADMODE                       (0x7UL << 8)
+#define OCTOSPI_CCR_ADDTR                        (0x1UL << 11)
+#define OCTOSPI_CCR_ADSIZE                       (0x3UL << 12)
+#define OCTOSPI_CCR_ABMODE                       (0x7UL << 16)
+#define OCTOSPI_CCR_ABDTR                        (0x1UL << 19)
+#define OCTOSPI_CCR_ABSIZE                       (0x3UL << 20)
+#define OCTOSPI_CCR_DMODE                        (0x7UL << 24)
+#define OCTOSPI_CCR_DDTR                         (0x1UL << 27)
+#define OCTOSPI_CCR_DQSE                         (0x1UL << 29)
+#define OCTOSPI_CCR_SIOO                         (0x1UL << 31)
+
+/* DMA ---------------------------------------------------------------------*/
+typedef struct
+{
+	__IO uint32_t CCR;
+	__IO uint32_t CNDTR;
+	__IO uint32_t CPAR;
+	__IO uint32_t CMAR;
+} DMA_Channel_TypeDef;
+
+typedef struct
+{
+	uint32_t Request;
+	uint32_t Direction;
+	uint32_t PeriphInc;
+	uint32_t MemInc;
+	uint32_t PeriphDataAlignment;
+	uint32_t MemDataAlignment;
+	uint32_t Mode;
+	uint32_t Priority;
+} DMA_InitTypeDef;
+
+typedef struct __DMA_HandleTypeDef
+{
+	DMA_Channel_TypeDef *Instance;
+	DMA_InitTypeDef      Init;
+	void                *Parent;
+} DMA_HandleTypeDef;
+
+extern DMA_Channel_TypeDef sim_dma_channels[2];
+
+#define DMA1_Channel1                            (&sim_dma_channels[0])
+#define DMA1_Channel2                            (&sim_dma_channels[1])
+#define DMA1_Channel1_IRQn                       ((IRQn_Type)11)
+#define DMA1_Channel2_IRQn                       ((IRQn_Type)12)
+
+#define DMA_REQUEST_OCTOSPI1                     40U
+#define DMA_REQUEST_OCTOSPI2                     41U
+#define DMA_PERIPH_TO_MEMORY                     0x00000000U
+#define DMA_MEMORY_TO_PERIPH                     0x00000010U
+#define DMA_PINC_DISABLE                         0x00000000U
+#define DMA_MINC_ENABLE                          0x00000080U
+#define DMA_PDATAALIGN_WORD                      0x00000200U
+#define DMA_MDATAALIGN_WORD                      0x00000800U
+#define DMA_NORMAL                               0x00000000U
+#define DMA_PRIORITY_HIGH                        0x00002000U
+
+HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef *hdma);
+HAL_StatusTypeDef HAL_DMA_DeInit(DMA_HandleTypeDef *hdma);
+void HAL_DMA_IRQHandler(DMA_HandleTypeDef *hdma);
+
+/* OSPI --------------------------------------------------------------------*/
+typedef struct
+{
+	uint32_t FifoThreshold;
+	uint32_t DualQuad;
+	uint32_t MemoryType;
+	uint32_t DeviceSize;
+	uint32_t ChipSelectHighTime;
+	uint32_t FreeRunningClock;
+	uint32_t ClockMode;
+	uint32_t ClockPrescaler;
+	uint32_t SampleShifting;
+	uint32_t DelayHoldQuarterCycle;
+	uint32_t ChipSelectBoundary;
+	uint32_t DelayBlockBypass;
+} OSPI_InitTypeDef;
+
+typedef struct __OSPI_HandleTypeDef
+{
+	OCTOSPI_TypeDef   *Instance;
+	OSPI_InitTypeDef   Init;
+	uint8_t           *pBuffPtr;
+	__IO uint32_t      XferSize;
+	__IO uint32_t      XferCount;
+	DMA_HandleTypeDef *hdma;
+	__IO uint32_t      State;
+	__IO uint32_t      ErrorCode;
+	uint32_t           Timeout;
+} OSPI_HandleTypeDef;
+
+typedef struct
+{
+	uint32_t OperationType;
+	uint32_t FlashId;
+	uint32_t Instruction;
+	uint32_t InstructionMode;
+	uint32_t InstructionSize;
+	uint32_t InstructionDtrMode;
+	uint32_t Address;
+	uint32_t AddressMode;
+	uint32_t AddressSize;
+	uint32_t AddressDtrMode;
+	uint32_t AlternateBytes;
+	uint32_t AlternateBytesMode;
+	uint32_t AlternateBytesSize;
+	uint32_t AlternateBytesDtrMode;
+	uint32_t DataMode;
+	uint32_t NbData;
+	uint32_t DataDtrMode;
+	uint32_t DummyCycles;
+	uint32_t DQSMode;
+	uint32_t SIOOMode;
+} OSPI_RegularCmdTypeDef;
+
+typedef struct
+{
+	uint32_t Match;
+	uint32_t Mask;
+	uint32_t MatchMode;
+	uint32_t AutomaticStop;
+	uint32_t Interval;
+} OSPI_AutoPollingTypeDef;
+
+typedef struct
+{
+	uint32_t TimeOutActivation;
+	uint32_t TimeOutPeriod;
+} OSPI_MemoryMappedTypeDef;
+
+#define HAL_OSPI_ERROR_NONE                      0x00000000U
+#define HAL_OSPI_ERROR_TIMEOUT                   0x00000001U
+#define HAL_OSPI_ERROR_TRANSFER                  0x00000002U
+#define HAL_OSPI_ERROR_DMA                       0x00000004U
+#define HAL_OSPI_ERROR_INVALID_PARAM             0x00000008U
+#define HAL_OSPI_ERROR_INVALID_SEQUENCE          0x00000010U
+
+#define HAL_OSPI_STATE_RESET                     0x00000000U
+#define HAL_OSPI_STATE_READY                     0x00000002U
+#define HAL_OSPI_STATE_CMD_CFG                   0x00000004U
+#define HAL_OSPI_STATE_READ_CMD_CFG              0x00000014U
+#define HAL_OSPI_STATE_WRITE_CMD_CFG             0x00000024U
+#define HAL_OSPI_STATE_BUSY_CMD                  0x00000008U
+#define HAL_OSPI_STATE_BUSY_TX                   0x00000018U
+#define HAL_OSPI_STATE_BUSY_RX                   0x00000028U
+#define HAL_OSPI_STATE_BUSY_AUTO_POLLING         0x00000048U
+#define HAL_OSPI_STATE_BUSY_MEM_MAPPED           0x00000088U
+#define HAL_OSPI_STATE_ABORT                     0x00000100U
+#define HAL_OSPI_STATE_ERROR                     0x00000200U
+
+#define HAL_OSPI_TIMEOUT_DEFAULT_VALUE           5000U
+
+#define HAL_OSPI_OPTYPE_COMMON_CFG               0x00000000U
+#define HAL_OSPI_OPTYPE_READ_CFG                 0x00000001U
+#define HAL_OSPI_OPTYPE_WRITE_CFG                0x00000002U
+#define HAL_OSPI_OPTYPE_WRAP_CFG                 0x00000003U
+
+#define HAL_OSPI_FLASH_ID_1                      0x00000000U
+#define HAL_OSPI_FLASH_ID_2                      0x80000000U
+
+#define HAL_OSPI_INSTRUCTION_NONE                0x00000000U
+#define HAL_OSPI_INSTRUCTION_1_LINE              (0x1UL << 0)
+#define HAL_OSPI_INSTRUCTION_2_LINES             (0x2UL << 0)
+#define HAL_OSPI_INSTRUCTION_4_LINES             (0x3UL << 0)
+#define HAL_OSPI_INSTRUCTION_8_LINES             (0x4UL << 0)
+#define HAL_OSPI_INSTRUCTION_8_BITS              0x00000000U
+#define HAL_OSPI_INSTRUCTION_16_BITS             (0x1UL << 4)
+#define HAL_OSPI_INSTRUCTION_DTR_DISABLE         0x00000000U
+#define HAL_OSPI_INSTRUCTION_DTR_ENABLE          OCTOSPI_CCR_IDTR
+
+#define HAL_OSPI_ADDRESS_NONE                    0x00000000U
+#define HAL_OSPI_ADDRESS_1_LINE                  (0x1UL << 8)
+#define HAL_OSPI_ADDRESS_2_LINES                 (0x2UL << 8)
+#define HAL_OSPI_ADDRESS_4_LINES                 (0x3UL << 8)
+#define HAL_OSPI_ADDRESS_8_LINES                 (0x4UL << 8)
+#define HAL_OSPI_ADDRESS_8_BITS                  0x00000000U
+#define HAL_OSPI_ADDRESS_16_BITS                 (0x1UL << 12)
+#define HAL_OSPI_ADDRESS_24_BITS                 (0x2UL << 12)
+#define HAL_OSPI_ADDRESS_32_BITS                 (0x3UL << 12)
+#define HAL_OSPI_ADDRESS_DTR_DISABLE             0x00000000U
+#define HAL_OSPI_ADDRESS_DTR_ENABLE              OCTOSPI_CCR_ADDTR
+
+#define HAL_OSPI_ALTERNATE_BYTES_NONE            0x00000000U
+#define HAL_OSPI_ALTERNATE_BYTES_1_LINE          (0x1UL << 16)
+#define HAL_OSPI_ALTERNATE_BYTES_2_LINES         (0x2UL << 16)
+#define HAL_OSPI_ALTERNATE_BYTES_4_LINES         (0x3UL << 16)
+#define HAL_OSPI_ALTERNATE_BYTES_8_LINES         (0x4UL << 16)
+#define HAL_OSPI_ALTERNATE_BYTES_8_BITS          0x00000000U
+#define HAL_OSPI_ALTERNATE_BYTES_16_BITS         (0x1UL << 20)
+#define HAL_OSPI_ALTERNATE_BYTES_24_BITS         (0x2UL << 20)
+#define HAL_OSPI_ALTERNATE_BYTES_32_BITS         (0x3UL << 20)
+#define HAL_OSPI_ALTERNATE_BYTES_DTR_DISABLE     0x00000000U
+#define HAL_OSPI_ALTERNATE_BYTES_DTR_ENABLE      OCTOSPI_CCR_ABDTR
+
+#define HAL_OSPI_DATA_NONE                       0x00000000U
+#define HAL_OSPI_DATA_1_LINE                     (0x1UL << 24)
+#define HAL_OSPI_DATA_2_LINES                    (0x2UL << 24)
+#define HAL_OSPI_DATA_4_LINES                    (0x3UL << 24)
+#define HAL_OSPI_DATA_8_LINES                    (0x4UL << 24)
+#define HAL_OSPI_DATA_DTR_DISABLE                0x00000000U
+#define HAL_OSPI_DATA_DTR_ENABLE                 OCTOSPI_CCR_DDTR
+
+#define HAL_OSPI_DQS_DISABLE                     0x00000000U
+#define HAL_OSPI_DQS_ENABLE                      OCTOSPI_CCR_DQSE
+
+#define HAL_OSPI_SIOO_INST_EVERY_CMD             0x00000000U
+#define HAL_OSPI_SIOO_INST_ONLY_FIRST_CMD        OCTOSPI_CCR_SIOO
+
+#define HAL_OSPI_MATCH_MODE_AND                  0x00000000U
+#define HAL_OSPI_MATCH_MODE_OR                   OCTOSPI_CR_PMM
+
+#define HAL_OSPI_AUTOMATIC_STOP_DISABLE          0x00000000U
+#define HAL_OSPI_AUTOMATIC_STOP_ENABLE           OCTOSPI_CR_APMS
+
+#define HAL_OSPI_TIMEOUT_COUNTER_DISABLE         0x00000000U
+#define HAL_OSPI_TIMEOUT_COUNTER_ENABLE          0x00000008U
+
+HAL_StatusTypeDef HAL_OSPI_Init(OSPI_HandleTypeDef *hospi);
+HAL_StatusTypeDef HAL_OSPI_DeInit(OSPI_HandleTypeDef *hospi);
+HAL_StatusTypeDef HAL_OSPI_Command(OSPI_HandleTypeDef *hospi, OSPI_RegularCmdTypeDef *cmd, uint32_t Timeout);
+HAL_StatusTypeDef HAL_OSPI_Command_IT(OSPI_HandleTypeDef *hospi, OSPI_RegularCmdTypeDef *cmd);
+HAL_StatusTypeDef HAL_OSPI_Transmit(OSPI_HandleTypeDef *hospi, uint8_t *pData, uint32_t Timeout);
+HAL_StatusTypeDef HAL_OSPI_Receive(OSPI_HandleTypeDef *hospi, uint8_t *pData, uint32_t Timeout);
+HAL_StatusTypeDef HAL_OSPI_Transmit_IT(OSPI_HandleTypeDef *hospi, uint8_t *pData);
+HAL_StatusTypeDef HAL_OSPI_Receive_IT(OSPI_HandleTypeDef *hospi, uint8_t *pData);
+HAL_StatusTypeDef HAL_OSPI_Transmit_DMA(OSPI_HandleTypeDef *hospi, uint8_t *pData);
+HAL_StatusTypeDef HAL_OSPI_Receive_DMA(OSPI_HandleTypeDef *hospi, uint8_t *pData);
+HAL_StatusTypeDef HAL_OSPI_AutoPolling(OSPI_HandleTypeDef *hospi, OSPI_AutoPollingTypeDef *cfg, uint32_t Timeout);
+HAL_StatusTypeDef HAL_OSPI_AutoPolling_IT(OSPI_HandleTypeDef *hospi, OSPI_AutoPollingTypeDef *cfg);
+HAL_StatusTypeDef HAL_OSPI_MemoryMapped(OSPI_HandleTypeDef *hospi, OSPI_MemoryMappedTypeDef *cfg);
+HAL_StatusTypeDef HAL_OSPI_Abort(OSPI_HandleTypeDef *hospi);
+uint32_t HAL_OSPI_GetState(OSPI_HandleTypeDef *hospi);
+uint32_t HAL_OSPI_GetError(OSPI_HandleTypeDef *hospi);
+void HAL_OSPI_IRQHandler(OSPI_HandleTypeDef *hospi);
+
+void HAL_OSPI_CmdCpltCallback(OSPI_HandleTypeDef *hospi);
+void HAL_OSPI_RxCpltCallback(OSPI_HandleTypeDef *hospi);
+void HAL_OSPI_TxCpltCallback(OSPI_HandleTypeDef *hospi);
+void HAL_OSPI_StatusMatchCallback(OSPI_HandleTypeDef *hospi);
+void HAL_OSPI_ErrorCallback(OSPI_HandleTypeDef *hospi);
+
+/* GPIO, used by the application LED ---------------------------------------*/
+typedef struct
+{
+	__IO uint32_t ODR;
+} GPIO_TypeDef;
+
+typedef enum
+{
+	GPIO_PIN_RESET = 0U,
+	GPIO_PIN_SET
+} GPIO_PinState;
+
+extern GPIO_TypeDef sim_gpiob;
+
+#define GPIOB                                    (&sim_gpiob)
+#define GPIO_PIN_14                              ((uint16_t)0x4000)
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState);
+void HAL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin);
+
+/* Cortex and time base ----------------------------------------------------*/
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority);
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn);
+void HAL_NVIC_DisableIRQ(IRQn_Type IRQn);
+uint32_t HAL_GetTick(void);
+void HAL_Delay(uint32_t Delay);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STM32L4xx_HAL_H */
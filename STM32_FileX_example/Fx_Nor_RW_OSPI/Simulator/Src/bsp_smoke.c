@@ -0,0 +1,186 @@
+/**
+  ******************************************************************************
+  * @file    bsp_smoke.c
+  * @brief   Host smoke test of the MX25R6435F BSP driver on the simulator.
+  ******************************************************************************
+  * Runs the BSP of OSPI_ReadWrite on the simulated memory, without ThreadX:
+  * init (twice, the second one must not write the configuration again), sector
+  * erase polled through GetStatus, erase suspend and resume, a write across a
+  * page boundary read back in indirect and in memory-mapped mode, block erase
+  * and deep power down. Any error of the memory fails the test.
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "main.h"
+#include "mx25r6435f_driver.h"
+#include "sim_mx25r6435f.h"
+
+#define BSP_SMOKE_SECTOR             3
+#define BSP_SMOKE_DATA_SIZE          600
+/* starts 16 bytes before a page boundary so the write is split */
+#define BSP_SMOKE_DATA_ADDR          ((BSP_SMOKE_SECTOR * MX25R6435F_SECTOR_SIZE) + MX25R6435F_PAGE_SIZE - 16)
+#define BSP_SMOKE_BLOCK_ADDR         (2 * MX25R6435F_BLOCK_SIZE)
+
+extern OSPI_HandleTypeDef hospi1;
+
+static uint8_t bsp_smoke_data[BSP_SMOKE_DATA_SIZE];
+static uint8_t bsp_smoke_buffer[BSP_SMOKE_DATA_SIZE];
+static uint32_t bsp_smoke_failures;
+
+static void bsp_smoke_check(const char *step, int passed);
+static uint8_t bsp_smoke_wait_ready(void);
+static int bsp_smoke_is_erased(const uint8_t *data, uint32_t size);
+static uint32_t bsp_smoke_print_stats(void);
+
+/**
+  * @brief  Error handler of the HAL, the smoke test stops.
+  * @retval None
+  */
+void Error_Handler(void)
+{
+	printf("Error_Handler called\n");
+	exit(1);
+}
+
+int main(void)
+{
+	SIM_MX25R_StatsTypeDef stats;
+	uint32_t i;
+
+	sim_mx25r_init(NULL);
+
+	/* Done by MX_OCTOSPI1_Init on the board */
+	hospi1.Instance = OCTOSPI1;
+	if (HAL_OSPI_Init(&hospi1) != HAL_OK)
+	{
+		return 1;
+	}
+
+	for (i = 0; i < BSP_SMOKE_DATA_SIZE; i++)
+	{
+		bsp_smoke_data[i] = (uint8_t)(i * 7);
+	}
+
+	/* First init configures quad and high performance modes, the second finds them set */
+	bsp_smoke_check("init", BSP_OSPI_Init(&hospi1) == OSPI_OK);
+	sim_mx25r_reset_stats(0);
+	bsp_smoke_check("init again", BSP_OSPI_Init(&hospi1) == OSPI_OK);
+	sim_mx25r_get_stats(0, &stats);
+	printf("Second init: %lu commands, memory busy %llu us\n", (unsigned long)stats.commands,
+	       (unsigned long long)(stats.busy_ns / 1000));
+
+	/* Sector erase does not wait for the memory */
+	bsp_smoke_check("sector erase", BSP_OSPI_Erase_Sector(&hospi1, BSP_SMOKE_SECTOR) == OSPI_OK);
+	bsp_smoke_check("busy after sector erase", BSP_OSPI_GetStatus(&hospi1) == OSPI_BUSY);
+	bsp_smoke_check("erase suspend", BSP_OSPI_SuspendErase(&hospi1) == OSPI_OK);
+	bsp_smoke_check("suspended", BSP_OSPI_GetStatus(&hospi1) == OSPI_SUSPENDED);
+	/* The suspended sector may not be read, any other may */
+	bsp_smoke_check("read while suspended", BSP_OSPI_Read(&hospi1, bsp_smoke_buffer, 0, 16) == OSPI_OK);
+	bsp_smoke_check("erase resume", BSP_OSPI_ResumeErase(&hospi1) == OSPI_OK);
+	bsp_smoke_check("sector erase done", bsp_smoke_wait_ready() == OSPI_OK);
+
+	bsp_smoke_check("write", BSP_OSPI_Write(&hospi1, bsp_smoke_data, BSP_SMOKE_DATA_ADDR, BSP_SMOKE_DATA_SIZE) == OSPI_OK);
+	memset(bsp_smoke_buffer, 0, sizeof(bsp_smoke_buffer));
+	bsp_smoke_check("read", BSP_OSPI_Read(&hospi1, bsp_smoke_buffer, BSP_SMOKE_DATA_ADDR, BSP_SMOKE_DATA_SIZE) == OSPI_OK);
+	bsp_smoke_check("read back", memcmp(bsp_smoke_buffer, bsp_smoke_data, BSP_SMOKE_DATA_SIZE) == 0);
+
+	/* Block erase waits for the end of the erase */
+	bsp_smoke_check("block erase", BSP_OSPI_Erase_Block(&hospi1, BSP_SMOKE_BLOCK_ADDR) == OSPI_OK);
+	bsp_smoke_check("ready after block erase", BSP_OSPI_GetStatus(&hospi1) == OSPI_OK);
+	bsp_smoke_check("read erased block", BSP_OSPI_Read(&hospi1, bsp_smoke_buffer, BSP_SMOKE_BLOCK_ADDR, BSP_SMOKE_DATA_SIZE) == OSPI_OK);
+	bsp_smoke_check("block erased", bsp_smoke_is_erased(bsp_smoke_buffer, BSP_SMOKE_DATA_SIZE));
+
+	bsp_smoke_check("memory-mapped mode", BSP_OSPI_EnableMemoryMappedMode(&hospi1) == OSPI_OK);
+	bsp_smoke_check("memory-mapped read back",
+	                memcmp((const uint8_t *)(OCTOSPI1_BASE + BSP_SMOKE_DATA_ADDR), bsp_smoke_data, BSP_SMOKE_DATA_SIZE) == 0);
+	bsp_smoke_check("leave memory-mapped mode", HAL_OSPI_Abort(&hospi1) == HAL_OK);
+
+	bsp_smoke_check("enter deep power down", BSP_OSPI_EnterDeepPowerDown(&hospi1) == OSPI_OK);
+	bsp_smoke_check("leave deep power down", BSP_OSPI_LeaveDeepPowerDown(&hospi1) == OSPI_OK);
+	/* tRDP, the BSP leaves it to the caller */
+	HAL_Delay(1);
+	bsp_smoke_check("ready after deep power down", BSP_OSPI_GetStatus(&hospi1) == OSPI_OK);
+
+	bsp_smoke_check("deinit", BSP_OSPI_DeInit(&hospi1) == OSPI_OK);
+
+	/* The memory counts what it would have ignored or got wrong */
+	bsp_smoke_check("memory errors", bsp_smoke_print_stats() == 0);
+
+	printf("BSP smoke test %s\n", (bsp_smoke_failures == 0) ? "passed" : "FAILED");
+	return (bsp_smoke_failures == 0) ? 0 : 1;
+}
+
+/**
+  * @brief  Report a failed step.
+  * @param  step: name of the step
+  * @param  passed: result of the step
+  * @retval None
+  */
+static void bsp_smoke_check(const char *step, int passed)
+{
+	if (!passed)
+	{
+		printf("FAILED: %s\n", step);
+		bsp_smoke_failures++;
+	}
+}
+
+/**
+  * @brief  Poll the memory until the ongoing program or erase ends.
+  * @retval OSPI memory status
+  */
+static uint8_t bsp_smoke_wait_ready(void)
+{
+	uint8_t status;
+
+	do
+	{
+		status = BSP_OSPI_GetStatus(&hospi1);
+	} while (status == OSPI_BUSY);
+
+	return status;
+}
+
+/**
+  * @brief  Check that a buffer only holds erased bytes.
+  * @param  data: buffer to check
+  * @param  size: size of the buffer
+  * @retval 1 when erased, 0 otherwise
+  */
+static int bsp_smoke_is_erased(const uint8_t *data, uint32_t size)
+{
+	uint32_t i;
+
+	for (i = 0; i < size; i++)
+	{
+		if (data[i] != 0xFF)
+		{
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+/**
+  * @brief  Print the counters of the simulated memory.
+  * @retval number of errors seen by the memory
+  */
+static uint32_t bsp_smoke_print_stats(void)
+{
+	SIM_MX25R_StatsTypeDef stats;
+
+	sim_mx25r_get_stats(0, &stats);
+
+	printf("Simulated time: %lu us\n", (unsigned long)(sim_mx25r_now_ns() / 1000));
+	printf("Memory since the second init: %lu commands, %lu programs, %lu erases, %lu suspends, %lu resumes\n",
+	       (unsigned long)stats.commands, (unsigned long)stats.programs, (unsigned long)stats.erases,
+	       (unsigned long)stats.suspends, (unsigned long)stats.resumes);
+	printf("Errors: %lu program bit, %lu sequence, %lu busy read\n",
+	       (unsigned long)stats.program_bit_errors, (unsigned long)stats.sequence_errors, (unsigned long)stats.busy_read_errors);
+
+	return stats.program_bit_errors + stats.sequence_errors + stats.busy_read_errors;
+}
@@ -0,0 +1,167 @@
+/**
+  ******************************************************************************
+  * @file    sim_bench.c
+  * @brief   Host entry point of the FileX application on the MX25R6435F simulator.
+  ******************************************************************************
+  * Runs MX_FileX_Init and the application thread of app_filex.c as on the board,
+  * the benchmarks included when built with FX_APP_BENCHMARK 1. The application
+  * ends by closing the media and blinking LED2: the monitor thread then prints
+  * the counters of the simulated memories and exits. The memory starts erased,
+  * or from the image given as first argument, which is then saved back on exit.
+  * The benchmark figures are in simulated time, from the datasheet timings of
+  * the memory model, not measurements of the board.
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "main.h"
+#include "tx_api.h"
+#include "app_filex.h"
+#include "sim_mx25r6435f.h"
+
+/* thread stacks of app_filex.c, allocated by MX_FileX_Init */
+#define SIM_BENCH_POOL_SIZE          (32 * 1024)
+#define SIM_BENCH_STACK_SIZE         (4 * 1024)
+/* below all the application threads */
+#define SIM_BENCH_MONITOR_PRIO       30
+#define SIM_BENCH_MONITOR_PERIOD     10
+
+#if (LX_STM32_OSPI_STRIPE == 1)
+#define SIM_BENCH_MEMORIES           2
+#else
+#define SIM_BENCH_MEMORIES           1
+#endif
+
+static TX_BYTE_POOL sim_bench_pool;
+static ULONG        sim_bench_pool_memory[SIM_BENCH_POOL_SIZE / sizeof(ULONG)];
+static TX_THREAD    sim_bench_monitor_thread;
+static ULONG        sim_bench_monitor_stack[SIM_BENCH_STACK_SIZE / sizeof(ULONG)];
+static const char  *sim_bench_image;
+
+static void sim_bench_monitor_entry(ULONG thread_input);
+static uint32_t sim_bench_print_stats(void);
+
+/**
+  * @brief  Error handler of the application and of the drivers, the benchmark stops.
+  * @retval None
+  */
+void Error_Handler(void)
+{
+	printf("Error_Handler called\n");
+	exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+	sim_mx25r_init(NULL);
+
+	if (argc > 1)
+	{
+		sim_bench_image = argv[1];
+		if (sim_mx25r_load(0, sim_bench_image) != 0)
+		{
+			printf("No image in %s, starting from an erased memory\n", sim_bench_image);
+		}
+	}
+
+	/* Done by MX_OCTOSPI1_Init on the board */
+	hospi1.Instance = OCTOSPI1;
+	if (HAL_OSPI_Init(&hospi1) != HAL_OK)
+	{
+		return 1;
+	}
+
+#if (LX_STM32_OSPI_STRIPE == 1)
+	hospi2.Instance = OCTOSPI2;
+	if (HAL_OSPI_Init(&hospi2) != HAL_OK)
+	{
+		return 1;
+	}
+#endif
+
+	tx_kernel_enter();
+
+	return 0;
+}
+
+void tx_application_define(void *first_unused_memory)
+{
+	UNUSED(first_unused_memory);
+
+	/* Done by MX_ThreadX_Init on the board */
+	if (tx_byte_pool_create(&sim_bench_pool, "sim bench pool", sim_bench_pool_memory, sizeof(sim_bench_pool_memory)) != TX_SUCCESS)
+	{
+		Error_Handler();
+	}
+
+	if (MX_FileX_Init(&sim_bench_pool) != FX_SUCCESS)
+	{
+		Error_Handler();
+	}
+
+	if (tx_thread_create(&sim_bench_monitor_thread, "sim bench monitor thread", sim_bench_monitor_entry, 0,
+	                     sim_bench_monitor_stack, sizeof(sim_bench_monitor_stack), SIM_BENCH_MONITOR_PRIO,
+	                     SIM_BENCH_MONITOR_PRIO, TX_NO_TIME_SLICE, TX_AUTO_START) != TX_SUCCESS)
+	{
+		Error_Handler();
+	}
+}
+
+/**
+  * @brief  Monitor thread: waits for the first LED2 toggle of the application, then reports and exits.
+  * @param  thread_input: unused
+  * @retval None
+  */
+static void sim_bench_monitor_entry(ULONG thread_input)
+{
+	uint32_t errors;
+
+	UNUSED(thread_input);
+
+	while ((LED2_GPIO_Port->ODR & LED2_Pin) == 0)
+	{
+		tx_thread_sleep(SIM_BENCH_MONITOR_PERIOD);
+	}
+
+	errors = sim_bench_print_stats();
+
+	if ((sim_bench_image != NULL) && (sim_mx25r_save(0, sim_bench_image) != 0))
+	{
+		printf("Image not saved to %s\n", sim_bench_image);
+	}
+
+	printf("Benchmark %s\n", (errors == 0) ? "done" : "FAILED");
+	exit((errors == 0) ? 0 : 1);
+}
+
+/**
+  * @brief  Print the counters of the simulated memories.
+  * @retval number of errors seen by the memories
+  */
+static uint32_t sim_bench_print_stats(void)
+{
+	SIM_MX25R_StatsTypeDef stats;
+	uint32_t errors = 0;
+	uint32_t i;
+
+	printf("Simulated time: %lu us\n", (unsigned long)(sim_mx25r_now_ns() / 1000));
+
+	for (i = 0; i < SIM_BENCH_MEMORIES; i++)
+	{
+		sim_mx25r_get_stats(i, &stats);
+
+		printf("Memory %lu: %lu commands, %lu reads (%llu bytes), %lu programs (%llu bytes), %lu erases, %lu suspends\n",
+		       (unsigned long)i, (unsigned long)stats.commands, (unsigned long)stats.reads, (unsigned long long)stats.read_bytes,
+		       (unsigned long)stats.programs, (unsigned long long)stats.program_bytes, (unsigned long)stats.erases,
+		       (unsigned long)stats.suspends);
+		printf("  Bus busy %llu us, memory busy %llu us\n",
+		       (unsigned long long)(stats.bus_ns / 1000), (unsigned long long)(stats.busy_ns / 1000));
+		printf("  Errors: %lu program bit, %lu sequence, %lu busy read\n",
+		       (unsigned long)stats.program_bit_errors, (unsigned long)stats.sequence_errors, (unsigned long)stats.busy_read_errors);
+
+		errors += stats.program_bit_errors + stats.sequence_errors + stats.busy_read_errors;
+	}
+
+	return errors;
+}
@@ -0,0 +1,1124 @@
+/**
+  ******************************************************************************
+  * @file    sim_mx25r6435f.c
+  * @brief   MX25R6435F NOR flash model for the host simulator build.
+  ******************************************************************************
+  * The model works at the transaction level: sim_mx25r_select() receives the
+  * instruction, address, alternate and dummy phases, sim_mx25r_transfer() the
+  * data phase and sim_mx25r_deselect() executes the command, as the memory does
+  * on the rising edge of CS#.
+  *
+  * NOR semantics: a program only clears bits, within a page (the address wraps
+  * at the page boundary), an erase sets a whole sector, 32 KB block, 64 KB block
+  * or the chip to 0xFF. Program, erase and status write require WEL and set WIP
+  * for their datasheet duration, the memory then only accepts the status reads,
+  * suspend and reset. Suspend, resume and the performance enhance mode of the
+  * quad I/O read are modelled.
+  ******************************************************************************
+  */
+
+#include "sim_mx25r6435f.h"
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+/* array operations */
+#define SIM_OP_NONE             0
+#define SIM_OP_PROGRAM          1
+#define SIM_OP_ERASE            2
+#define SIM_OP_WRITE_STATUS     3
+#define SIM_OP_RESET            4
+
+#define SIM_NO_EVENT            UINT64_MAX
+
+/* identification */
+#define SIM_MANUFACTURER_ID     0xC2
+#define SIM_MEMORY_TYPE         0x28
+#define SIM_MEMORY_DENSITY      0x17
+#define SIM_ELECTRONIC_ID       0x17
+
+/* 8 Kbit secured OTP area */
+#define SIM_OTP_SIZE            1024
+
+/* command format flags */
+#define SIM_FMT_QE              0x01    /* needs the QE bit */
+#define SIM_FMT_WEL             0x02    /* needs the WEL bit, cleared once executed */
+#define SIM_FMT_BUSY_OK         0x04    /* accepted while WIP is set */
+#define SIM_FMT_DATA_OPTIONAL   0x08    /* the data phase can be skipped */
+#define SIM_FMT_READ            0x10    /* array read */
+#define SIM_FMT_WRITE           0x20    /* the data phase is sent to the memory */
+
+/* expected phases of a command */
+typedef struct
+{
+	uint8_t opcode;
+	uint8_t address_lines;
+	uint8_t alternate_lines;
+	uint8_t dummy_cycles;
+	uint8_t data_lines;
+	uint8_t flags;
+} SIM_FormatTypeDef;
+
+typedef struct
+{
+	/* registers */
+	uint8_t  sr;
+	uint8_t  cr[2];
+	uint8_t  secr;
+	uint8_t  burst_length;
+	uint8_t  pending_regs[3];
+	uint32_t pending_regs_count;
+
+	/* modes */
+	uint32_t pe_mode;
+	uint32_t reset_enable;
+	uint32_t deep_power_down;
+	uint64_t wake_up_end;
+	uint32_t otp_mode;
+
+	/* transaction in progress */
+	const SIM_FormatTypeDef *format;
+	uint32_t selected;
+	uint32_t accepted;
+	uint8_t  opcode;
+	uint32_t address;
+	uint32_t data_lines;
+	uint32_t count;
+	uint8_t  page[MX25R6435F_PAGE_SIZE];
+	uint8_t  page_sent[MX25R6435F_PAGE_SIZE];
+
+	/* program, erase or status write in progress */
+	uint32_t op;
+	uint32_t op_address;
+	uint32_t op_size;
+	uint64_t op_start;
+	uint64_t op_end;
+	uint64_t op_remaining;
+	uint64_t op_suspend_at;
+	uint32_t suspended;
+
+	SIM_MX25R_StatsTypeDef stats;
+} SIM_DeviceTypeDef;
+
+uint8_t sim_mx25r_memory[SIM_MX25R_INSTANCE_COUNT][MX25R6435F_FLASH_SIZE];
+
+static uint8_t sim_otp[SIM_MX25R_INSTANCE_COUNT][SIM_OTP_SIZE];
+static SIM_DeviceTypeDef sim_dev[SIM_MX25R_INSTANCE_COUNT];
+static SIM_MX25R_TimingTypeDef sim_timing;
+static uint64_t sim_host_start_ns;
+static uint64_t sim_stall_ns;
+
+/* MX25R6435F datasheet typical values, high performance mode */
+static const SIM_MX25R_TimingTypeDef sim_default_timing =
+{
+	.sclk_hz            = 60000000,
+	.lp_sclk_hz         = 33000000,
+	.cpu_hz             = 120000000,
+	.byte_program_us    = 32,
+	.page_program_us    = 850,
+	.sector_erase_us    = 40000,
+	.subblock_erase_us  = 240000,
+	.block_erase_us     = 480000,
+	.chip_erase_us      = 50000000,
+	.write_status_us    = 10000,
+	.suspend_latency_us = 20,
+	.reset_recovery_us  = 40,
+	.wake_up_us         = 35,
+};
+
+static const SIM_FormatTypeDef sim_formats[] =
+{
+	/* opcode                             addr alt dummy data flags */
+	{ READ_CMD,                             1,  0,  0,   1, SIM_FMT_READ },
+	{ FAST_READ_CMD,                        1,  0,  8,   1, SIM_FMT_READ },
+	{ DUAL_OUT_READ_CMD,                    1,  0,  8,   2, SIM_FMT_READ },
+	{ DUAL_INOUT_READ_CMD,                  2,  0,  4,   2, SIM_FMT_READ },
+	{ QUAD_OUT_READ_CMD,                    1,  0,  8,   4, SIM_FMT_READ | SIM_FMT_QE },
+	{ QUAD_INOUT_READ_CMD,                  4,  4,  4,   4, SIM_FMT_READ | SIM_FMT_QE },
+	{ PAGE_PROG_CMD,                        1,  0,  0,   1, SIM_FMT_WEL | SIM_FMT_WRITE },
+	{ QUAD_PAGE_PROG_CMD,                   4,  0,  0,   4, SIM_FMT_WEL | SIM_FMT_QE | SIM_FMT_WRITE },
+	{ SECTOR_ERASE_CMD,                     1,  0,  0,   0, SIM_FMT_WEL },
+	{ SUBBLOCK_ERASE_CMD,                   1,  0,  0,   0, SIM_FMT_WEL },
+	{ BLOCK_ERASE_CMD,                      1,  0,  0,   0, SIM_FMT_WEL },
+	{ CHIP_ERASE_CMD,                       0,  0,  0,   0, SIM_FMT_WEL },
+	{ CHIP_ERASE_CMD_2,                     0,  0,  0,   0, SIM_FMT_WEL },
+	{ PROG_ERASE_RESUME_CMD,                0,  0,  0,   0, 0 },
+	{ PROG_ERASE_RESUME_CMD_2,              0,  0,  0,   0, 0 },
+	{ PROG_ERASE_SUSPEND_CMD,               0,  0,  0,   0, SIM_FMT_BUSY_OK },
+	{ PROG_ERASE_SUSPEND_CMD_2,             0,  0,  0,   0, SIM_FMT_BUSY_OK },
+	{ READ_ID_CMD,                          0,  0,  0,   1, 0 },
+	{ READ_ELECTRONIC_ID_CMD,               0,  0, 24,   1, SIM_FMT_DATA_OPTIONAL },
+	{ READ_ELEC_MANUFACTURER_DEVICE_ID_CMD, 1,  0,  0,   1, 0 },
+	{ READ_SERIAL_FLASH_DISCO_PARAM_CMD,    1,  0,  8,   1, 0 },
+	{ WRITE_ENABLE_CMD,                     0,  0,  0,   0, 0 },
+	{ WRITE_DISABLE_CMD,                    0,  0,  0,   0, 0 },
+	{ READ_STATUS_REG_CMD,                  0,  0,  0,   1, SIM_FMT_BUSY_OK },
+	{ READ_CFG_REG_CMD,                     0,  0,  0,   1, SIM_FMT_BUSY_OK },
+	{ WRITE_STATUS_CFG_REG_CMD,             0,  0,  0,   1, SIM_FMT_WEL | SIM_FMT_WRITE },
+	{ READ_SEC_REG_CMD,                     0,  0,  0,   1, SIM_FMT_BUSY_OK },
+	{ WRITE_SEC_REG_CMD,                    0,  0,  0,   0, SIM_FMT_WEL },
+	{ DEEP_POWER_DOWN_CMD,                  0,  0,  0,   0, 0 },
+	{ SET_BURST_LENGTH_CMD,                 0,  0,  0,   1, SIM_FMT_WRITE },
+	{ ENTER_SECURED_OTP_CMD,                0,  0,  0,   0, 0 },
+	{ EXIT_SECURED_OTP_CMD,                 0,  0,  0,   0, 0 },
+	{ NO_OPERATION_CMD,                     0,  0,  0,   0, SIM_FMT_BUSY_OK },
+	{ RESET_ENABLE_CMD,                     0,  0,  0,   0, SIM_FMT_BUSY_OK },
+	{ RESET_MEMORY_CMD,                     0,  0,  0,   0, SIM_FMT_BUSY_OK },
+	{ RELEASE_READ_ENHANCED_CMD,            0,  0,  0,   0, SIM_FMT_BUSY_OK },
+};
+
+static uint64_t sim_host_ns(void);
+static void sim_bus(SIM_DeviceTypeDef *dev, uint32_t clocks);
+static void sim_update(SIM_DeviceTypeDef *dev);
+static void sim_start_op(SIM_DeviceTypeDef *dev, uint32_t op, uint32_t address, uint32_t size, uint32_t duration_us);
+static void sim_complete_op(SIM_DeviceTypeDef *dev);
+static const SIM_FormatTypeDef *sim_find_format(uint8_t opcode);
+static uint32_t sim_check_format(const SIM_FormatTypeDef *format, const SIM_MX25R_CmdTypeDef *cmd);
+static uint8_t sim_sio0_bits(const SIM_MX25R_CmdTypeDef *cmd);
+static void sim_read_array(SIM_DeviceTypeDef *dev, uint8_t *memory, uint8_t *data, uint32_t size);
+static void sim_program(SIM_DeviceTypeDef *dev, uint8_t *memory);
+static void sim_erase(SIM_DeviceTypeDef *dev, uint8_t *memory, uint32_t size, uint32_t duration_us);
+static void sim_reset(SIM_DeviceTypeDef *dev);
+
+/**
+  * @brief  Initialize the simulated memories, erased, with the power-on register values.
+  * @param  timing: timings to simulate, NULL for the datasheet typical values
+  * @retval None
+  */
+void sim_mx25r_init(const SIM_MX25R_TimingTypeDef *timing)
+{
+	uint32_t i;
+
+	sim_timing = (timing != NULL) ? *timing : sim_default_timing;
+
+	memset(sim_mx25r_memory, 0xFF, sizeof(sim_mx25r_memory));
+	memset(sim_otp, 0xFF, sizeof(sim_otp));
+	memset(sim_dev, 0, sizeof(sim_dev));
+
+	for (i = 0; i < SIM_MX25R_INSTANCE_COUNT; i++)
+	{
+		sim_dev[i].op_suspend_at = SIM_NO_EVENT;
+	}
+
+	sim_host_start_ns = sim_host_ns();
+	sim_stall_ns = 0;
+}
+
+/**
+  * @brief  Load the content of a simulated memory from an image file.
+  * @param  instance: simulated memory
+  * @param  path: image file, MX25R6435F_FLASH_SIZE bytes
+  * @retval 0 on success -1 on failure.
+  */
+int sim_mx25r_load(uint32_t instance, const char *path)
+{
+	FILE *file = fopen(path, "rb");
+	size_t size;
+
+	if (file == NULL)
+	{
+		return -1;
+	}
+
+	size = fread(sim_mx25r_memory[instance], 1, MX25R6435F_FLASH_SIZE, file);
+	fclose(file);
+
+	return (size == MX25R6435F_FLASH_SIZE) ? 0 : -1;
+}
+
+/**
+  * @brief  Save the content of a simulated memory to an image file.
+  * @param  instance: simulated memory
+  * @param  path: image file
+  * @retval 0 on success -1 on failure.
+  */
+int sim_mx25r_save(uint32_t instance, const char *path)
+{
+	FILE *file = fopen(path, "wb");
+	size_t size;
+
+	if (file == NULL)
+	{
+		return -1;
+	}
+
+	size = fwrite(sim_mx25r_memory[instance], 1, MX25R6435F_FLASH_SIZE, file);
+	fclose(file);
+
+	return (size == MX25R6435F_FLASH_SIZE) ? 0 : -1;
+}
+
+/**
+  * @brief  Get the counters of a simulated memory.
+  * @param  instance: simulated memory
+  * @param  stats: filled with the counters
+  * @retval None
+  */
+void sim_mx25r_get_stats(uint32_t instance, SIM_MX25R_StatsTypeDef *stats)
+{
+	sim_update(&sim_dev[instance]);
+	*stats = sim_dev[instance].stats;
+}
+
+/**
+  * @brief  Clear the counters of a simulated memory.
+  * @param  instance: simulated memory
+  * @retval None
+  */
+void sim_mx25r_reset_stats(uint32_t instance)
+{
+	memset(&sim_dev[instance].stats, 0, sizeof(sim_dev[instance].stats));
+}
+
+/**
+  * @brief  Simulated time: the host time since sim_mx25r_init() plus the waits on the memory.
+  * @retval time in ns
+  */
+uint64_t sim_mx25r_now_ns(void)
+{
+	return (sim_host_ns() - sim_host_start_ns) + sim_stall_ns;
+}
+
+/**
+  * @brief  Let the simulated CPU wait until a simulated time.
+  * @param  time: time to wait for, in ns
+  * @retval None
+  */
+void sim_mx25r_wait_until_ns(uint64_t time)
+{
+	uint64_t now = sim_mx25r_now_ns();
+#if (SIM_MX25R_REALTIME == 1)
+	struct timespec delay;
+#endif
+
+	if (time <= now)
+	{
+		return;
+	}
+
+#if (SIM_MX25R_REALTIME == 1)
+	delay.tv_sec = (time_t)((time - now) / 1000000000ULL);
+	delay.tv_nsec = (long)((time - now) % 1000000000ULL);
+	while (nanosleep(&delay, &delay) != 0)
+	{
+	}
+#else
+	sim_stall_ns += time - now;
+#endif
+}
+
+/**
+  * @brief  Cycle counter of the simulated CPU, the DWT CYCCNT equivalent.
+  * @retval cycles, wrapping at 32 bits
+  */
+uint32_t sim_mx25r_cycles(void)
+{
+	uint64_t now = sim_mx25r_now_ns();
+	uint64_t cycles_per_us = sim_timing.cpu_hz / 1000000U;
+
+	return (uint32_t)(((now / 1000U) * cycles_per_us) + (((now % 1000U) * cycles_per_us) / 1000U));
+}
+
+/**
+  * @brief  Start a transaction: CS# low, then the instruction, address, alternate and dummy phases.
+  * @param  instance: simulated memory
+  * @param  cmd: phases of the transaction
+  * @retval None
+  */
+void sim_mx25r_select(uint32_t instance, const SIM_MX25R_CmdTypeDef *cmd)
+{
+	SIM_DeviceTypeDef *dev = &sim_dev[instance];
+	uint32_t clocks = cmd->dummy_cycles;
+	uint8_t opcode;
+
+	sim_update(dev);
+
+	dev->selected = 1;
+	dev->accepted = 0;
+	dev->format = NULL;
+	dev->count = 0;
+	dev->address = cmd->address & (MX25R6435F_FLASH_SIZE - 1);
+	dev->data_lines = cmd->data_lines;
+	memset(dev->page, 0xFF, sizeof(dev->page));
+	memset(dev->page_sent, 0, sizeof(dev->page_sent));
+	dev->stats.commands++;
+
+	if (cmd->instruction_lines != 0)
+	{
+		clocks += 8 / cmd->instruction_lines;
+	}
+	if (cmd->address_lines != 0)
+	{
+		clocks += (cmd->address_bytes * 8) / cmd->address_lines;
+	}
+	if (cmd->alternate_lines != 0)
+	{
+		clocks += (cmd->alternate_bytes * 8) / cmd->alternate_lines;
+	}
+	sim_bus(dev, clocks);
+
+	/* A CS# pulse releases the deep power down, the command is ignored and so is
+	 * any other until tRDP is over */
+	if (dev->deep_power_down)
+	{
+		dev->deep_power_down = 0;
+		dev->wake_up_end = sim_mx25r_now_ns() + ((uint64_t)sim_timing.wake_up_us * 1000U);
+		return;
+	}
+	if (sim_mx25r_now_ns() < dev->wake_up_end)
+	{
+		dev->stats.sequence_errors++;
+		return;
+	}
+
+	if (dev->pe_mode)
+	{
+		/* In performance enhance mode the transaction starts with the address of a quad I/O read */
+		if (cmd->instruction_lines != 0)
+		{
+			dev->stats.sequence_errors++;
+			dev->pe_mode = 0;
+			return;
+		}
+		opcode = QUAD_INOUT_READ_CMD;
+	}
+	else if (cmd->instruction_lines == 0)
+	{
+		/* The memory takes the first 8 bits on SIO0 as the instruction */
+		opcode = sim_sio0_bits(cmd);
+		if ((opcode != NO_OPERATION_CMD) && (opcode != RELEASE_READ_ENHANCED_CMD))
+		{
+			dev->stats.sequence_errors++;
+		}
+		return;
+	}
+	else
+	{
+		opcode = (uint8_t)cmd->instruction;
+		if (cmd->instruction_lines != 1)
+		{
+			dev->stats.sequence_errors++;
+			return;
+		}
+	}
+
+	dev->format = sim_find_format(opcode);
+	if ((dev->format == NULL) || (sim_check_format(dev->format, cmd) == 0))
+	{
+		dev->stats.sequence_errors++;
+		return;
+	}
+
+	if (((dev->sr & MX25R6435F_SR_WIP) != 0) && ((dev->format->flags & (SIM_FMT_BUSY_OK | SIM_FMT_READ)) == 0))
+	{
+		dev->stats.sequence_errors++;
+		return;
+	}
+
+	if (((dev->format->flags & SIM_FMT_QE) != 0) && ((dev->sr & MX25R6435F_SR_QE) == 0))
+	{
+		dev->stats.sequence_errors++;
+		return;
+	}
+
+	if (((dev->format->flags & SIM_FMT_WEL) != 0) && ((dev->sr & MX25R6435F_SR_WEL) == 0))
+	{
+		dev->stats.sequence_errors++;
+		return;
+	}
+
+	dev->opcode = opcode;
+	dev->accepted = 1;
+
+	if (opcode == WRITE_STATUS_CFG_REG_CMD)
+	{
+		dev->pending_regs_count = 0;
+	}
+
+	if (opcode == QUAD_INOUT_READ_CMD)
+	{
+		/* Mode bits with each nibble the complement of the other one keep the performance enhance mode */
+		dev->pe_mode = (((cmd->alternate >> 4) ^ cmd->alternate) & 0x0F) == 0x0F;
+	}
+}
+
+/**
+  * @brief  Data phase of the transaction in progress.
+  * @param  instance: simulated memory
+  * @param  data: data sent to the memory, or filled with the data read
+  * @param  size: number of bytes
+  * @param  write: 1 if the data is sent to the memory, 0 if it is read
+  * @retval None
+  */
+void sim_mx25r_transfer(uint32_t instance, uint8_t *data, uint32_t size, uint32_t write)
+{
+	SIM_DeviceTypeDef *dev = &sim_dev[instance];
+	uint32_t i;
+
+	sim_update(dev);
+
+	if (dev->data_lines != 0)
+	{
+		sim_bus(dev, (size * 8) / dev->data_lines);
+	}
+
+	if ((dev->accepted == 0) || (dev->format->data_lines == 0) ||
+	    (write != ((dev->format->flags & SIM_FMT_WRITE) != 0)))
+	{
+		if (dev->accepted != 0)
+		{
+			dev->stats.sequence_errors++;
+			dev->accepted = 0;
+		}
+
+		/* Nobody drives the bus */
+		if (write == 0)
+		{
+			memset(data, 0xFF, size);
+		}
+		return;
+	}
+
+	switch (dev->opcode)
+	{
+	case READ_CMD:
+	case FAST_READ_CMD:
+	case DUAL_OUT_READ_CMD:
+	case DUAL_INOUT_READ_CMD:
+	case QUAD_OUT_READ_CMD:
+	case QUAD_INOUT_READ_CMD:
+		if (dev->otp_mode)
+		{
+			for (i = 0; i < size; i++)
+			{
+				data[i] = sim_otp[instance][(dev->address + dev->count + i) % SIM_OTP_SIZE];
+			}
+		}
+		else
+		{
+			sim_read_array(dev, sim_mx25r_memory[instance], data, size);
+		}
+		break;
+
+	case READ_STATUS_REG_CMD:
+		memset(data, dev->sr, size);
+		break;
+
+	case READ_CFG_REG_CMD:
+		for (i = 0; i < size; i++)
+		{
+			data[i] = dev->cr[(dev->count + i) % 2];
+		}
+		break;
+
+	case READ_SEC_REG_CMD:
+		memset(data, dev->secr, size);
+		break;
+
+	case READ_ID_CMD:
+		for (i = 0; i < size; i++)
+		{
+			static const uint8_t id[3] = { SIM_MANUFACTURER_ID, SIM_MEMORY_TYPE, SIM_MEMORY_DENSITY };
+			data[i] = id[(dev->count + i) % 3];
+		}
+		break;
+
+	case READ_ELECTRONIC_ID_CMD:
+		memset(data, SIM_ELECTRONIC_ID, size);
+		break;
+
+	case READ_ELEC_MANUFACTURER_DEVICE_ID_CMD:
+		for (i = 0; i < size; i++)
+		{
+			/* the address bit 0 selects which ID comes first */
+			data[i] = (((dev->address + dev->count + i) & 1) == 0) ? SIM_MANUFACTURER_ID : SIM_ELECTRONIC_ID;
+		}
+		break;
+
+	case READ_SERIAL_FLASH_DISCO_PARAM_CMD:
+		for (i = 0; i < size; i++)
+		{
+			static const uint8_t signature[4] = { 'S', 'F', 'D', 'P' };
+			uint32_t offset = (dev->address + dev->count + i) & 0xFF;
+			data[i] = (offset < 4) ? signature[offset] : 0xFF;
+		}
+		break;
+
+	case PAGE_PROG_CMD:
+	case QUAD_PAGE_PROG_CMD:
+		/* The address wraps within the page, the last 256 bytes sent are kept */
+		for (i = 0; i < size; i++)
+		{
+			uint32_t offset = (dev->address + dev->count + i) % MX25R6435F_PAGE_SIZE;
+			dev->page[offset] = data[i];
+			dev->page_sent[offset] = 1;
+		}
+		break;
+
+	case WRITE_STATUS_CFG_REG_CMD:
+		for (i = 0; (i < size) && (dev->pending_regs_count < 3); i++)
+		{
+			dev->pending_regs[dev->pending_regs_count++] = data[i];
+		}
+		break;
+
+	case SET_BURST_LENGTH_CMD:
+		dev->burst_length = data[size - 1];
+		break;
+
+	default:
+		break;
+	}
+
+	dev->count += size;
+}
+
+/**
+  * @brief  End of the transaction: CS# high, the command is executed.
+  * @param  instance: simulated memory
+  * @retval None
+  */
+void sim_mx25r_deselect(uint32_t instance)
+{
+	SIM_DeviceTypeDef *dev = &sim_dev[instance];
+	uint8_t opcode = dev->opcode;
+	uint32_t reset_enable = dev->reset_enable;
+
+	sim_update(dev);
+
+	if (dev->selected == 0)
+	{
+		return;
+	}
+
+	dev->selected = 0;
+	dev->reset_enable = 0;
+
+	if (dev->accepted == 0)
+	{
+		return;
+	}
+	dev->accepted = 0;
+
+	/* A command needing WEL clears it once executed */
+	if ((dev->format->flags & SIM_FMT_WEL) != 0)
+	{
+		dev->sr &= ~MX25R6435F_SR_WEL;
+	}
+
+	switch (opcode)
+	{
+	case WRITE_ENABLE_CMD:
+		dev->sr |= MX25R6435F_SR_WEL;
+		break;
+
+	case WRITE_DISABLE_CMD:
+		dev->sr &= ~MX25R6435F_SR_WEL;
+		break;
+
+	case WRITE_STATUS_CFG_REG_CMD:
+		if (dev->pending_regs_count != 0)
+		{
+			sim_start_op(dev, SIM_OP_WRITE_STATUS, 0, 0, sim_timing.write_status_us);
+		}
+		break;
+
+	case PAGE_PROG_CMD:
+	case QUAD_PAGE_PROG_CMD:
+		sim_program(dev, (dev->otp_mode) ? sim_otp[instance] : sim_mx25r_memory[instance]);
+		break;
+
+	case SECTOR_ERASE_CMD:
+		sim_erase(dev, sim_mx25r_memory[instance], MX25R6435F_SECTOR_SIZE, sim_timing.sector_erase_us);
+		break;
+
+	case SUBBLOCK_ERASE_CMD:
+		sim_erase(dev, sim_mx25r_memory[instance], MX25R6435F_SUBBLOCK_SIZE, sim_timing.subblock_erase_us);
+		break;
+
+	case BLOCK_ERASE_CMD:
+		sim_erase(dev, sim_mx25r_memory[instance], MX25R6435F_BLOCK_SIZE, sim_timing.block_erase_us);
+		break;
+
+	case CHIP_ERASE_CMD:
+	case CHIP_ERASE_CMD_2:
+		sim_erase(dev, sim_mx25r_memory[instance], MX25R6435F_FLASH_SIZE, sim_timing.chip_erase_us);
+		break;
+
+	case PROG_ERASE_SUSPEND_CMD:
+	case PROG_ERASE_SUSPEND_CMD_2:
+		/* WIP is cleared once the suspend latency is over */
+		if (((dev->op == SIM_OP_PROGRAM) || (dev->op == SIM_OP_ERASE)) && (dev->suspended == 0) &&
+		    (dev->op_suspend_at == SIM_NO_EVENT))
+		{
+			dev->op_suspend_at = sim_mx25r_now_ns() + ((uint64_t)sim_timing.suspend_latency_us * 1000U);
+			dev->stats.suspends++;
+		}
+		break;
+
+	case PROG_ERASE_RESUME_CMD:
+	case PROG_ERASE_RESUME_CMD_2:
+		if (dev->suspended)
+		{
+			dev->suspended = 0;
+			dev->secr &= ~(MX25R6435F_SECR_PSB | MX25R6435F_SECR_ESB);
+			dev->sr |= MX25R6435F_SR_WIP;
+			dev->op_start = sim_mx25r_now_ns();
+			dev->op_end = dev->op_start + dev->op_remaining;
+			dev->stats.resumes++;
+		}
+		break;
+
+	case WRITE_SEC_REG_CMD:
+		dev->secr |= MX25R6435F_SECR_LDSO;
+		break;
+
+	case DEEP_POWER_DOWN_CMD:
+		dev->deep_power_down = 1;
+		break;
+
+	case ENTER_SECURED_OTP_CMD:
+		dev->otp_mode = 1;
+		break;
+
+	case EXIT_SECURED_OTP_CMD:
+		dev->otp_mode = 0;
+		break;
+
+	case RESET_ENABLE_CMD:
+		dev->reset_enable = 1;
+		break;
+
+	case RESET_MEMORY_CMD:
+		if (reset_enable)
+		{
+			sim_reset(dev);
+		}
+		break;
+
+	default:
+		break;
+	}
+}
+
+/**
+  * @brief  Time of the next change of the status register of a memory.
+  * @param  instance: simulated memory
+  * @retval time in ns, UINT64_MAX if the status can't change by itself
+  */
+uint64_t sim_mx25r_next_event_ns(uint32_t instance)
+{
+	SIM_DeviceTypeDef *dev = &sim_dev[instance];
+
+	sim_update(dev);
+
+	if ((dev->op == SIM_OP_NONE) || dev->suspended)
+	{
+		return SIM_NO_EVENT;
+	}
+
+	if ((dev->op_suspend_at != SIM_NO_EVENT) && (dev->op_suspend_at < dev->op_end))
+	{
+		return dev->op_suspend_at;
+	}
+
+	return dev->op_end;
+}
+
+/**
+  * @brief  Memory-mapped mode of the OctoSPI: the reads access the memory array directly.
+  *         The accesses are not seen by the model, the read command is checked once.
+  * @param  instance: simulated memory
+  * @param  read_cmd: read command sent for each access
+  * @param  sioo: 1 if the instruction is only sent for the first access
+  * @retval None
+  */
+void sim_mx25r_memory_mapped(uint32_t instance, const SIM_MX25R_CmdTypeDef *read_cmd, uint32_t sioo)
+{
+	SIM_DeviceTypeDef *dev = &sim_dev[instance];
+
+	sim_mx25r_select(instance, read_cmd);
+	dev->accepted = 0;
+	dev->selected = 0;
+
+	if (((dev->sr & MX25R6435F_SR_WIP) != 0) && (dev->suspended == 0))
+	{
+		dev->stats.busy_read_errors++;
+	}
+
+	/* Without SIOO the next accesses would send the instruction to a memory in performance enhance mode */
+	if (dev->pe_mode && (sioo == 0))
+	{
+		dev->stats.sequence_errors++;
+	}
+}
+
+/**
+  * @brief  Host monotonic time.
+  * @retval time in ns
+  */
+static uint64_t sim_host_ns(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return ((uint64_t)now.tv_sec * 1000000000ULL) + (uint64_t)now.tv_nsec;
+}
+
+/**
+  * @brief  Account the time the bus is driven, the clock is limited in low power mode.
+  * @param  dev: simulated memory
+  * @param  clocks: number of SCLK cycles
+  * @retval None
+  */
+static void sim_bus(SIM_DeviceTypeDef *dev, uint32_t clocks)
+{
+	uint32_t sclk_hz = sim_timing.sclk_hz;
+	uint64_t duration;
+
+	if (((dev->cr[1] & MX25R6435F_CR2_LH_SWITCH) == 0) && (sclk_hz > sim_timing.lp_sclk_hz))
+	{
+		sclk_hz = sim_timing.lp_sclk_hz;
+	}
+
+	duration = ((uint64_t)clocks * 1000000000ULL) / sclk_hz;
+	dev->stats.bus_ns += duration;
+
+	sim_mx25r_wait_until_ns(sim_mx25r_now_ns() + duration);
+}
+
+/**
+  * @brief  Bring the program, erase or suspend in progress up to the current time.
+  * @param  dev: simulated memory
+  * @retval None
+  */
+static void sim_update(SIM_DeviceTypeDef *dev)
+{
+	uint64_t now = sim_mx25r_now_ns();
+
+	if ((dev->op == SIM_OP_NONE) || dev->suspended)
+	{
+		return;
+	}
+
+	if ((dev->op_suspend_at != SIM_NO_EVENT) && (dev->op_suspend_at < dev->op_end))
+	{
+		if (now >= dev->op_suspend_at)
+		{
+			dev->suspended = 1;
+			dev->op_remaining = dev->op_end - dev->op_suspend_at;
+			dev->stats.busy_ns += dev->op_suspend_at - dev->op_start;
+			dev->op_suspend_at = SIM_NO_EVENT;
+			dev->sr &= ~(MX25R6435F_SR_WIP | MX25R6435F_SR_WEL);
+			dev->secr |= (dev->op == SIM_OP_PROGRAM) ? MX25R6435F_SECR_PSB : MX25R6435F_SECR_ESB;
+		}
+		return;
+	}
+
+	if (now >= dev->op_end)
+	{
+		sim_complete_op(dev);
+	}
+}
+
+/**
+  * @brief  Start an array operation, WIP is set for its duration.
+  * @param  dev: simulated memory
+  * @param  op: SIM_OP_xxx
+  * @param  address: start of the range
+  * @param  size: size of the range
+  * @param  duration_us: duration of the operation
+  * @retval None
+  */
+static void sim_start_op(SIM_DeviceTypeDef *dev, uint32_t op, uint32_t address, uint32_t size, uint32_t duration_us)
+{
+	dev->op = op;
+	dev->op_address = address;
+	dev->op_size = size;
+	dev->op_start = sim_mx25r_now_ns();
+	dev->op_end = dev->op_start + ((uint64_t)duration_us * 1000U);
+	dev->op_suspend_at = SIM_NO_EVENT;
+	dev->suspended = 0;
+	dev->sr |= MX25R6435F_SR_WIP;
+}
+
+/**
+  * @brief  End of the array operation in progress.
+  * @param  dev: simulated memory
+  * @retval None
+  */
+static void sim_complete_op(SIM_DeviceTypeDef *dev)
+{
+	if (dev->op == SIM_OP_WRITE_STATUS)
+	{
+		/* WIP and WEL are read-only */
+		dev->sr = (dev->sr & (MX25R6435F_SR_WIP | MX25R6435F_SR_WEL)) |
+		          (dev->pending_regs[0] & (uint8_t)~(MX25R6435F_SR_WIP | MX25R6435F_SR_WEL));
+		if (dev->pending_regs_count > 1)
+		{
+			dev->cr[0] = dev->pending_regs[1];
+		}
+		if (dev->pending_regs_count > 2)
+		{
+			dev->cr[1] = dev->pending_regs[2];
+		}
+		dev->pending_regs_count = 0;
+	}
+
+	dev->stats.busy_ns += dev->op_end - dev->op_start;
+	dev->op = SIM_OP_NONE;
+	dev->op_suspend_at = SIM_NO_EVENT;
+	dev->sr &= ~(MX25R6435F_SR_WIP | MX25R6435F_SR_WEL);
+}
+
+/**
+  * @brief  Find the expected format of a command.
+  * @param  opcode: instruction
+  * @retval the format, NULL for an unknown instruction
+  */
+static const SIM_FormatTypeDef *sim_find_format(uint8_t opcode)
+{
+	uint32_t i;
+
+	for (i = 0; i < sizeof(sim_formats) / sizeof(sim_formats[0]); i++)
+	{
+		if (sim_formats[i].opcode == opcode)
+		{
+			return &sim_formats[i];
+		}
+	}
+
+	return NULL;
+}
+
+/**
+  * @brief  Check the phases of a transaction against the format of its command.
+  * @param  format: expected format
+  * @param  cmd: phases of the transaction
+  * @retval 1 if they match, 0 otherwise
+  */
+static uint32_t sim_check_format(const SIM_FormatTypeDef *format, const SIM_MX25R_CmdTypeDef *cmd)
+{
+	if ((cmd->address_lines != format->address_lines) || ((format->address_lines != 0) && (cmd->address_bytes != 3)))
+	{
+		return 0;
+	}
+
+	/* The mode bits of the quad I/O read count as 2 of its 6 dummy clocks */
+	if ((cmd->alternate_lines != format->alternate_lines) || ((format->alternate_lines != 0) && (cmd->alternate_bytes != 1)))
+	{
+		return 0;
+	}
+
+	if (cmd->data_lines == 0)
+	{
+		return (format->data_lines == 0) || ((format->flags & SIM_FMT_DATA_OPTIONAL) != 0);
+	}
+
+	return (cmd->data_lines == format->data_lines) && (cmd->dummy_cycles == format->dummy_cycles);
+}
+
+/**
+  * @brief  Instruction seen by a memory not in performance enhance mode when the instruction
+  *         phase is skipped: the first 8 bits on SIO0 of the address and alternate phases.
+  * @param  cmd: phases of the transaction
+  * @retval the instruction
+  */
+static uint8_t sim_sio0_bits(const SIM_MX25R_CmdTypeDef *cmd)
+{
+	uint32_t values[2] = { cmd->address, cmd->alternate };
+	uint32_t bits[2] = { cmd->address_bytes * 8, cmd->alternate_bytes * 8 };
+	uint32_t lines[2] = { cmd->address_lines, cmd->alternate_lines };
+	uint32_t opcode = 0, clocks = 0, phase;
+	int32_t shift;
+
+	for (phase = 0; (phase < 2) && (clocks < 8); phase++)
+	{
+		if (lines[phase] == 0)
+		{
+			continue;
+		}
+
+		for (shift = (int32_t)(bits[phase] - lines[phase]); (shift >= 0) && (clocks < 8); shift -= (int32_t)lines[phase])
+		{
+			opcode = (opcode << 1) | ((values[phase] >> shift) & 1U);
+			clocks++;
+		}
+	}
+
+	/* SIO0 is pulled up during the clocks left */
+	while (clocks < 8)
+	{
+		opcode = (opcode << 1) | 1U;
+		clocks++;
+	}
+
+	return (uint8_t)opcode;
+}
+
+/**
+  * @brief  Read the array, the address wraps at the end of the memory.
+  * @param  dev: simulated memory
+  * @param  memory: content of the memory
+  * @param  data: destination
+  * @param  size: number of bytes
+  * @retval None
+  */
+static void sim_read_array(SIM_DeviceTypeDef *dev, uint8_t *memory, uint8_t *data, uint32_t size)
+{
+	uint32_t address = (dev->address + dev->count) & (MX25R6435F_FLASH_SIZE - 1);
+	uint32_t chunk;
+
+	/* The array can't be read during a program or erase, only once it is suspended */
+	if ((dev->sr & MX25R6435F_SR_WIP) != 0)
+	{
+		dev->stats.busy_read_errors++;
+		memset(data, 0xFF, size);
+		return;
+	}
+
+	if (dev->suspended && (address < (dev->op_address + dev->op_size)) && ((address + size) > dev->op_address))
+	{
+		dev->stats.busy_read_errors++;
+	}
+
+	dev->stats.reads++;
+	dev->stats.read_bytes += size;
+
+	while (size != 0)
+	{
+		chunk = MX25R6435F_FLASH_SIZE - address;
+		if (chunk > size)
+		{
+			chunk = size;
+		}
+
+		memcpy(data, &memory[address], chunk);
+		data += chunk;
+		size -= chunk;
+		address = 0;
+	}
+}
+
+/**
+  * @brief  Program the page buffer: bits can only go from 1 to 0.
+  *         The duration is linear between tBP for a byte and tPP for a whole page.
+  * @param  dev: simulated memory
+  * @param  memory: content of the memory, or of the secured OTP area
+  * @retval None
+  */
+static void sim_program(SIM_DeviceTypeDef *dev, uint8_t *memory)
+{
+	uint32_t base = dev->address & ~(MX25R6435F_PAGE_SIZE - 1U);
+	uint32_t i, bytes = 0;
+
+	if (dev->otp_mode)
+	{
+		base %= SIM_OTP_SIZE;
+	}
+
+	/* A program can't target the range of the suspended erase */
+	if (dev->suspended && (base < (dev->op_address + dev->op_size)) && ((base + MX25R6435F_PAGE_SIZE) > dev->op_address))
+	{
+		dev->stats.sequence_errors++;
+		dev->secr |= MX25R6435F_SECR_P_FAIL;
+		return;
+	}
+
+	/* Only one program can be suspended */
+	if (dev->suspended && (dev->op == SIM_OP_PROGRAM))
+	{
+		dev->stats.sequence_errors++;
+		return;
+	}
+
+	for (i = 0; i < MX25R6435F_PAGE_SIZE; i++)
+	{
+		if (dev->page_sent[i] == 0)
+		{
+			continue;
+		}
+
+		if ((dev->page[i] & (uint8_t)~memory[base + i]) != 0)
+		{
+			dev->stats.program_bit_errors++;
+		}
+
+		memory[base + i] &= dev->page[i];
+		bytes++;
+	}
+
+	if (bytes == 0)
+	{
+		return;
+	}
+
+	dev->stats.programs++;
+	dev->stats.program_bytes += bytes;
+
+	/* A program during an erase suspend doesn't lose the suspended erase */
+	if (dev->suspended)
+	{
+		dev->sr |= MX25R6435F_SR_WIP;
+		sim_mx25r_wait_until_ns(sim_mx25r_now_ns() + ((uint64_t)(sim_timing.byte_program_us +
+		                        ((sim_timing.page_program_us - sim_timing.byte_program_us) * (bytes - 1)) / (MX25R6435F_PAGE_SIZE - 1)) * 1000U));
+		dev->sr &= ~(MX25R6435F_SR_WIP | MX25R6435F_SR_WEL);
+		return;
+	}
+
+	sim_start_op(dev, SIM_OP_PROGRAM, base, MX25R6435F_PAGE_SIZE,
+	             sim_timing.byte_program_us + ((sim_timing.page_program_us - sim_timing.byte_program_us) * (bytes - 1)) / (MX25R6435F_PAGE_SIZE - 1));
+}
+
+/**
+  * @brief  Erase an aligned range of the array.
+  * @param  dev: simulated memory
+  * @param  memory: content of the memory
+  * @param  size: size of the erase unit
+  * @param  duration_us: duration of the erase
+  * @retval None
+  */
+static void sim_erase(SIM_DeviceTypeDef *dev, uint8_t *memory, uint32_t size, uint32_t duration_us)
+{
+	uint32_t base = dev->address & ~(size - 1U);
+
+	/* No erase while a program or erase is suspended */
+	if (dev->suspended || dev->otp_mode)
+	{
+		dev->stats.sequence_errors++;
+		dev->secr |= MX25R6435F_SECR_E_FAIL;
+		return;
+	}
+
+	memset(&memory[base], 0xFF, size);
+	dev->stats.erases++;
+
+	sim_start_op(dev, SIM_OP_ERASE, base, size, duration_us);
+}
+
+/**
+  * @brief  Software reset: the operation in progress is aborted, the volatile state is cleared.
+  * @param  dev: simulated memory
+  * @retval None
+  */
+static void sim_reset(SIM_DeviceTypeDef *dev)
+{
+	if (dev->op != SIM_OP_NONE)
+	{
+		dev->stats.busy_ns += sim_mx25r_now_ns() - dev->op_start;
+	}
+
+	dev->op = SIM_OP_NONE;
+	dev->suspended = 0;
+	dev->op_suspend_at = SIM_NO_EVENT;
+	dev->pending_regs_count = 0;
+	dev->pe_mode = 0;
+	dev->otp_mode = 0;
+	dev->burst_length = 0;
+	dev->sr &= (uint8_t)~(MX25R6435F_SR_WIP | MX25R6435F_SR_WEL);
+	dev->secr &= (uint8_t)~(MX25R6435F_SECR_PSB | MX25R6435F_SECR_ESB | MX25R6435F_SECR_P_FAIL | MX25R6435F_SECR_E_FAIL);
+
+	/* Busy for the reset recovery time */
+	sim_start_op(dev, SIM_OP_RESET, 0, 0, sim_timing.reset_recovery_us);
+}
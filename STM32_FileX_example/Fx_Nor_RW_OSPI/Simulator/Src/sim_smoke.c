@@ -0,0 +1,304 @@
+/**
+  ******************************************************************************
+  * @file    sim_smoke.c
+  * @brief   Host smoke test of the OSPI LevelX glue on the MX25R6435F simulator.
+  ******************************************************************************
+  * Mounts the FileX volume of the simulated memory through LevelX and the glue,
+  * formatting it when there is no valid volume, writes a file, reads it back
+  * and prints the simulated time of each step and the counters of the memory.
+  * The memory starts erased, or from the image given as first argument, which
+  * is then saved back on exit.
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "main.h"
+#include "tx_api.h"
+#include "fx_api.h"
+#include "fx_stm32_levelx_nor_driver.h"
+#include "sim_mx25r6435f.h"
+
+#define SIM_SMOKE_STACK_SIZE         (16 * 1024)
+#define SIM_SMOKE_SECTOR_SIZE        512
+#define SIM_SMOKE_FILE_NAME          "SMOKE.BIN"
+#define SIM_SMOKE_FILE_SIZE          (64 * 1024)
+#define SIM_SMOKE_VOLUME_NAME        "SIM_NOR_OSPI_DISK"
+
+/* Same driver choice as the application, set by the STRIPE and SCHED variables of the Makefile */
+#if (LX_STM32_OSPI_STRIPE == 1)
+#define SIM_SMOKE_DRIVER_ID          LX_NOR_OSPI_STRIPE_DRIVER_ID
+#define SIM_SMOKE_FLASH_SIZE         (2 * LX_STM32_OSPI_FLASH_SIZE)
+#elif (LX_STM32_OSPI_SCHED == 1)
+#define SIM_SMOKE_DRIVER_ID          LX_NOR_OSPI_SCHED_DRIVER_ID
+#define SIM_SMOKE_FLASH_SIZE         LX_STM32_OSPI_FLASH_SIZE
+#else
+#define SIM_SMOKE_DRIVER_ID          LX_NOR_OSPI_DRIVER_ID
+#define SIM_SMOKE_FLASH_SIZE         LX_STM32_OSPI_FLASH_SIZE
+#endif
+
+static TX_THREAD sim_smoke_thread;
+static ULONG     sim_smoke_stack[SIM_SMOKE_STACK_SIZE / sizeof(ULONG)];
+static FX_MEDIA  sim_smoke_media;
+static FX_FILE   sim_smoke_file;
+static ULONG     sim_smoke_media_memory[SIM_SMOKE_SECTOR_SIZE / sizeof(ULONG)];
+static UCHAR     sim_smoke_buffer[SIM_SMOKE_SECTOR_SIZE];
+static const char *sim_smoke_image;
+
+static void sim_smoke_thread_entry(ULONG thread_input);
+static UINT sim_smoke_mount(void);
+static UINT sim_smoke_write(void);
+static UINT sim_smoke_read(void);
+static uint32_t sim_smoke_print_stats(void);
+
+/**
+  * @brief  Error handler of the drivers, the smoke test stops.
+  * @retval None
+  */
+void Error_Handler(void)
+{
+	printf("Error_Handler called\n");
+	exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+	sim_mx25r_init(NULL);
+
+	if (argc > 1)
+	{
+		sim_smoke_image = argv[1];
+		if (sim_mx25r_load(0, sim_smoke_image) != 0)
+		{
+			printf("No image in %s, starting from an erased memory\n", sim_smoke_image);
+		}
+	}
+
+	/* Done by MX_OCTOSPI1_Init on the board */
+	hospi1.Instance = OCTOSPI1;
+	if (HAL_OSPI_Init(&hospi1) != HAL_OK)
+	{
+		return 1;
+	}
+
+#if (LX_STM32_OSPI_STRIPE == 1)
+	hospi2.Instance = OCTOSPI2;
+	if (HAL_OSPI_Init(&hospi2) != HAL_OK)
+	{
+		return 1;
+	}
+#endif
+
+	tx_kernel_enter();
+
+	return 0;
+}
+
+void tx_application_define(void *first_unused_memory)
+{
+	UNUSED(first_unused_memory);
+
+	if (tx_thread_create(&sim_smoke_thread, "sim smoke thread", sim_smoke_thread_entry, 0, sim_smoke_stack,
+	                     sizeof(sim_smoke_stack), 10, 10, TX_NO_TIME_SLICE, TX_AUTO_START) != TX_SUCCESS)
+	{
+		Error_Handler();
+	}
+}
+
+/**
+  * @brief  Smoke test thread: mount, write, read back, then report and exit.
+  * @param  thread_input: unused
+  * @retval None
+  */
+static void sim_smoke_thread_entry(ULONG thread_input)
+{
+	uint64_t start;
+	UINT status;
+
+	UNUSED(thread_input);
+
+	fx_system_initialize();
+
+	start = sim_mx25r_now_ns();
+	status = sim_smoke_mount();
+	printf("Mount: status 0x%02X, %lu us\n", status, (unsigned long)((sim_mx25r_now_ns() - start) / 1000));
+
+	if (status == FX_SUCCESS)
+	{
+		start = sim_mx25r_now_ns();
+		status = sim_smoke_write();
+		printf("Write %u bytes: status 0x%02X, %lu us\n", SIM_SMOKE_FILE_SIZE, status, (unsigned long)((sim_mx25r_now_ns() - start) / 1000));
+	}
+
+	if (status == FX_SUCCESS)
+	{
+		start = sim_mx25r_now_ns();
+		status = sim_smoke_read();
+		printf("Read back %u bytes: status 0x%02X, %lu us\n", SIM_SMOKE_FILE_SIZE, status, (unsigned long)((sim_mx25r_now_ns() - start) / 1000));
+	}
+
+	if (fx_media_close(&sim_smoke_media) != FX_SUCCESS)
+	{
+		status = FX_IO_ERROR;
+	}
+
+	/* The memory counts what it would have ignored or got wrong */
+	if ((sim_smoke_print_stats() != 0) && (status == FX_SUCCESS))
+	{
+		status = FX_IO_ERROR;
+	}
+
+	if ((sim_smoke_image != NULL) && (sim_mx25r_save(0, sim_smoke_image) != 0))
+	{
+		printf("Image not saved to %s\n", sim_smoke_image);
+	}
+
+	printf("Smoke test %s\n", (status == FX_SUCCESS) ? "passed" : "FAILED");
+	exit((status == FX_SUCCESS) ? 0 : 1);
+}
+
+/**
+  * @brief  Open the volume, format it first if there is no valid one.
+  * @retval FX status
+  */
+static UINT sim_smoke_mount(void)
+{
+	UINT status;
+
+	status = fx_media_open(&sim_smoke_media, SIM_SMOKE_VOLUME_NAME, fx_stm32_levelx_nor_driver, (VOID *)SIM_SMOKE_DRIVER_ID,
+	                       sim_smoke_media_memory, sizeof(sim_smoke_media_memory));
+	if (status == FX_SUCCESS)
+	{
+		return FX_SUCCESS;
+	}
+
+	if ((status != FX_MEDIA_INVALID) && (status != FX_BOOT_ERROR) && (status != FX_FAT_READ_ERROR))
+	{
+		return status;
+	}
+
+	printf("No valid volume (status 0x%02X), formatting\n", status);
+
+	status = fx_media_format(&sim_smoke_media, fx_stm32_levelx_nor_driver, (VOID *)SIM_SMOKE_DRIVER_ID,
+	                         (UCHAR *)sim_smoke_media_memory, sizeof(sim_smoke_media_memory), SIM_SMOKE_VOLUME_NAME,
+	                         1, 32, 0, SIM_SMOKE_FLASH_SIZE / SIM_SMOKE_SECTOR_SIZE, SIM_SMOKE_SECTOR_SIZE, 8, 1, 1);
+	if (status != FX_SUCCESS)
+	{
+		return status;
+	}
+
+	return fx_media_open(&sim_smoke_media, SIM_SMOKE_VOLUME_NAME, fx_stm32_levelx_nor_driver, (VOID *)SIM_SMOKE_DRIVER_ID,
+	                     sim_smoke_media_memory, sizeof(sim_smoke_media_memory));
+}
+
+/**
+  * @brief  Write the test file, each byte set from its offset.
+  * @retval FX status
+  */
+static UINT sim_smoke_write(void)
+{
+	ULONG offset;
+	UINT i;
+	UINT status;
+
+	fx_file_delete(&sim_smoke_media, SIM_SMOKE_FILE_NAME);
+
+	status = fx_file_create(&sim_smoke_media, SIM_SMOKE_FILE_NAME);
+	if (status != FX_SUCCESS)
+	{
+		return status;
+	}
+
+	status = fx_file_open(&sim_smoke_media, &sim_smoke_file, SIM_SMOKE_FILE_NAME, FX_OPEN_FOR_WRITE);
+	if (status != FX_SUCCESS)
+	{
+		return status;
+	}
+
+	for (offset = 0; (offset < SIM_SMOKE_FILE_SIZE) && (status == FX_SUCCESS); offset += sizeof(sim_smoke_buffer))
+	{
+		for (i = 0; i < sizeof(sim_smoke_buffer); i++)
+		{
+			sim_smoke_buffer[i] = (UCHAR)((offset + i) * 7);
+		}
+
+		status = fx_file_write(&sim_smoke_file, sim_smoke_buffer, sizeof(sim_smoke_buffer));
+	}
+
+	if (fx_file_close(&sim_smoke_file) != FX_SUCCESS)
+	{
+		return FX_IO_ERROR;
+	}
+
+	if (status != FX_SUCCESS)
+	{
+		return status;
+	}
+
+	return fx_media_flush(&sim_smoke_media);
+}
+
+/**
+  * @brief  Read the test file back and check its content.
+  * @retval FX status, FX_IO_ERROR on a mismatch
+  */
+static UINT sim_smoke_read(void)
+{
+	ULONG offset, actual;
+	UINT i;
+	UINT status;
+
+	status = fx_file_open(&sim_smoke_media, &sim_smoke_file, SIM_SMOKE_FILE_NAME, FX_OPEN_FOR_READ);
+	if (status != FX_SUCCESS)
+	{
+		return status;
+	}
+
+	for (offset = 0; (offset < SIM_SMOKE_FILE_SIZE) && (status == FX_SUCCESS); offset += sizeof(sim_smoke_buffer))
+	{
+		status = fx_file_read(&sim_smoke_file, sim_smoke_buffer, sizeof(sim_smoke_buffer), &actual);
+		if ((status == FX_SUCCESS) && (actual != sizeof(sim_smoke_buffer)))
+		{
+			status = FX_IO_ERROR;
+		}
+
+		for (i = 0; (i < sizeof(sim_smoke_buffer)) && (status == FX_SUCCESS); i++)
+		{
+			if (sim_smoke_buffer[i] != (UCHAR)((offset + i) * 7))
+			{
+				printf("Mismatch at offset %lu\n", (unsigned long)(offset + i));
+				status = FX_IO_ERROR;
+			}
+		}
+	}
+
+	if (fx_file_close(&sim_smoke_file) != FX_SUCCESS)
+	{
+		return FX_IO_ERROR;
+	}
+
+	return status;
+}
+
+/**
+  * @brief  Print the counters of the simulated memory.
+  * @retval number of errors seen by the memory
+  */
+static uint32_t sim_smoke_print_stats(void)
+{
+	SIM_MX25R_StatsTypeDef stats;
+
+	sim_mx25r_get_stats(0, &stats);
+
+	printf("Simulated time: %lu us\n", (unsigned long)(sim_mx25r_now_ns() / 1000));
+	printf("Memory: %lu commands, %lu reads (%llu bytes), %lu programs (%llu bytes), %lu erases, %lu suspends\n",
+	       (unsigned long)stats.commands, (unsigned long)stats.reads, (unsigned long long)stats.read_bytes,
+	       (unsigned long)stats.programs, (unsigned long long)stats.program_bytes, (unsigned long)stats.erases,
+	       (unsigned long)stats.suspends);
+	printf("Bus busy %llu us, memory busy %llu us\n",
+	       (unsigned long long)(stats.bus_ns / 1000), (unsigned long long)(stats.busy_ns / 1000));
+	printf("Errors: %lu program bit, %lu sequence, %lu busy read\n",
+	       (unsigned long)stats.program_bit_errors, (unsigned long)stats.sequence_errors, (unsigned long)stats.busy_read_errors);
+
+	return stats.program_bit_errors + stats.sequence_errors + stats.busy_read_errors;
+}
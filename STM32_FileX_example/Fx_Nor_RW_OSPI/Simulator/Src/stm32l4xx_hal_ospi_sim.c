@@ -0,0 +1,585 @@
+/**
+  ******************************************************************************
+  * @file    stm32l4xx_hal_ospi_sim.c
+  * @brief   HAL OSPI API on top of the MX25R6435F model, for the simulator build.
+  ******************************************************************************
+  * The transfers complete before the functions return: the simulated clock is
+  * moved by the bus time and the completion callbacks are called from the
+  * caller context, as the interrupt would have been. The auto-polling jumps to
+  * the next change of the status register instead of sending a read status
+  * register every interval. The accesses in memory-mapped mode are plain reads
+  * of the simulated memory, they are not timed.
+  ******************************************************************************
+  */
+
+#include "stm32l4xx_hal.h"
+
+/* state of the OctoSPI not kept in the handle */
+typedef struct
+{
+	SIM_MX25R_CmdTypeDef cmd;               /*!< regular command waiting for its data phase */
+	uint32_t             nb_data;
+	SIM_MX25R_CmdTypeDef read_cmd;          /*!< read command of the memory-mapped mode */
+	uint32_t             read_sioo;
+} SIM_OSPI_StateTypeDef;
+
+OSPI_HandleTypeDef hospi1;
+OSPI_HandleTypeDef hospi2;
+
+OCTOSPI_TypeDef sim_octospi_regs[SIM_MX25R_INSTANCE_COUNT];
+DMA_Channel_TypeDef sim_dma_channels[2];
+GPIO_TypeDef sim_gpiob;
+uint32_t SystemCoreClock = 120000000U;
+
+static SIM_OSPI_StateTypeDef sim_ospi[SIM_MX25R_INSTANCE_COUNT];
+
+static uint32_t sim_ospi_instance(OSPI_HandleTypeDef *hospi);
+static uint32_t sim_ospi_lines(uint32_t mode, uint32_t shift);
+static void sim_ospi_convert(const OSPI_RegularCmdTypeDef *cmd, SIM_MX25R_CmdTypeDef *sim_cmd);
+static HAL_StatusTypeDef sim_ospi_data(OSPI_HandleTypeDef *hospi, uint8_t *pData, uint32_t write);
+static HAL_StatusTypeDef sim_ospi_poll(OSPI_HandleTypeDef *hospi, OSPI_AutoPollingTypeDef *cfg, uint64_t deadline);
+
+/**
+  * @brief  Initialize the OctoSPI.
+  * @param  hospi: OSPI handle
+  * @retval HAL status
+  */
+HAL_StatusTypeDef HAL_OSPI_Init(OSPI_HandleTypeDef *hospi)
+{
+	if ((hospi == NULL) || (sim_ospi_instance(hospi) >= SIM_MX25R_INSTANCE_COUNT))
+	{
+		return HAL_ERROR;
+	}
+
+	hospi->ErrorCode = HAL_OSPI_ERROR_NONE;
+	hospi->Timeout = HAL_OSPI_TIMEOUT_DEFAULT_VALUE;
+	hospi->State = HAL_OSPI_STATE_READY;
+
+	return HAL_OK;
+}
+
+/**
+  * @brief  De-initialize the OctoSPI.
+  * @param  hospi: OSPI handle
+  * @retval HAL status
+  */
+HAL_StatusTypeDef HAL_OSPI_DeInit(OSPI_HandleTypeDef *hospi)
+{
+	if (hospi == NULL)
+	{
+		return HAL_ERROR;
+	}
+
+	HAL_OSPI_Abort(hospi);
+	hospi->State = HAL_OSPI_STATE_RESET;
+
+	return HAL_OK;
+}
+
+/**
+  * @brief  Send the command phases. Without data phase the transaction ends here, otherwise
+  *         it waits for HAL_OSPI_Transmit/Receive or HAL_OSPI_AutoPolling.
+  * @param  hospi: OSPI handle
+  * @param  cmd: command
+  * @param  Timeout: not used, the command completes at once
+  * @retval HAL status
+  */
+HAL_StatusTypeDef HAL_OSPI_Command(OSPI_HandleTypeDef *hospi, OSPI_RegularCmdTypeDef *cmd, uint32_t Timeout)
+{
+	SIM_OSPI_StateTypeDef *state = &sim_ospi[sim_ospi_instance(hospi)];
+
+	UNUSED(Timeout);
+
+	if ((hospi->State != HAL_OSPI_STATE_READY) && (hospi->State != HAL_OSPI_STATE_CMD_CFG) &&
+	    (hospi->State != HAL_OSPI_STATE_READ_CMD_CFG) && (hospi->State != HAL_OSPI_STATE_WRITE_CMD_CFG))
+	{
+		hospi->ErrorCode = HAL_OSPI_ERROR_INVALID_SEQUENCE;
+		return HAL_ERROR;
+	}
+
+	hospi->ErrorCode = HAL_OSPI_ERROR_NONE;
+
+	switch (cmd->OperationType)
+	{
+	case HAL_OSPI_OPTYPE_READ_CFG:
+		sim_ospi_convert(cmd, &state->read_cmd);
+		state->read_sioo = (cmd->SIOOMode == HAL_OSPI_SIOO_INST_ONLY_FIRST_CMD);
+		hospi->State = HAL_OSPI_STATE_READ_CMD_CFG;
+		return HAL_OK;
+
+	case HAL_OSPI_OPTYPE_WRITE_CFG:
+		hospi->State = (hospi->State == HAL_OSPI_STATE_READ_CMD_CFG) ? HAL_OSPI_STATE_CMD_CFG : HAL_OSPI_STATE_WRITE_CMD_CFG;
+		return HAL_OK;
+
+	case HAL_OSPI_OPTYPE_COMMON_CFG:
+		break;
+
+	default:
+		hospi->ErrorCode = HAL_OSPI_ERROR_INVALID_PARAM;
+		return HAL_ERROR;
+	}
+
+	sim_ospi_convert(cmd, &state->cmd);
+	state->nb_data = cmd->NbData;
+
+	sim_mx25r_select(sim_ospi_instance(hospi), &state->cmd);
+
+	if (cmd->DataMode == HAL_OSPI_DATA_NONE)
+	{
+		sim_mx25r_deselect(sim_ospi_instance(hospi));
+		hospi->State = HAL_OSPI_STATE_READY;
+	}
+	else
+	{
+		hospi->State = HAL_OSPI_STATE_CMD_CFG;
+	}
+
+	return HAL_OK;
+}
+
+/**
+  * @brief  Send the command phases, HAL_OSPI_CmdCpltCallback is called when there is no data phase.
+  * @param  hospi: OSPI handle
+  * @param  cmd: command
+  * @retval HAL status
+  */
+HAL_StatusTypeDef HAL_OSPI_Command_IT(OSPI_HandleTypeDef *hospi, OSPI_RegularCmdTypeDef *cmd)
+{
+	HAL_StatusTypeDef status = HAL_OSPI_Command(hospi, cmd, 0);
+
+	if ((status == HAL_OK) && (cmd->DataMode == HAL_OSPI_DATA_NONE) && (cmd->OperationType == HAL_OSPI_OPTYPE_COMMON_CFG))
+	{
+		HAL_OSPI_CmdCpltCallback(hospi);
+	}
+
+	return status;
+}
+
+/**
+  * @brief  Data phase of the configured command, sent to the memory.
+  * @param  hospi: OSPI handle
+  * @param  pData: data to send
+  * @param  Timeout: not used, the transfer completes at once
+  * @retval HAL status
+  */
+HAL_StatusTypeDef HAL_OSPI_Transmit(OSPI_HandleTypeDef *hospi, uint8_t *pData, uint32_t Timeout)
+{
+	UNUSED(Timeout);
+
+	return sim_ospi_data(hospi, pData, 1);
+}
+
+/**
+  * @brief  Data phase of the configured command, read from the memory.
+  * @param  hospi: OSPI handle
+  * @param  pData: destination of the data
+  * @param  Timeout: not used, the transfer completes at once
+  * @retval HAL status
+  */
+HAL_StatusTypeDef HAL_OSPI_Receive(OSPI_HandleTypeDef *hospi, uint8_t *pData, uint32_t Timeout)
+{
+	UNUSED(Timeout);
+
+	return sim_ospi_data(hospi, pData, 0);
+}
+
+/**
+  * @brief  Data phase sent to the memory, then HAL_OSPI_TxCpltCallback.
+  * @param  hospi: OSPI handle
+  * @param  pData: data to send
+  * @retval HAL status
+  */
+HAL_StatusTypeDef HAL_OSPI_Transmit_IT(OSPI_HandleTypeDef *hospi, uint8_t *pData)
+{
+	HAL_StatusTypeDef status = sim_ospi_data(hospi, pData, 1);
+
+	if (status == HAL_OK)
+	{
+		HAL_OSPI_TxCpltCallback(hospi);
+	}
+
+	return status;
+}
+
+/**
+  * @brief  Data phase read from the memory, then HAL_OSPI_RxCpltCallback.
+  * @param  hospi: OSPI handle
+  * @param  pData: destination of the data
+  * @retval HAL status
+  */
+HAL_StatusTypeDef HAL_OSPI_Receive_IT(OSPI_HandleTypeDef *hospi, uint8_t *pData)
+{
+	HAL_StatusTypeDef status = sim_ospi_data(hospi, pData, 0);
+
+	if (status == HAL_OK)
+	{
+		HAL_OSPI_RxCpltCallback(hospi);
+	}
+
+	return status;
+}
+
+/**
+  * @brief  Same as HAL_OSPI_Transmit_IT, the DMA is not simulated.
+  * @param  hospi: OSPI handle
+  * @param  pData: data to send
+  * @retval HAL status
+  */
+HAL_StatusTypeDef HAL_OSPI_Transmit_DMA(OSPI_HandleTypeDef *hospi, uint8_t *pData)
+{
+	return HAL_OSPI_Transmit_IT(hospi, pData);
+}
+
+/**
+  * @brief  Same as HAL_OSPI_Receive_IT, the DMA is not simulated.
+  * @param  hospi: OSPI handle
+  * @param  pData: destination of the data
+  * @retval HAL status
+  */
+HAL_StatusTypeDef HAL_OSPI_Receive_DMA(OSPI_HandleTypeDef *hospi, uint8_t *pData)
+{
+	return HAL_OSPI_Receive_IT(hospi, pData);
+}
+
+/**
+  * @brief  Read the configured status register until it matches.
+  * @param  hospi: OSPI handle
+  * @param  cfg: match configuration
+  * @param  Timeout: timeout in ms
+  * @retval HAL status
+  */
+HAL_StatusTypeDef HAL_OSPI_AutoPolling(OSPI_HandleTypeDef *hospi, OSPI_AutoPollingTypeDef *cfg, uint32_t Timeout)
+{
+	return sim_ospi_poll(hospi, cfg, sim_mx25r_now_ns() + ((uint64_t)Timeout * 1000000U));
+}
+
+/**
+  * @brief  Read the configured status register until it matches, then HAL_OSPI_StatusMatchCallback.
+  *         If the status can't match the polling stays active until HAL_OSPI_Abort.
+  * @param  hospi: OSPI handle
+  * @param  cfg: match configuration
+  * @retval HAL status
+  */
+HAL_StatusTypeDef HAL_OSPI_AutoPolling_IT(OSPI_HandleTypeDef *hospi, OSPI_AutoPollingTypeDef *cfg)
+{
+	HAL_StatusTypeDef status = sim_ospi_poll(hospi, cfg, UINT64_MAX);
+
+	if (status == HAL_OK)
+	{
+		HAL_OSPI_StatusMatchCallback(hospi);
+	}
+	else if (hospi->ErrorCode == HAL_OSPI_ERROR_TIMEOUT)
+	{
+		hospi->ErrorCode = HAL_OSPI_ERROR_NONE;
+		hospi->State = HAL_OSPI_STATE_BUSY_AUTO_POLLING;
+		status = HAL_OK;
+	}
+
+	return status;
+}
+
+/**
+  * @brief  Enter the memory-mapped mode with the configured read command.
+  * @param  hospi: OSPI handle
+  * @param  cfg: not used, the timeout counter is not simulated
+  * @retval HAL status
+  */
+HAL_StatusTypeDef HAL_OSPI_MemoryMapped(OSPI_HandleTypeDef *hospi, OSPI_MemoryMappedTypeDef *cfg)
+{
+	SIM_OSPI_StateTypeDef *state = &sim_ospi[sim_ospi_instance(hospi)];
+
+	UNUSED(cfg);
+
+	if (hospi->State != HAL_OSPI_STATE_CMD_CFG)
+	{
+		hospi->ErrorCode = HAL_OSPI_ERROR_INVALID_SEQUENCE;
+		return HAL_ERROR;
+	}
+
+	sim_mx25r_memory_mapped(sim_ospi_instance(hospi), &state->read_cmd, state->read_sioo);
+	hospi->State = HAL_OSPI_STATE_BUSY_MEM_MAPPED;
+
+	return HAL_OK;
+}
+
+/**
+  * @brief  Abort the operation in progress, CS# goes high.
+  * @param  hospi: OSPI handle
+  * @retval HAL status
+  */
+HAL_StatusTypeDef HAL_OSPI_Abort(OSPI_HandleTypeDef *hospi)
+{
+	sim_mx25r_deselect(sim_ospi_instance(hospi));
+
+	hospi->State = HAL_OSPI_STATE_READY;
+
+	return HAL_OK;
+}
+
+/**
+  * @brief  Get the state of the OSPI handle.
+  * @param  hospi: OSPI handle
+  * @retval HAL_OSPI_STATE_xxx
+  */
+uint32_t HAL_OSPI_GetState(OSPI_HandleTypeDef *hospi)
+{
+	return hospi->State;
+}
+
+/**
+  * @brief  Get the last error of the OSPI handle.
+  * @param  hospi: OSPI handle
+  * @retval HAL_OSPI_ERROR_xxx
+  */
+uint32_t HAL_OSPI_GetError(OSPI_HandleTypeDef *hospi)
+{
+	return hospi->ErrorCode;
+}
+
+/**
+  * @brief  Nothing to do, the callbacks are called by the transfer functions.
+  * @param  hospi: OSPI handle
+  * @retval None
+  */
+void HAL_OSPI_IRQHandler(OSPI_HandleTypeDef *hospi)
+{
+	UNUSED(hospi);
+}
+
+__attribute__((weak)) void HAL_OSPI_CmdCpltCallback(OSPI_HandleTypeDef *hospi)
+{
+	UNUSED(hospi);
+}
+
+__attribute__((weak)) void HAL_OSPI_RxCpltCallback(OSPI_HandleTypeDef *hospi)
+{
+	UNUSED(hospi);
+}
+
+__attribute__((weak)) void HAL_OSPI_TxCpltCallback(OSPI_HandleTypeDef *hospi)
+{
+	UNUSED(hospi);
+}
+
+__attribute__((weak)) void HAL_OSPI_StatusMatchCallback(OSPI_HandleTypeDef *hospi)
+{
+	UNUSED(hospi);
+}
+
+__attribute__((weak)) void HAL_OSPI_ErrorCallback(OSPI_HandleTypeDef *hospi)
+{
+	UNUSED(hospi);
+}
+
+HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef *hdma)
+{
+	UNUSED(hdma);
+
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_DMA_DeInit(DMA_HandleTypeDef *hdma)
+{
+	UNUSED(hdma);
+
+	return HAL_OK;
+}
+
+void HAL_DMA_IRQHandler(DMA_HandleTypeDef *hdma)
+{
+	UNUSED(hdma);
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState)
+{
+	if (PinState == GPIO_PIN_SET)
+	{
+		GPIOx->ODR |= GPIO_Pin;
+	}
+	else
+	{
+		GPIOx->ODR &= ~(uint32_t)GPIO_Pin;
+	}
+}
+
+void HAL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+	GPIOx->ODR ^= GPIO_Pin;
+}
+
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority)
+{
+	UNUSED(IRQn);
+	UNUSED(PreemptPriority);
+	UNUSED(SubPriority);
+}
+
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+	UNUSED(IRQn);
+}
+
+void HAL_NVIC_DisableIRQ(IRQn_Type IRQn)
+{
+	UNUSED(IRQn);
+}
+
+/**
+  * @brief  Millisecond tick of the simulated clock.
+  * @retval tick in ms
+  */
+uint32_t HAL_GetTick(void)
+{
+	return (uint32_t)(sim_mx25r_now_ns() / 1000000U);
+}
+
+/**
+  * @brief  Busy wait, moves the simulated clock.
+  * @param  Delay: delay in ms
+  * @retval None
+  */
+void HAL_Delay(uint32_t Delay)
+{
+	sim_mx25r_wait_until_ns(sim_mx25r_now_ns() + ((uint64_t)Delay * 1000000U));
+}
+
+/**
+  * @brief  Index of the simulated memory behind an OSPI handle.
+  * @param  hospi: OSPI handle
+  * @retval instance
+  */
+static uint32_t sim_ospi_instance(OSPI_HandleTypeDef *hospi)
+{
+	return (uint32_t)(hospi->Instance - sim_octospi_regs);
+}
+
+/**
+  * @brief  Number of lines of a phase.
+  * @param  mode: CCR value
+  * @param  shift: position of the xMODE field
+  * @retval 0, 1, 2, 4 or 8
+  */
+static uint32_t sim_ospi_lines(uint32_t mode, uint32_t shift)
+{
+	uint32_t field = (mode >> shift) & 0x7U;
+
+	return (field == 0) ? 0 : (1U << (field - 1));
+}
+
+/**
+  * @brief  Convert a HAL command to the phases seen by the memory.
+  * @param  cmd: HAL command
+  * @param  sim_cmd: phases of the transaction
+  * @retval None
+  */
+static void sim_ospi_convert(const OSPI_RegularCmdTypeDef *cmd, SIM_MX25R_CmdTypeDef *sim_cmd)
+{
+	sim_cmd->instruction       = cmd->Instruction;
+	sim_cmd->instruction_lines = sim_ospi_lines(cmd->InstructionMode, 0);
+	sim_cmd->address           = cmd->Address;
+	sim_cmd->address_lines     = sim_ospi_lines(cmd->AddressMode, 8);
+	sim_cmd->address_bytes     = ((cmd->AddressSize >> 12) & 0x3U) + 1;
+	sim_cmd->alternate         = cmd->AlternateBytes;
+	sim_cmd->alternate_lines   = sim_ospi_lines(cmd->AlternateBytesMode, 16);
+	sim_cmd->alternate_bytes   = ((cmd->AlternateBytesSize >> 20) & 0x3U) + 1;
+	sim_cmd->dummy_cycles      = cmd->DummyCycles;
+	sim_cmd->data_lines        = sim_ospi_lines(cmd->DataMode, 24);
+}
+
+/**
+  * @brief  Data phase of the configured command, CS# goes high once done.
+  * @param  hospi: OSPI handle
+  * @param  pData: data to send or destination of the data
+  * @param  write: 1 to send, 0 to read
+  * @retval HAL status
+  */
+static HAL_StatusTypeDef sim_ospi_data(OSPI_HandleTypeDef *hospi, uint8_t *pData, uint32_t write)
+{
+	uint32_t instance = sim_ospi_instance(hospi);
+	SIM_OSPI_StateTypeDef *state = &sim_ospi[instance];
+
+	if ((pData == NULL) || (hospi->State != HAL_OSPI_STATE_CMD_CFG))
+	{
+		hospi->ErrorCode = (pData == NULL) ? HAL_OSPI_ERROR_INVALID_PARAM : HAL_OSPI_ERROR_INVALID_SEQUENCE;
+		return HAL_ERROR;
+	}
+
+	hospi->pBuffPtr = pData;
+	hospi->XferSize = state->nb_data;
+
+	sim_mx25r_transfer(instance, pData, state->nb_data, write);
+	sim_mx25r_deselect(instance);
+
+	hospi->XferCount = 0;
+	hospi->State = HAL_OSPI_STATE_READY;
+
+	return HAL_OK;
+}
+
+/**
+  * @brief  Auto-polling of the configured command. The memory is read again only when
+  *         its status register changes.
+  * @param  hospi: OSPI handle
+  * @param  cfg: match configuration
+  * @param  deadline: simulated time of the timeout
+  * @retval HAL status
+  */
+static HAL_StatusTypeDef sim_ospi_poll(OSPI_HandleTypeDef *hospi, OSPI_AutoPollingTypeDef *cfg, uint64_t deadline)
+{
+	uint32_t instance = sim_ospi_instance(hospi);
+	SIM_OSPI_StateTypeDef *state = &sim_ospi[instance];
+	uint8_t status[4];
+	uint32_t value, i, size = state->nb_data;
+	uint64_t next;
+
+	if ((hospi->State != HAL_OSPI_STATE_CMD_CFG) || (size == 0) || (size > sizeof(status)))
+	{
+		hospi->ErrorCode = HAL_OSPI_ERROR_INVALID_SEQUENCE;
+		return HAL_ERROR;
+	}
+
+	hospi->State = HAL_OSPI_STATE_BUSY_AUTO_POLLING;
+
+	while (1)
+	{
+		sim_mx25r_transfer(instance, status, size, 0);
+		sim_mx25r_deselect(instance);
+
+		for (value = 0, i = 0; i < size; i++)
+		{
+			value |= (uint32_t)status[i] << (8 * i);
+		}
+
+		if (cfg->MatchMode == HAL_OSPI_MATCH_MODE_AND)
+		{
+			if ((value & cfg->Mask) == (cfg->Match & cfg->Mask))
+			{
+				break;
+			}
+		}
+		else if (((~(value ^ cfg->Match)) & cfg->Mask) != 0)
+		{
+			break;
+		}
+
+		/* Nothing changes before the next event of the memory */
+		next = sim_mx25r_next_event_ns(instance);
+		if ((next == UINT64_MAX) || (next > deadline))
+		{
+			if (deadline != UINT64_MAX)
+			{
+				sim_mx25r_wait_until_ns(deadline);
+			}
+			hospi->ErrorCode = HAL_OSPI_ERROR_TIMEOUT;
+			hospi->State = HAL_OSPI_STATE_READY;
+			return HAL_TIMEOUT;
+		}
+
+		sim_mx25r_wait_until_ns(next);
+		sim_mx25r_select(instance, &state->cmd);
+	}
+
+	hospi->State = HAL_OSPI_STATE_READY;
+
+	return HAL_OK;
+}
@@ -1,196 +1,282 @@
 #include "mx25r6435f_driver.h"
 
-#define OSPI_QUAD_DISABLE       0x0
-#define OSPI_QUAD_ENABLE        0x1
-#define OSPI_HIGH_PERF_DISABLE  0x0
-#define OSPI_HIGH_PERF_ENABLE   0x1
+/* CCR phase settings of the MX25R6435F commands, all SDR with an 8-bit instruction and a 24-bit address */
+#define OSPI_CCR_INST           (HAL_OSPI_INSTRUCTION_1_LINE | HAL_OSPI_INSTRUCTION_8_BITS)
+#define OSPI_CCR_ADDR_1         (HAL_OSPI_ADDRESS_1_LINE | HAL_OSPI_ADDRESS_24_BITS)
+#define OSPI_CCR_ADDR_2         (HAL_OSPI_ADDRESS_2_LINES | HAL_OSPI_ADDRESS_24_BITS)
+#define OSPI_CCR_ADDR_4         (HAL_OSPI_ADDRESS_4_LINES | HAL_OSPI_ADDRESS_24_BITS)
+#define OSPI_CCR_ALT_4          (HAL_OSPI_ALTERNATE_BYTES_4_LINES | HAL_OSPI_ALTERNATE_BYTES_8_BITS)
+#define OSPI_CCR_DATA_1         HAL_OSPI_DATA_1_LINE
+#define OSPI_CCR_DATA_2         HAL_OSPI_DATA_2_LINES
+#define OSPI_CCR_DATA_4         HAL_OSPI_DATA_4_LINES
+
+/* index of the commands in OSPI_CmdTable */
+typedef enum
+{
+	OSPI_CMD_READ = 0,
+	OSPI_CMD_FAST_READ,
+	OSPI_CMD_DUAL_OUT_READ,
+	OSPI_CMD_DUAL_INOUT_READ,
+	OSPI_CMD_QUAD_OUT_READ,
+	OSPI_CMD_QUAD_INOUT_READ,
+	OSPI_CMD_PAGE_PROG,
+	OSPI_CMD_QUAD_PAGE_PROG,
+	OSPI_CMD_SECTOR_ERASE,
+	OSPI_CMD_SUBBLOCK_ERASE,
+	OSPI_CMD_BLOCK_ERASE,
+	OSPI_CMD_CHIP_ERASE,
+	OSPI_CMD_PROG_ERASE_RESUME,
+	OSPI_CMD_PROG_ERASE_SUSPEND,
+	OSPI_CMD_READ_ID,
+	OSPI_CMD_READ_ELECTRONIC_ID,
+	OSPI_CMD_READ_ELEC_MANUFACTURER_DEVICE_ID,
+	OSPI_CMD_READ_SERIAL_FLASH_DISCO_PARAM,
+	OSPI_CMD_WRITE_ENABLE,
+	OSPI_CMD_WRITE_DISABLE,
+	OSPI_CMD_READ_STATUS_REG,
+	OSPI_CMD_READ_CFG_REG,
+	OSPI_CMD_WRITE_STATUS_CFG_REG,
+	OSPI_CMD_READ_SEC_REG,
+	OSPI_CMD_WRITE_SEC_REG,
+	OSPI_CMD_DEEP_POWER_DOWN,
+	OSPI_CMD_SET_BURST_LENGTH,
+	OSPI_CMD_ENTER_SECURED_OTP,
+	OSPI_CMD_EXIT_SECURED_OTP,
+	OSPI_CMD_NO_OPERATION,
+	OSPI_CMD_RESET_ENABLE,
+	OSPI_CMD_RESET_MEMORY,
+	OSPI_CMD_RELEASE_READ_ENHANCED,
+	OSPI_CMD_COUNT
+} OSPI_CmdIdTypeDef;
+
+/* everything but the address and the data length of a command, in the OctoSPI register layout */
+typedef struct
+{
+	uint32_t ccr;
+	uint8_t  instruction;
+	uint8_t  dummy_cycles;
+	uint8_t  alternate;
+} OSPI_CmdDescTypeDef;
 
+static const OSPI_CmdDescTypeDef OSPI_CmdTable[OSPI_CMD_COUNT] =
+{
+	[OSPI_CMD_READ]                             = { OSPI_CCR_INST | OSPI_CCR_ADDR_1 | OSPI_CCR_DATA_1, READ_CMD, 0, 0 },
+	[OSPI_CMD_FAST_READ]                        = { OSPI_CCR_INST | OSPI_CCR_ADDR_1 | OSPI_CCR_DATA_1, FAST_READ_CMD, MX25R6435F_DUMMY_CYCLES_READ, 0 },
+	[OSPI_CMD_DUAL_OUT_READ]                    = { OSPI_CCR_INST | OSPI_CCR_ADDR_1 | OSPI_CCR_DATA_2, DUAL_OUT_READ_CMD, MX25R6435F_DUMMY_CYCLES_READ, 0 },
+	[OSPI_CMD_DUAL_INOUT_READ]                  = { OSPI_CCR_INST | OSPI_CCR_ADDR_2 | OSPI_CCR_DATA_2, DUAL_INOUT_READ_CMD, MX25R6435F_DUMMY_CYCLES_READ_DUAL, 0 },
+	[OSPI_CMD_QUAD_OUT_READ]                    = { OSPI_CCR_INST | OSPI_CCR_ADDR_1 | OSPI_CCR_DATA_4, QUAD_OUT_READ_CMD, MX25R6435F_DUMMY_CYCLES_READ, 0 },
+	[OSPI_CMD_QUAD_INOUT_READ]                  = { OSPI_CCR_INST | OSPI_CCR_ADDR_4 | OSPI_CCR_ALT_4 | OSPI_CCR_DATA_4, QUAD_INOUT_READ_CMD, MX25R6435F_DUMMY_CYCLES_READ_QUAD, MX25R6435F_ALT_BYTES_NO_PE_MODE },
+	[OSPI_CMD_PAGE_PROG]                        = { OSPI_CCR_INST | OSPI_CCR_ADDR_1 | OSPI_CCR_DATA_1, PAGE_PROG_CMD, 0, 0 },
+	[OSPI_CMD_QUAD_PAGE_PROG]                   = { OSPI_CCR_INST | OSPI_CCR_ADDR_4 | OSPI_CCR_DATA_4, QUAD_PAGE_PROG_CMD, 0, 0 },
+	[OSPI_CMD_SECTOR_ERASE]                     = { OSPI_CCR_INST | OSPI_CCR_ADDR_1, SECTOR_ERASE_CMD, 0, 0 },
+	[OSPI_CMD_SUBBLOCK_ERASE]                   = { OSPI_CCR_INST | OSPI_CCR_ADDR_1, SUBBLOCK_ERASE_CMD, 0, 0 },
+	[OSPI_CMD_BLOCK_ERASE]                      = { OSPI_CCR_INST | OSPI_CCR_ADDR_1, BLOCK_ERASE_CMD, 0, 0 },
+	[OSPI_CMD_CHIP_ERASE]                       = { OSPI_CCR_INST, CHIP_ERASE_CMD, 0, 0 },
+	[OSPI_CMD_PROG_ERASE_RESUME]                = { OSPI_CCR_INST, PROG_ERASE_RESUME_CMD, 0, 0 },
+	[OSPI_CMD_PROG_ERASE_SUSPEND]               = { OSPI_CCR_INST, PROG_ERASE_SUSPEND_CMD, 0, 0 },
+	[OSPI_CMD_READ_ID]                          = { OSPI_CCR_INST | OSPI_CCR_DATA_1, READ_ID_CMD, 0, 0 },
+	[OSPI_CMD_READ_ELECTRONIC_ID]               = { OSPI_CCR_INST | OSPI_CCR_DATA_1, READ_ELECTRONIC_ID_CMD, 24, 0 },
+	[OSPI_CMD_READ_ELEC_MANUFACTURER_DEVICE_ID] = { OSPI_CCR_INST | OSPI_CCR_ADDR_1 | OSPI_CCR_DATA_1, READ_ELEC_MANUFACTURER_DEVICE_ID_CMD, 0, 0 },
+	[OSPI_CMD_READ_SERIAL_FLASH_DISCO_PARAM]    = { OSPI_CCR_INST | OSPI_CCR_ADDR_1 | OSPI_CCR_DATA_1, READ_SERIAL_FLASH_DISCO_PARAM_CMD, 8, 0 },
+	[OSPI_CMD_WRITE_ENABLE]                     = { OSPI_CCR_INST, WRITE_ENABLE_CMD, 0, 0 },
+	[OSPI_CMD_WRITE_DISABLE]                    = { OSPI_CCR_INST, WRITE_DISABLE_CMD, 0, 0 },
+	[OSPI_CMD_READ_STATUS_REG]                  = { OSPI_CCR_INST | OSPI_CCR_DATA_1, READ_STATUS_REG_CMD, 0, 0 },
+	[OSPI_CMD_READ_CFG_REG]                     = { OSPI_CCR_INST | OSPI_CCR_DATA_1, READ_CFG_REG_CMD, 0, 0 },
+	[OSPI_CMD_WRITE_STATUS_CFG_REG]             = { OSPI_CCR_INST | OSPI_CCR_DATA_1, WRITE_STATUS_CFG_REG_CMD, 0, 0 },
+	[OSPI_CMD_READ_SEC_REG]                     = { OSPI_CCR_INST | OSPI_CCR_DATA_1, READ_SEC_REG_CMD, 0, 0 },
+	[OSPI_CMD_WRITE_SEC_REG]                    = { OSPI_CCR_INST, WRITE_SEC_REG_CMD, 0, 0 },
+	[OSPI_CMD_DEEP_POWER_DOWN]                  = { OSPI_CCR_INST, DEEP_POWER_DOWN_CMD, 0, 0 },
+	[OSPI_CMD_SET_BURST_LENGTH]                 = { OSPI_CCR_INST | OSPI_CCR_DATA_1, SET_BURST_LENGTH_CMD, 0, 0 },
+	[OSPI_CMD_ENTER_SECURED_OTP]                = { OSPI_CCR_INST, ENTER_SECURED_OTP_CMD, 0, 0 },
+	[OSPI_CMD_EXIT_SECURED_OTP]                 = { OSPI_CCR_INST, EXIT_SECURED_OTP_CMD, 0, 0 },
+	[OSPI_CMD_NO_OPERATION]                     = { OSPI_CCR_INST, NO_OPERATION_CMD, 0, 0 },
+	[OSPI_CMD_RESET_ENABLE]                     = { OSPI_CCR_INST, RESET_ENABLE_CMD, 0, 0 },
+	[OSPI_CMD_RESET_MEMORY]                     = { OSPI_CCR_INST, RESET_MEMORY_CMD, 0, 0 },
+	[OSPI_CMD_RELEASE_READ_ENHANCED]            = { OSPI_CCR_INST, RELEASE_READ_ENHANCED_CMD, 0, 0 },
+};
+
+static void OSPI_CmdFill(OSPI_CmdIdTypeDef id, uint32_t Address, uint32_t NbData, OSPI_RegularCmdTypeDef* sCommand);
+static uint8_t OSPI_IssueCmd(OSPI_HandleTypeDef* hxspi, OSPI_CmdIdTypeDef id, uint32_t Address, uint32_t NbData);
 static uint8_t OSPI_WriteEnable(OSPI_HandleTypeDef* hxspi);
 static uint8_t OSPI_AutoPollingMemReady(OSPI_HandleTypeDef* hxspi, uint32_t Timeout);
-static uint8_t OSPI_QuadMode(OSPI_HandleTypeDef* hxspi, uint8_t Operation);
-static uint8_t OSPI_HighPerfMode(OSPI_HandleTypeDef* hxspi, uint8_t Operation);
+static uint8_t OSPI_ConfigureMemory(OSPI_HandleTypeDef* hxspi);
 static uint8_t OSPI_ResetMemory(OSPI_HandleTypeDef* hxspi);
 
 
-static uint8_t OSPI_WriteEnable(OSPI_HandleTypeDef* hxspi)
+/**
+  * @brief  Fill a HAL regular command from the command table.
+  * @param  id       : command index in OSPI_CmdTable
+  * @param  Address  : address phase value, unused if the command has no address
+  * @param  NbData   : number of data bytes, unused if the command has no data phase
+  * @param  sCommand : HAL command to fill
+  * @retval None
+  */
+static void OSPI_CmdFill(OSPI_CmdIdTypeDef id, uint32_t Address, uint32_t NbData, OSPI_RegularCmdTypeDef* sCommand)
 {
-	OSPI_RegularCmdTypeDef sCommand;
-	OSPI_AutoPollingTypeDef sConfig;
-
-	/* Enable write operations */
-	sCommand.OperationType      = HAL_OSPI_OPTYPE_COMMON_CFG;
-	sCommand.FlashId            = HAL_OSPI_FLASH_ID_1;
-	sCommand.Instruction        = WRITE_ENABLE_CMD;
-	sCommand.InstructionMode    = HAL_OSPI_INSTRUCTION_1_LINE;
-	sCommand.InstructionSize    = HAL_OSPI_INSTRUCTION_8_BITS;
-	sCommand.InstructionDtrMode = HAL_OSPI_INSTRUCTION_DTR_DISABLE;
-	sCommand.AddressMode        = HAL_OSPI_ADDRESS_NONE;
-	sCommand.AlternateBytesMode = HAL_OSPI_ALTERNATE_BYTES_NONE;
-	sCommand.DataMode           = HAL_OSPI_DATA_NONE;
-	sCommand.DummyCycles        = 0;
-	sCommand.DQSMode            = HAL_OSPI_DQS_DISABLE;
-	sCommand.SIOOMode           = HAL_OSPI_SIOO_INST_EVERY_CMD;
-
-	if (HAL_OSPI_Command(hxspi, &sCommand, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
-	{
-		return OSPI_ERROR;
-	}
-
-	/* Configure automatic polling mode to wait for write enabling */
-	sConfig.Match         = MX25R6435F_SR_WEL;
-	sConfig.Mask          = MX25R6435F_SR_WEL;
-	sConfig.MatchMode     = HAL_OSPI_MATCH_MODE_AND;
-	sConfig.Interval      = 0x10;
-	sConfig.AutomaticStop = HAL_OSPI_AUTOMATIC_STOP_ENABLE;
-
-	sCommand.Instruction  = READ_STATUS_REG_CMD;
-	sCommand.DataMode     = HAL_OSPI_DATA_1_LINE;
-	sCommand.NbData       = 1;
-	sCommand.DataDtrMode  = HAL_OSPI_DATA_DTR_DISABLE;
-
-	if (HAL_OSPI_Command(hxspi, &sCommand, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
-	{
-		return OSPI_ERROR;
-	}
-
-	if (HAL_OSPI_AutoPolling(hxspi, &sConfig, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
-	{
-		return OSPI_ERROR;
-	}
-
-	return OSPI_OK;
+	const OSPI_CmdDescTypeDef *desc = &OSPI_CmdTable[id];
+
+	sCommand->OperationType         = HAL_OSPI_OPTYPE_COMMON_CFG;
+	sCommand->FlashId               = HAL_OSPI_FLASH_ID_1;
+	sCommand->Instruction           = desc->instruction;
+	sCommand->InstructionMode       = desc->ccr & OCTOSPI_CCR_IMODE;
+	sCommand->InstructionSize       = desc->ccr & OCTOSPI_CCR_ISIZE;
+	sCommand->InstructionDtrMode    = HAL_OSPI_INSTRUCTION_DTR_DISABLE;
+	sCommand->Address               = Address;
+	sCommand->AddressMode           = desc->ccr & OCTOSPI_CCR_ADMODE;
+	sCommand->AddressSize           = desc->ccr & OCTOSPI_CCR_ADSIZE;
+	sCommand->AddressDtrMode        = HAL_OSPI_ADDRESS_DTR_DISABLE;
+	sCommand->AlternateBytes        = desc->alternate;
+	sCommand->AlternateBytesMode    = desc->ccr & OCTOSPI_CCR_ABMODE;
+	sCommand->AlternateBytesSize    = desc->ccr & OCTOSPI_CCR_ABSIZE;
+	sCommand->AlternateBytesDtrMode = HAL_OSPI_ALTERNATE_BYTES_DTR_DISABLE;
+	sCommand->DataMode              = desc->ccr & OCTOSPI_CCR_DMODE;
+	sCommand->NbData                = NbData;
+	sCommand->DataDtrMode           = HAL_OSPI_DATA_DTR_DISABLE;
+	sCommand->DummyCycles           = desc->dummy_cycles;
+	sCommand->DQSMode               = HAL_OSPI_DQS_DISABLE;
+	sCommand->SIOOMode              = desc->ccr & OCTOSPI_CCR_SIOO;
 }
 
 /**
-  * @brief  This function read the SR of the memory and wait the EOP.
-  * @param  hxspi   : QSPI handle
-  * @param  Timeout : Timeout for auto-polling
-  * @retval None
+  * @brief  Issue a command of the command table in indirect mode.
+  *         Commands with a data phase are followed by a HAL transfer or auto-polling call,
+  *         the others are complete on return.
+  * @param  hxspi   : OSPI handle
+  * @param  id      : command index in OSPI_CmdTable
+  * @param  Address : address phase value, unused if the command has no address
+  * @param  NbData  : number of data bytes, unused if the command has no data phase
+  * @retval OSPI memory status
   */
-static uint8_t OSPI_AutoPollingMemReady(OSPI_HandleTypeDef* hxspi, uint32_t Timeout)
+static uint8_t OSPI_IssueCmd(OSPI_HandleTypeDef* hxspi, OSPI_CmdIdTypeDef id, uint32_t Address, uint32_t NbData)
 {
-	OSPI_RegularCmdTypeDef sCommand;
-	OSPI_AutoPollingTypeDef sConfig;
-
-	/* Configure automatic polling mode to wait for memory ready */
-	sCommand.OperationType      = HAL_OSPI_OPTYPE_COMMON_CFG;
-	sCommand.FlashId            = HAL_OSPI_FLASH_ID_1;
-	sCommand.Instruction        = READ_STATUS_REG_CMD;
-	sCommand.InstructionMode    = HAL_OSPI_INSTRUCTION_1_LINE;
-	sCommand.InstructionSize    = HAL_OSPI_INSTRUCTION_8_BITS;
-	sCommand.InstructionDtrMode = HAL_OSPI_INSTRUCTION_DTR_DISABLE;
-	sCommand.AddressMode        = HAL_OSPI_ADDRESS_NONE;
-	sCommand.AlternateBytesMode = HAL_OSPI_ALTERNATE_BYTES_NONE;
-	sCommand.DataMode           = HAL_OSPI_DATA_1_LINE;
-	sCommand.NbData             = 1;
-	sCommand.DataDtrMode        = HAL_OSPI_DATA_DTR_DISABLE;
-	sCommand.DummyCycles        = 0;
-	sCommand.DQSMode            = HAL_OSPI_DQS_DISABLE;
-	sCommand.SIOOMode           = HAL_OSPI_SIOO_INST_EVERY_CMD;
-
-	sConfig.Match         = 0;
-	sConfig.Mask          = MX25R6435F_SR_WIP;
-	sConfig.MatchMode     = HAL_OSPI_MATCH_MODE_AND;
-	sConfig.Interval      = 0x10;
-	sConfig.AutomaticStop = HAL_OSPI_AUTOMATIC_STOP_ENABLE;
+#if (MX25R6435F_DIRECT_CMD == 1)
+	const OSPI_CmdDescTypeDef *desc = &OSPI_CmdTable[id];
+	OCTOSPI_TypeDef *regs = hxspi->Instance;
+	uint32_t tickstart = HAL_GetTick();
 
-	if (HAL_OSPI_Command(hxspi, &sCommand, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+	if (hxspi->State != HAL_OSPI_STATE_READY)
 	{
 		return OSPI_ERROR;
 	}
 
-	if (HAL_OSPI_AutoPolling(hxspi, &sConfig, Timeout) != HAL_OK)
+	/* Wait till the previous command is over */
+	while ((regs->SR & OCTOSPI_SR_BUSY) != 0)
 	{
-		return OSPI_ERROR;
+		if ((HAL_GetTick() - tickstart) > HAL_OSPI_TIMEOUT_DEFAULT_VALUE)
+		{
+			return OSPI_ERROR;
+		}
 	}
 
-	return OSPI_OK;
-}
-
-/**
-  * @brief  This function enables/disables the Quad mode of the memory.
-  * @param  hxspi     : OSPI handle
-  * @param  Operation : OSPI_QUAD_ENABLE or OSPI_QUAD_DISABLE mode
-  * @retval None
-  */
-static uint8_t OSPI_QuadMode(OSPI_HandleTypeDef* hxspi, uint8_t Operation)
-{
-	uint8_t reg;
-	OSPI_RegularCmdTypeDef sCommand;
-
-	/* Read status register */
-	sCommand.OperationType      = HAL_OSPI_OPTYPE_COMMON_CFG;
-	sCommand.FlashId            = HAL_OSPI_FLASH_ID_1;
-	sCommand.Instruction        = READ_STATUS_REG_CMD;
-	sCommand.InstructionMode    = HAL_OSPI_INSTRUCTION_1_LINE;
-	sCommand.InstructionSize    = HAL_OSPI_INSTRUCTION_8_BITS;
-	sCommand.InstructionDtrMode = HAL_OSPI_INSTRUCTION_DTR_DISABLE;
-	sCommand.AddressMode        = HAL_OSPI_ADDRESS_NONE;
-	sCommand.AlternateBytesMode = HAL_OSPI_ALTERNATE_BYTES_NONE;
-	sCommand.DataMode           = HAL_OSPI_DATA_1_LINE;
-	sCommand.DataDtrMode        = HAL_OSPI_DATA_DTR_DISABLE;
-	sCommand.DummyCycles        = 0;
-	sCommand.NbData             = 1;
-	sCommand.DQSMode            = HAL_OSPI_DQS_DISABLE;
-	sCommand.SIOOMode           = HAL_OSPI_SIOO_INST_EVERY_CMD;
+	/* Same register sequence as HAL_OSPI_Command, the command starts on the last IR/AR write */
+	CLEAR_BIT(regs->CR, OCTOSPI_CR_FMODE);
 
-	if (HAL_OSPI_Command(hxspi, &sCommand, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+	if ((desc->ccr & OCTOSPI_CCR_DMODE) != 0)
 	{
-		return OSPI_ERROR;
+		regs->DLR = NbData - 1;
 	}
 
-	if (HAL_OSPI_Receive(hxspi, &reg, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+	MODIFY_REG(regs->TCR, OCTOSPI_TCR_DCYC, desc->dummy_cycles);
+
+	if ((desc->ccr & OCTOSPI_CCR_ABMODE) != 0)
 	{
-		return OSPI_ERROR;
+		regs->ABR = desc->alternate;
 	}
 
-	/* Enable write operations */
-	if (OSPI_WriteEnable(hxspi) != OSPI_OK)
+	regs->CCR = desc->ccr;
+	regs->IR  = desc->instruction;
+
+	if ((desc->ccr & OCTOSPI_CCR_ADMODE) != 0)
 	{
-		return OSPI_ERROR;
+		regs->AR = Address;
 	}
 
-	/* Activate/deactivate the Quad mode */
-	if (Operation == OSPI_QUAD_ENABLE)
+	if ((desc->ccr & OCTOSPI_CCR_DMODE) != 0)
 	{
-		SET_BIT(reg, MX25R6435F_SR_QE);
+		/* The data phase is started by the HAL transfer or auto-polling function */
+		hxspi->ErrorCode = HAL_OSPI_ERROR_NONE;
+		hxspi->State     = HAL_OSPI_STATE_CMD_CFG;
 	}
 	else
 	{
-		CLEAR_BIT(reg, MX25R6435F_SR_QE);
+		/* Wait for the end of the command */
+		while ((regs->SR & OCTOSPI_SR_TCF) == 0)
+		{
+			if ((HAL_GetTick() - tickstart) > HAL_OSPI_TIMEOUT_DEFAULT_VALUE)
+			{
+				return OSPI_ERROR;
+			}
+		}
+
+		regs->FCR = OCTOSPI_FCR_CTCF;
 	}
+#else
+	OSPI_RegularCmdTypeDef sCommand;
+
+	OSPI_CmdFill(id, Address, NbData, &sCommand);
 
-	sCommand.Instruction = WRITE_STATUS_CFG_REG_CMD;
 	if (HAL_OSPI_Command(hxspi, &sCommand, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
 	{
 		return OSPI_ERROR;
 	}
+#endif
+
+	return OSPI_OK;
+}
 
-	if (HAL_OSPI_Transmit(hxspi, &reg, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+static uint8_t OSPI_WriteEnable(OSPI_HandleTypeDef* hxspi)
+{
+	OSPI_AutoPollingTypeDef sConfig;
+
+	/* Enable write operations */
+	if (OSPI_IssueCmd(hxspi, OSPI_CMD_WRITE_ENABLE, 0, 0) != OSPI_OK)
 	{
 		return OSPI_ERROR;
 	}
 
-	/* Wait that memory is ready */
-	if (OSPI_AutoPollingMemReady(hxspi, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != OSPI_OK)
+	/* Configure automatic polling mode to wait for write enabling */
+	sConfig.Match         = MX25R6435F_SR_WEL;
+	sConfig.Mask          = MX25R6435F_SR_WEL;
+	sConfig.MatchMode     = HAL_OSPI_MATCH_MODE_AND;
+	sConfig.Interval      = 0x10;
+	sConfig.AutomaticStop = HAL_OSPI_AUTOMATIC_STOP_ENABLE;
+
+	if (OSPI_IssueCmd(hxspi, OSPI_CMD_READ_STATUS_REG, 0, 1) != OSPI_OK)
 	{
 		return OSPI_ERROR;
 	}
 
-	/* Check the configuration has been correctly done */
-	sCommand.Instruction = READ_STATUS_REG_CMD;
-	if (HAL_OSPI_Command(hxspi, &sCommand, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+	if (HAL_OSPI_AutoPolling(hxspi, &sConfig, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
 	{
 		return OSPI_ERROR;
 	}
 
-	if (HAL_OSPI_Receive(hxspi, &reg, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+	return OSPI_OK;
+}
+
+/**
+  * @brief  This function read the SR of the memory and wait the EOP.
+  * @param  hxspi   : QSPI handle
+  * @param  Timeout : Timeout for auto-polling
+  * @retval None
+  */
+static uint8_t OSPI_AutoPollingMemReady(OSPI_HandleTypeDef* hxspi, uint32_t Timeout)
+{
+	OSPI_AutoPollingTypeDef sConfig;
+
+	/* Configure automatic polling mode to wait for memory ready */
+	sConfig.Match         = 0;
+	sConfig.Mask          = MX25R6435F_SR_WIP;
+	sConfig.MatchMode     = HAL_OSPI_MATCH_MODE_AND;
+	sConfig.Interval      = 0x10;
+	sConfig.AutomaticStop = HAL_OSPI_AUTOMATIC_STOP_ENABLE;
+
+	if (OSPI_IssueCmd(hxspi, OSPI_CMD_READ_STATUS_REG, 0, 1) != OSPI_OK)
 	{
 		return OSPI_ERROR;
 	}
 
-	if ((((reg & MX25R6435F_SR_QE) == 0) && (Operation == OSPI_QUAD_ENABLE)) ||
-	  (((reg & MX25R6435F_SR_QE) != 0) && (Operation == OSPI_QUAD_DISABLE)))
+	if (HAL_OSPI_AutoPolling(hxspi, &sConfig, Timeout) != HAL_OK)
 	{
 		return OSPI_ERROR;
 	}
@@ -199,33 +285,18 @@ static uint8_t OSPI_QuadMode(OSPI_HandleTypeDef* hxspi, uint8_t Operation)
 }
 
 /**
-  * @brief  This function enables/disables the high performance mode of the memory.
-  * @param  hxspi     : QSPI handle
-  * @param  Operation : QSPI_HIGH_PERF_ENABLE or QSPI_HIGH_PERF_DISABLE high performance mode
+  * @brief  This function enables the Quad mode and the high performance mode of the memory.
+  *         Both are non-volatile: the registers are read once and only written, both bits
+  *         at once, when one of them is not set yet.
+  * @param  hxspi : OSPI handle
   * @retval None
   */
-static uint8_t OSPI_HighPerfMode(OSPI_HandleTypeDef* hxspi, uint8_t Operation)
+static uint8_t OSPI_ConfigureMemory(OSPI_HandleTypeDef* hxspi)
 {
 	uint8_t reg[3];
-	OSPI_RegularCmdTypeDef sCommand;
 
 	/* Read status register */
-	sCommand.OperationType      = HAL_OSPI_OPTYPE_COMMON_CFG;
-	sCommand.FlashId            = HAL_OSPI_FLASH_ID_1;
-	sCommand.Instruction        = READ_STATUS_REG_CMD;
-	sCommand.InstructionMode    = HAL_OSPI_INSTRUCTION_1_LINE;
-	sCommand.InstructionSize    = HAL_OSPI_INSTRUCTION_8_BITS;
-	sCommand.InstructionDtrMode = HAL_OSPI_INSTRUCTION_DTR_DISABLE;
-	sCommand.AddressMode        = HAL_OSPI_ADDRESS_NONE;
-	sCommand.AlternateBytesMode = HAL_OSPI_ALTERNATE_BYTES_NONE;
-	sCommand.DataMode           = HAL_OSPI_DATA_1_LINE;
-	sCommand.DataDtrMode        = HAL_OSPI_DATA_DTR_DISABLE;
-	sCommand.DummyCycles        = 0;
-	sCommand.NbData             = 1;
-	sCommand.DQSMode            = HAL_OSPI_DQS_DISABLE;
-	sCommand.SIOOMode           = HAL_OSPI_SIOO_INST_EVERY_CMD;
-
-	if (HAL_OSPI_Command(hxspi, &sCommand, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+	if (OSPI_IssueCmd(hxspi, OSPI_CMD_READ_STATUS_REG, 0, 1) != OSPI_OK)
 	{
 		return OSPI_ERROR;
 	}
@@ -236,10 +307,7 @@ static uint8_t OSPI_HighPerfMode(OSPI_HandleTypeDef* hxspi, uint8_t Operation)
 	}
 
 	/* Read configuration registers */
-	sCommand.Instruction = READ_CFG_REG_CMD;
-	sCommand.NbData      = 2;
-
-	if (HAL_OSPI_Command(hxspi, &sCommand, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+	if (OSPI_IssueCmd(hxspi, OSPI_CMD_READ_CFG_REG, 0, 2) != OSPI_OK)
 	{
 		return OSPI_ERROR;
 	}
@@ -249,26 +317,23 @@ static uint8_t OSPI_HighPerfMode(OSPI_HandleTypeDef* hxspi, uint8_t Operation)
 		return OSPI_ERROR;
 	}
 
-	/* Enable write operations */
-	if (OSPI_WriteEnable(hxspi) != OSPI_OK)
+	/* Nothing to write, the memory kept its configuration */
+	if ((READ_BIT(reg[0], MX25R6435F_SR_QE) != 0) && (READ_BIT(reg[2], MX25R6435F_CR2_LH_SWITCH) != 0))
 	{
-		return OSPI_ERROR;
+		return OSPI_OK;
 	}
 
-	/* Activate/deactivate the Quad mode */
-	if (Operation == OSPI_HIGH_PERF_ENABLE)
-	{
-		SET_BIT(reg[2], MX25R6435F_CR2_LH_SWITCH);
-	}
-	else
+	/* Enable write operations */
+	if (OSPI_WriteEnable(hxspi) != OSPI_OK)
 	{
-		CLEAR_BIT(reg[2], MX25R6435F_CR2_LH_SWITCH);
+		return OSPI_ERROR;
 	}
 
-	sCommand.Instruction = WRITE_STATUS_CFG_REG_CMD;
-	sCommand.NbData      = 3;
+	/* Activate the Quad mode and the high performance mode */
+	SET_BIT(reg[0], MX25R6435F_SR_QE);
+	SET_BIT(reg[2], MX25R6435F_CR2_LH_SWITCH);
 
-	if (HAL_OSPI_Command(hxspi, &sCommand, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+	if (OSPI_IssueCmd(hxspi, OSPI_CMD_WRITE_STATUS_CFG_REG, 0, 3) != OSPI_OK)
 	{
 		return OSPI_ERROR;
 	}
@@ -285,10 +350,7 @@ static uint8_t OSPI_HighPerfMode(OSPI_HandleTypeDef* hxspi, uint8_t Operation)
 	}
 
 	/* Check the configuration has been correctly done */
-	sCommand.Instruction = READ_CFG_REG_CMD;
-	sCommand.NbData      = 2;
-
-	if (HAL_OSPI_Command(hxspi, &sCommand, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+	if (OSPI_IssueCmd(hxspi, OSPI_CMD_READ_STATUS_REG, 0, 1) != OSPI_OK)
 	{
 		return OSPI_ERROR;
 	}
@@ -298,8 +360,17 @@ static uint8_t OSPI_HighPerfMode(OSPI_HandleTypeDef* hxspi, uint8_t Operation)
 		return OSPI_ERROR;
 	}
 
-	if ((((reg[1] & MX25R6435F_CR2_LH_SWITCH) == 0) && (Operation == OSPI_HIGH_PERF_ENABLE)) ||
-	  (((reg[1] & MX25R6435F_CR2_LH_SWITCH) != 0) && (Operation == OSPI_HIGH_PERF_DISABLE)))
+	if (OSPI_IssueCmd(hxspi, OSPI_CMD_READ_CFG_REG, 0, 2) != OSPI_OK)
+	{
+		return OSPI_ERROR;
+	}
+
+	if (HAL_OSPI_Receive(hxspi, &(reg[1]), HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+	{
+		return OSPI_ERROR;
+	}
+
+	if ((READ_BIT(reg[0], MX25R6435F_SR_QE) == 0) || (READ_BIT(reg[2], MX25R6435F_CR2_LH_SWITCH) == 0))
 	{
 		return OSPI_ERROR;
 	}
@@ -315,32 +386,14 @@ static uint8_t OSPI_HighPerfMode(OSPI_HandleTypeDef* hxspi, uint8_t Operation)
   */
 static uint8_t OSPI_ResetMemory(OSPI_HandleTypeDef* hxspi)
 {
-	OSPI_RegularCmdTypeDef sCommand;
-
-	/* Initialize the reset enable command */
-	sCommand.OperationType      = HAL_OSPI_OPTYPE_COMMON_CFG;
-	sCommand.FlashId            = HAL_OSPI_FLASH_ID_1;
-	sCommand.Instruction        = RESET_ENABLE_CMD;
-	sCommand.InstructionMode    = HAL_OSPI_INSTRUCTION_1_LINE;
-	sCommand.InstructionSize    = HAL_OSPI_INSTRUCTION_8_BITS;
-	sCommand.InstructionDtrMode = HAL_OSPI_INSTRUCTION_DTR_DISABLE;
-	sCommand.AddressMode        = HAL_OSPI_ADDRESS_NONE;
-	sCommand.AlternateBytesMode = HAL_OSPI_ALTERNATE_BYTES_NONE;
-	sCommand.DataMode           = HAL_OSPI_DATA_NONE;
-	sCommand.DummyCycles        = 0;
-	sCommand.DQSMode            = HAL_OSPI_DQS_DISABLE;
-	sCommand.SIOOMode           = HAL_OSPI_SIOO_INST_EVERY_CMD;
-
-
-	/* Send the command */
-	if (HAL_OSPI_Command(hxspi, &sCommand, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+	/* Send the reset enable command */
+	if (OSPI_IssueCmd(hxspi, OSPI_CMD_RESET_ENABLE, 0, 0) != OSPI_OK)
 	{
 		return OSPI_ERROR;
 	}
 
 	/* Send the reset memory command */
-	sCommand.Instruction = RESET_MEMORY_CMD;
-	if (HAL_OSPI_Command(hxspi, &sCommand, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+	if (OSPI_IssueCmd(hxspi, OSPI_CMD_RESET_MEMORY, 0, 0) != OSPI_OK)
 	{
 		return OSPI_ERROR;
 	}
@@ -370,14 +423,8 @@ uint8_t BSP_OSPI_Init(OSPI_HandleTypeDef* handle)
 		return OSPI_NOT_SUPPORTED;
 	}
 
-	/* QSPI quad enable */
-	if (OSPI_QuadMode(handle, OSPI_QUAD_ENABLE) != OSPI_OK)
-	{
-		return OSPI_ERROR;
-	}
-
-	/* High performance mode enable */
-	if (OSPI_HighPerfMode(handle, OSPI_HIGH_PERF_ENABLE) != OSPI_OK)
+	/* QSPI quad enable and high performance mode enable */
+	if (OSPI_ConfigureMemory(handle) != OSPI_OK)
 	{
 		return OSPI_ERROR;
 	}
@@ -411,32 +458,8 @@ uint8_t BSP_OSPI_DeInit(OSPI_HandleTypeDef* handle)
   */
 uint8_t BSP_OSPI_Read(OSPI_HandleTypeDef* handle, uint8_t* pData, uint32_t ReadAddr, uint32_t Size)
 {
-	OSPI_RegularCmdTypeDef sCommand;
-
-	/* Initialize the read command */
-	sCommand.OperationType         = HAL_OSPI_OPTYPE_COMMON_CFG;
-	sCommand.FlashId               = HAL_OSPI_FLASH_ID_1;
-	sCommand.Instruction           = QUAD_INOUT_READ_CMD;
-	sCommand.InstructionMode       = HAL_OSPI_INSTRUCTION_1_LINE;
-	sCommand.InstructionSize       = HAL_OSPI_INSTRUCTION_8_BITS;
-	sCommand.InstructionDtrMode    = HAL_OSPI_INSTRUCTION_DTR_DISABLE;
-	sCommand.Address               = ReadAddr;
-	sCommand.AddressMode           = HAL_OSPI_ADDRESS_4_LINES;
-	sCommand.AddressSize           = HAL_OSPI_ADDRESS_24_BITS;
-	sCommand.AddressDtrMode        = HAL_OSPI_ADDRESS_DTR_DISABLE;
-	sCommand.AlternateBytes        = MX25R6435F_ALT_BYTES_NO_PE_MODE;
-	sCommand.AlternateBytesMode    = HAL_OSPI_ALTERNATE_BYTES_4_LINES;
-	sCommand.AlternateBytesSize    = HAL_OSPI_ALTERNATE_BYTES_8_BITS;
-	sCommand.AlternateBytesDtrMode = HAL_OSPI_ALTERNATE_BYTES_DTR_DISABLE;
-	sCommand.DataMode              = HAL_OSPI_DATA_4_LINES;
-	sCommand.NbData                = Size;
-	sCommand.DataDtrMode           = HAL_OSPI_DATA_DTR_DISABLE;
-	sCommand.DummyCycles           = MX25R6435F_DUMMY_CYCLES_READ_QUAD;
-	sCommand.DQSMode               = HAL_OSPI_DQS_DISABLE;
-	sCommand.SIOOMode              = HAL_OSPI_SIOO_INST_EVERY_CMD;
-
 	/* Configure the command */
-	if (HAL_OSPI_Command(handle, &sCommand, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+	if (OSPI_IssueCmd(handle, OSPI_CMD_QUAD_INOUT_READ, ReadAddr, Size) != OSPI_OK)
 	{
 		return OSPI_ERROR;
 	}
@@ -462,7 +485,6 @@ uint8_t BSP_OSPI_Read(OSPI_HandleTypeDef* handle, uint8_t* pData, uint32_t ReadA
 uint8_t BSP_OSPI_Write(OSPI_HandleTypeDef* handle, uint8_t* pData, uint32_t WriteAddr, uint32_t Size)
 {
 	uint32_t end_addr, current_size, current_addr;
-	OSPI_RegularCmdTypeDef sCommand;
 
 	/* Calculation of the size between the write address and the end of the page */
 	current_size = MX25R6435F_PAGE_SIZE - (WriteAddr % MX25R6435F_PAGE_SIZE);
@@ -477,28 +499,8 @@ uint8_t BSP_OSPI_Write(OSPI_HandleTypeDef* handle, uint8_t* pData, uint32_t Writ
 	current_addr = WriteAddr;
 	end_addr = WriteAddr + Size;
 
-	/* Initialize the program command */
-	sCommand.OperationType      = HAL_OSPI_OPTYPE_COMMON_CFG;
-	sCommand.FlashId            = HAL_OSPI_FLASH_ID_1;
-	sCommand.Instruction        = QUAD_PAGE_PROG_CMD;
-	sCommand.InstructionMode    = HAL_OSPI_INSTRUCTION_1_LINE;
-	sCommand.InstructionSize    = HAL_OSPI_INSTRUCTION_8_BITS;
-	sCommand.InstructionDtrMode = HAL_OSPI_INSTRUCTION_DTR_DISABLE;
-	sCommand.AddressMode        = HAL_OSPI_ADDRESS_4_LINES;
-	sCommand.AddressSize        = HAL_OSPI_ADDRESS_24_BITS;
-	sCommand.AddressDtrMode     = HAL_OSPI_ADDRESS_DTR_DISABLE;
-	sCommand.AlternateBytesMode = HAL_OSPI_ALTERNATE_BYTES_NONE;
-	sCommand.DataMode           = HAL_OSPI_DATA_4_LINES;
-	sCommand.DataDtrMode        = HAL_OSPI_DATA_DTR_DISABLE;
-	sCommand.DummyCycles        = 0;
-	sCommand.DQSMode            = HAL_OSPI_DQS_DISABLE;
-	sCommand.SIOOMode           = HAL_OSPI_SIOO_INST_EVERY_CMD;
-
 	/* Perform the write page by page */
 	do {
-		sCommand.Address = current_addr;
-		sCommand.NbData  = current_size;
-
 		/* Enable write operations */
 		if (OSPI_WriteEnable(handle) != OSPI_OK)
 		{
@@ -506,7 +508,7 @@ uint8_t BSP_OSPI_Write(OSPI_HandleTypeDef* handle, uint8_t* pData, uint32_t Writ
 		}
 
 		/* Configure the command */
-		if (HAL_OSPI_Command(handle, &sCommand, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+		if (OSPI_IssueCmd(handle, OSPI_CMD_QUAD_PAGE_PROG, current_addr, current_size) != OSPI_OK)
 		{
 			return OSPI_ERROR;
 		}
@@ -540,25 +542,6 @@ uint8_t BSP_OSPI_Write(OSPI_HandleTypeDef* handle, uint8_t* pData, uint32_t Writ
   */
 uint8_t BSP_OSPI_Erase_Block(OSPI_HandleTypeDef* handle, uint32_t BlockAddress)
 {
-	OSPI_RegularCmdTypeDef sCommand;
-
-	/* Initialize the erase command */
-	sCommand.OperationType      = HAL_OSPI_OPTYPE_COMMON_CFG;
-	sCommand.FlashId            = HAL_OSPI_FLASH_ID_1;
-	sCommand.Instruction        = BLOCK_ERASE_CMD;
-	sCommand.InstructionMode    = HAL_OSPI_INSTRUCTION_1_LINE;
-	sCommand.InstructionSize    = HAL_OSPI_INSTRUCTION_8_BITS;
-	sCommand.InstructionDtrMode = HAL_OSPI_INSTRUCTION_DTR_DISABLE;
-	sCommand.Address            = BlockAddress;
-	sCommand.AddressMode        = HAL_OSPI_ADDRESS_1_LINE;
-	sCommand.AddressSize        = HAL_OSPI_ADDRESS_24_BITS;
-	sCommand.AddressDtrMode     = HAL_OSPI_ADDRESS_DTR_DISABLE;
-	sCommand.AlternateBytesMode = HAL_OSPI_ALTERNATE_BYTES_NONE;
-	sCommand.DataMode           = HAL_OSPI_DATA_NONE;
-	sCommand.DummyCycles        = 0;
-	sCommand.DQSMode            = HAL_OSPI_DQS_DISABLE;
-	sCommand.SIOOMode           = HAL_OSPI_SIOO_INST_EVERY_CMD;
-
 	/* Enable write operations */
 	if (OSPI_WriteEnable(handle) != OSPI_OK)
 	{
@@ -566,7 +549,7 @@ uint8_t BSP_OSPI_Erase_Block(OSPI_HandleTypeDef* handle, uint32_t BlockAddress)
 	}
 
 	/* Send the command */
-	if (HAL_OSPI_Command(handle, &sCommand, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+	if (OSPI_IssueCmd(handle, OSPI_CMD_BLOCK_ERASE, BlockAddress, 0) != OSPI_OK)
 	{
 		return OSPI_ERROR;
 	}
@@ -593,30 +576,11 @@ uint8_t BSP_OSPI_Erase_Block(OSPI_HandleTypeDef* handle, uint32_t BlockAddress)
   */
 uint8_t BSP_OSPI_Erase_Sector(OSPI_HandleTypeDef* handle, uint32_t Sector)
 {
-	OSPI_RegularCmdTypeDef sCommand;
-
 	if (Sector >= (uint32_t)(MX25R6435F_FLASH_SIZE / MX25R6435F_SECTOR_SIZE))
 	{
 		return OSPI_ERROR;
 	}
 
-	/* Initialize the erase command */
-	sCommand.OperationType      = HAL_OSPI_OPTYPE_COMMON_CFG;
-	sCommand.FlashId            = HAL_OSPI_FLASH_ID_1;
-	sCommand.Instruction        = SECTOR_ERASE_CMD;
-	sCommand.InstructionMode    = HAL_OSPI_INSTRUCTION_1_LINE;
-	sCommand.InstructionSize    = HAL_OSPI_INSTRUCTION_8_BITS;
-	sCommand.InstructionDtrMode = HAL_OSPI_INSTRUCTION_DTR_DISABLE;
-	sCommand.Address            = (Sector * MX25R6435F_SECTOR_SIZE);
-	sCommand.AddressMode        = HAL_OSPI_ADDRESS_1_LINE;
-	sCommand.AddressSize        = HAL_OSPI_ADDRESS_24_BITS;
-	sCommand.AddressDtrMode     = HAL_OSPI_ADDRESS_DTR_DISABLE;
-	sCommand.AlternateBytesMode = HAL_OSPI_ALTERNATE_BYTES_NONE;
-	sCommand.DataMode           = HAL_OSPI_DATA_NONE;
-	sCommand.DummyCycles        = 0;
-	sCommand.DQSMode            = HAL_OSPI_DQS_DISABLE;
-	sCommand.SIOOMode           = HAL_OSPI_SIOO_INST_EVERY_CMD;
-
 	/* Enable write operations */
 	if (OSPI_WriteEnable(handle) != OSPI_OK)
 	{
@@ -624,7 +588,7 @@ uint8_t BSP_OSPI_Erase_Sector(OSPI_HandleTypeDef* handle, uint32_t Sector)
 	}
 
 	/* Send the command */
-	if (HAL_OSPI_Command(handle, &sCommand, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+	if (OSPI_IssueCmd(handle, OSPI_CMD_SECTOR_ERASE, (Sector * MX25R6435F_SECTOR_SIZE), 0) != OSPI_OK)
 	{
 		return OSPI_ERROR;
 	}
@@ -639,22 +603,6 @@ uint8_t BSP_OSPI_Erase_Sector(OSPI_HandleTypeDef* handle, uint32_t Sector)
   */
 uint8_t BSP_OSPI_Erase_Chip(OSPI_HandleTypeDef* handle)
 {
-	OSPI_RegularCmdTypeDef sCommand;
-
-	/* Initialize the erase command */
-	sCommand.OperationType      = HAL_OSPI_OPTYPE_COMMON_CFG;
-	sCommand.FlashId            = HAL_OSPI_FLASH_ID_1;
-	sCommand.Instruction        = CHIP_ERASE_CMD;
-	sCommand.InstructionMode    = HAL_OSPI_INSTRUCTION_1_LINE;
-	sCommand.InstructionSize    = HAL_OSPI_INSTRUCTION_8_BITS;
-	sCommand.InstructionDtrMode = HAL_OSPI_INSTRUCTION_DTR_DISABLE;
-	sCommand.AddressMode        = HAL_OSPI_ADDRESS_NONE;
-	sCommand.AlternateBytesMode = HAL_OSPI_ALTERNATE_BYTES_NONE;
-	sCommand.DataMode           = HAL_OSPI_DATA_NONE;
-	sCommand.DummyCycles        = 0;
-	sCommand.DQSMode            = HAL_OSPI_DQS_DISABLE;
-	sCommand.SIOOMode           = HAL_OSPI_SIOO_INST_EVERY_CMD;
-
 	/* Enable write operations */
 	if (OSPI_WriteEnable(handle) != OSPI_OK)
 	{
@@ -662,7 +610,7 @@ uint8_t BSP_OSPI_Erase_Chip(OSPI_HandleTypeDef* handle)
 	}
 
 	/* Send the command */
-	if (HAL_OSPI_Command(handle, &sCommand, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+	if (OSPI_IssueCmd(handle, OSPI_CMD_CHIP_ERASE, 0, 0) != OSPI_OK)
 	{
 		return OSPI_ERROR;
 	}
@@ -684,26 +632,9 @@ uint8_t BSP_OSPI_Erase_Chip(OSPI_HandleTypeDef* handle)
 uint8_t BSP_OSPI_GetStatus(OSPI_HandleTypeDef* handle)
 {
 	uint8_t reg;
-	OSPI_RegularCmdTypeDef sCommand;
-
-	/* Initialize the read security register command */
-	sCommand.OperationType      = HAL_OSPI_OPTYPE_COMMON_CFG;
-	sCommand.FlashId            = HAL_OSPI_FLASH_ID_1;
-	sCommand.Instruction        = READ_SEC_REG_CMD;
-	sCommand.InstructionMode    = HAL_OSPI_INSTRUCTION_1_LINE;
-	sCommand.InstructionSize    = HAL_OSPI_INSTRUCTION_8_BITS;
-	sCommand.InstructionDtrMode = HAL_OSPI_INSTRUCTION_DTR_DISABLE;
-	sCommand.AddressMode        = HAL_OSPI_ADDRESS_NONE;
-	sCommand.AlternateBytesMode = HAL_OSPI_ALTERNATE_BYTES_NONE;
-	sCommand.DataMode           = HAL_OSPI_DATA_1_LINE;
-	sCommand.NbData             = 1;
-	sCommand.DataDtrMode        = HAL_OSPI_DATA_DTR_DISABLE;
-	sCommand.DummyCycles        = 0;
-	sCommand.DQSMode            = HAL_OSPI_DQS_DISABLE;
-	sCommand.SIOOMode           = HAL_OSPI_SIOO_INST_EVERY_CMD;
 
-	/* Configure the command */
-	if (HAL_OSPI_Command(handle, &sCommand, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+	/* Read the security register */
+	if (OSPI_IssueCmd(handle, OSPI_CMD_READ_SEC_REG, 0, 1) != OSPI_OK)
 	{
 		return OSPI_ERROR;
 	}
@@ -724,11 +655,8 @@ uint8_t BSP_OSPI_GetStatus(OSPI_HandleTypeDef* handle)
 		return OSPI_SUSPENDED;
 	}
 
-	/* Initialize the read status register command */
-	sCommand.Instruction = READ_STATUS_REG_CMD;
-
-	/* Configure the command */
-	if (HAL_OSPI_Command(handle, &sCommand, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+	/* Read the status register */
+	if (OSPI_IssueCmd(handle, OSPI_CMD_READ_STATUS_REG, 0, 1) != OSPI_OK)
 	{
 		return OSPI_ERROR;
 	}
@@ -778,25 +706,9 @@ uint8_t BSP_OSPI_EnableMemoryMappedMode(OSPI_HandleTypeDef* handle)
 	OSPI_RegularCmdTypeDef      sCommand;
 	OSPI_MemoryMappedTypeDef	sMemMappedCfg;
 
-	/* Configure the command for the read instruction */
-	sCommand.OperationType         = HAL_OSPI_OPTYPE_READ_CFG;
-	sCommand.FlashId               = HAL_OSPI_FLASH_ID_1;
-	sCommand.Instruction           = QUAD_INOUT_READ_CMD;
-	sCommand.InstructionMode       = HAL_OSPI_INSTRUCTION_1_LINE;
-	sCommand.InstructionSize       = HAL_OSPI_INSTRUCTION_8_BITS;
-	sCommand.InstructionDtrMode    = HAL_OSPI_INSTRUCTION_DTR_DISABLE;
-	sCommand.AddressMode           = HAL_OSPI_ADDRESS_4_LINES;
-	sCommand.AddressSize           = HAL_OSPI_ADDRESS_24_BITS;
-	sCommand.AddressDtrMode        = HAL_OSPI_ADDRESS_DTR_DISABLE;
-	sCommand.AlternateBytes        = MX25R6435F_ALT_BYTES_NO_PE_MODE;
-	sCommand.AlternateBytesMode    = HAL_OSPI_ALTERNATE_BYTES_4_LINES;
-	sCommand.AlternateBytesSize    = HAL_OSPI_ALTERNATE_BYTES_8_BITS;
-	sCommand.AlternateBytesDtrMode = HAL_OSPI_ALTERNATE_BYTES_DTR_DISABLE;
-	sCommand.DataMode              = HAL_OSPI_DATA_4_LINES;
-	sCommand.DataDtrMode           = HAL_OSPI_DATA_DTR_DISABLE;
-	sCommand.DummyCycles           = MX25R6435F_DUMMY_CYCLES_READ_QUAD;
-	sCommand.DQSMode               = HAL_OSPI_DQS_DISABLE;
-	sCommand.SIOOMode              = HAL_OSPI_SIOO_INST_EVERY_CMD;
+	/* Configure the command for the read instruction, the memory-mapped mode always goes through the HAL */
+	OSPI_CmdFill(OSPI_CMD_QUAD_INOUT_READ, 0, 0, &sCommand);
+	sCommand.OperationType = HAL_OSPI_OPTYPE_READ_CFG;
 
 	/* Configure the command */
 	if (HAL_OSPI_Command(handle, &sCommand, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
@@ -805,10 +717,8 @@ uint8_t BSP_OSPI_EnableMemoryMappedMode(OSPI_HandleTypeDef* handle)
 	}
 
 	/* Configure the command for the program instruction */
-	sCommand.OperationType      = HAL_OSPI_OPTYPE_WRITE_CFG;
-	sCommand.Instruction        = QUAD_PAGE_PROG_CMD;
-	sCommand.AlternateBytesMode = HAL_OSPI_ALTERNATE_BYTES_NONE;
-	sCommand.DummyCycles        = 0;
+	OSPI_CmdFill(OSPI_CMD_QUAD_PAGE_PROG, 0, 0, &sCommand);
+	sCommand.OperationType = HAL_OSPI_OPTYPE_WRITE_CFG;
 
 	/* Configure the command */
 	if (HAL_OSPI_Command(handle, &sCommand, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
@@ -838,33 +748,27 @@ uint8_t BSP_OSPI_SuspendErase(OSPI_HandleTypeDef* handle)
 	/* Check whether the device is busy (erase operation is in progress). */
 	if (BSP_OSPI_GetStatus(handle) == OSPI_BUSY)
 	{
-		OSPI_RegularCmdTypeDef sCommand;
-
-		/* Initialize the suspend command */
-		sCommand.OperationType      = HAL_OSPI_OPTYPE_COMMON_CFG;
-		sCommand.FlashId            = HAL_OSPI_FLASH_ID_1;
-		sCommand.Instruction        = PROG_ERASE_SUSPEND_CMD;
-		sCommand.InstructionMode    = HAL_OSPI_INSTRUCTION_1_LINE;
-		sCommand.InstructionSize    = HAL_OSPI_INSTRUCTION_8_BITS;
-		sCommand.InstructionDtrMode = HAL_OSPI_INSTRUCTION_DTR_DISABLE;
-		sCommand.AddressMode        = HAL_OSPI_ADDRESS_NONE;
-		sCommand.AlternateBytesMode = HAL_OSPI_ALTERNATE_BYTES_NONE;
-		sCommand.DataMode           = HAL_OSPI_DATA_NONE;
-		sCommand.DummyCycles        = 0;
-		sCommand.DQSMode            = HAL_OSPI_DQS_DISABLE;
-		sCommand.SIOOMode           = HAL_OSPI_SIOO_INST_EVERY_CMD;
-		/* Send the command */
-		if (HAL_OSPI_Command(handle, &sCommand, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+		/* Send the suspend command */
+		if (OSPI_IssueCmd(handle, OSPI_CMD_PROG_ERASE_SUSPEND, 0, 0) != OSPI_OK)
 		{
 			return OSPI_ERROR;
 		}
 
-		if (BSP_OSPI_GetStatus(handle) == OSPI_SUSPENDED)
+		/* WIP stays set for the suspend latency (tESL), ESB is only set after it */
+		if (OSPI_AutoPollingMemReady(handle, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != OSPI_OK)
 		{
-			return OSPI_OK;
+			return OSPI_ERROR;
 		}
 
-		return OSPI_ERROR;
+		/* The erase may also have ended during the latency */
+		switch (BSP_OSPI_GetStatus(handle))
+		{
+		case OSPI_SUSPENDED:
+		case OSPI_OK:
+			return OSPI_OK;
+		default:
+			return OSPI_ERROR;
+		}
 	}
 
 	return OSPI_OK;
@@ -880,24 +784,8 @@ uint8_t BSP_OSPI_ResumeErase(OSPI_HandleTypeDef* handle)
 	/* Check whether the device is in suspended state */
 	if (BSP_OSPI_GetStatus(handle) == OSPI_SUSPENDED)
 	{
-		OSPI_RegularCmdTypeDef sCommand;
-
-		/* Initialize the resume command */
-		sCommand.OperationType      = HAL_OSPI_OPTYPE_COMMON_CFG;
-		sCommand.FlashId            = HAL_OSPI_FLASH_ID_1;
-		sCommand.Instruction        = PROG_ERASE_RESUME_CMD;
-		sCommand.InstructionMode    = HAL_OSPI_INSTRUCTION_1_LINE;
-		sCommand.InstructionSize    = HAL_OSPI_INSTRUCTION_8_BITS;
-		sCommand.InstructionDtrMode = HAL_OSPI_INSTRUCTION_DTR_DISABLE;
-		sCommand.AddressMode        = HAL_OSPI_ADDRESS_NONE;
-		sCommand.AlternateBytesMode = HAL_OSPI_ALTERNATE_BYTES_NONE;
-		sCommand.DataMode           = HAL_OSPI_DATA_NONE;
-		sCommand.DummyCycles        = 0;
-		sCommand.DQSMode            = HAL_OSPI_DQS_DISABLE;
-		sCommand.SIOOMode           = HAL_OSPI_SIOO_INST_EVERY_CMD;
-
-		/* Send the command */
-		if (HAL_OSPI_Command(handle, &sCommand, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+		/* Send the resume command */
+		if (OSPI_IssueCmd(handle, OSPI_CMD_PROG_ERASE_RESUME, 0, 0) != OSPI_OK)
 		{
 			return OSPI_ERROR;
 		}
@@ -925,24 +813,8 @@ uint8_t BSP_OSPI_ResumeErase(OSPI_HandleTypeDef* handle)
   */
 uint8_t BSP_OSPI_EnterDeepPowerDown(OSPI_HandleTypeDef* handle)
 {
-	OSPI_RegularCmdTypeDef sCommand;
-
-	/* Initialize the deep power down command */
-	sCommand.OperationType      = HAL_OSPI_OPTYPE_COMMON_CFG;
-	sCommand.FlashId            = HAL_OSPI_FLASH_ID_1;
-	sCommand.Instruction        = DEEP_POWER_DOWN_CMD;
-	sCommand.InstructionMode    = HAL_OSPI_INSTRUCTION_1_LINE;
-	sCommand.InstructionSize    = HAL_OSPI_INSTRUCTION_8_BITS;
-	sCommand.InstructionDtrMode = HAL_OSPI_INSTRUCTION_DTR_DISABLE;
-	sCommand.AddressMode        = HAL_OSPI_ADDRESS_NONE;
-	sCommand.AlternateBytesMode = HAL_OSPI_ALTERNATE_BYTES_NONE;
-	sCommand.DataMode           = HAL_OSPI_DATA_NONE;
-	sCommand.DummyCycles        = 0;
-	sCommand.DQSMode            = HAL_OSPI_DQS_DISABLE;
-	sCommand.SIOOMode           = HAL_OSPI_SIOO_INST_EVERY_CMD;
-
-	/* Send the command */
-	if (HAL_OSPI_Command(handle, &sCommand, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+	/* Send the deep power down command */
+	if (OSPI_IssueCmd(handle, OSPI_CMD_DEEP_POWER_DOWN, 0, 0) != OSPI_OK)
 	{
 		return OSPI_ERROR;
 	}
@@ -960,24 +832,8 @@ uint8_t BSP_OSPI_EnterDeepPowerDown(OSPI_HandleTypeDef* handle)
   */
 uint8_t BSP_OSPI_LeaveDeepPowerDown(OSPI_HandleTypeDef* handle)
 {
-	OSPI_RegularCmdTypeDef sCommand;
-
-	/* Initialize the erase command */
-	sCommand.OperationType      = HAL_OSPI_OPTYPE_COMMON_CFG;
-	sCommand.FlashId            = HAL_OSPI_FLASH_ID_1;
-	sCommand.Instruction        = NO_OPERATION_CMD;
-	sCommand.InstructionMode    = HAL_OSPI_INSTRUCTION_1_LINE;
-	sCommand.InstructionSize    = HAL_OSPI_INSTRUCTION_8_BITS;
-	sCommand.InstructionDtrMode = HAL_OSPI_INSTRUCTION_DTR_DISABLE;
-	sCommand.AddressMode        = HAL_OSPI_ADDRESS_NONE;
-	sCommand.AlternateBytesMode = HAL_OSPI_ALTERNATE_BYTES_NONE;
-	sCommand.DataMode           = HAL_OSPI_DATA_NONE;
-	sCommand.DummyCycles        = 0;
-	sCommand.DQSMode            = HAL_OSPI_DQS_DISABLE;
-	sCommand.SIOOMode           = HAL_OSPI_SIOO_INST_EVERY_CMD;
-
-	/* Send the command */
-	if (HAL_OSPI_Command(handle, &sCommand, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+	/* Send the no operation command */
+	if (OSPI_IssueCmd(handle, OSPI_CMD_NO_OPERATION, 0, 0) != OSPI_OK)
 	{
 		return OSPI_ERROR;
 	}
@@ -11,6 +11,14 @@
 #define OSPI_NOT_SUPPORTED ((uint8_t)0x04)
 #define OSPI_SUSPENDED     ((uint8_t)0x08)
 
+/* when set to 1 the indirect commands are issued by writing the OctoSPI CCR/TCR/IR/AR
+ * registers from the driver command table, skipping the HAL_OSPI_Command parameter checks.
+ * Set it to 0 to go through HAL_OSPI_Command.
+ */
+#ifndef MX25R6435F_DIRECT_CMD
+#define MX25R6435F_DIRECT_CMD 1
+#endif
+
 /* OSPI Info */
 typedef struct
 {